@@ -0,0 +1,112 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file analysis.h
+ * @brief non-interactive structure analysis of a list of solutions of a configuration
+ *
+ * Each solution is analysed with all the filters of the configuration checker (see config_checker.h)
+ * at once, without prompt: line degree types of the whole invalid configuration, lines and types
+ * through the points of each degree, degree of each observable, and symmetric lines. The solutions
+ * are analysed in parallel, the records being written afterwards in JSON Lines or CSV.
+ */
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stdio.h>
+
+#include "config_checker.h"
+
+/*number of solutions analysed in parallel before their records are written*/
+#define ANALYSIS_BLOCK_SIZE 1024
+
+typedef enum {
+    ANALYSIS_JSON,
+    ANALYSIS_CSV
+} analysis_format;
+
+/**
+ * @brief structure of the invalid configuration of one solution
+ *
+ * @param solution line of the solution in the input file (from 1)
+ * @param valid false if the solution code could not be parsed (the other fields being empty)
+ * @param invalid_lines number of invalid lines (Hamming distance of the solution)
+ * @param vertices number of points of the invalid configuration
+ * @param max_degree highest degree of a point
+ * @param degree_counts number of points of each degree, from 0 to max_degree
+ * @param line_types line degree types of the invalid configuration (filter ALL)
+ * @param degree_lines number of invalid lines through a point of each degree (filter POINT DEGREE)
+ * @param degree_types number of line types of these lines
+ * @param points points of the invalid configuration
+ * @param point_degrees degree of each of these points
+ * @param point_lines number of invalid lines through each of these points (filter OBSERVABLE VALUE)
+ * @param point_types number of line types of these lines
+ * @param symmetric_lines number of invalid lines made of symmetric points (filter SYMMETRIC)
+ * @param symmetric_types number of line types of these lines
+ */
+typedef struct {
+    size_t solution;
+    bool valid;
+    int invalid_lines;
+    int vertices;
+    int max_degree;
+    int *degree_counts;
+    line_categories line_types;
+    int *degree_lines;
+    int *degree_types;
+    bv *points;
+    int *point_degrees;
+    int *point_lines;
+    int *point_types;
+    int symmetric_lines;
+    int symmetric_types;
+} analysis_record;
+
+/**
+ * @brief analyses the invalid configuration of a solution (thread safe, nothing is printed)
+ *
+ * @param qa the negativity of its lines being computed
+ * @param bool_sol
+ * @return analysis_record to be freed by analysis_record_free
+ */
+analysis_record analysis_record_compute(const quantum_assignment *qa, const bool *bool_sol);
+
+/**
+ * @brief writes a record as one JSON object on a line
+ *
+ * @param qa
+ * @param record
+ * @param output
+ */
+void analysis_record_to_json(const quantum_assignment *qa, const analysis_record *record, FILE *output);
+
+/**
+ * @brief writes a record as a CSV row (see analysis_csv_header for the columns, lists being
+ * separated by semicolons)
+ *
+ * @param record
+ * @param output
+ */
+void analysis_record_to_csv(const analysis_record *record, FILE *output);
+
+void analysis_csv_header(FILE *output);
+
+void analysis_record_free(analysis_record *record);
+
+/**
+ * @brief analyses all the solutions of a file (one solution code per line, as written by print_bool,
+ * empty lines and lines starting with # being skipped) by blocks of ANALYSIS_BLOCK_SIZE solutions
+ *
+ * @param qa
+ * @param solutions
+ * @param output
+ * @param format
+ * @return size_t number of records written
+ */
+size_t analysis_run(quantum_assignment *qa, FILE *solutions, FILE *output, analysis_format format);
+
+#endif //ANALYSIS_H
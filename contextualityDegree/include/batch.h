@@ -0,0 +1,207 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file batch.h
+ * @brief non-interactive solving of the configurations listed in a manifest (batch mode)
+ *
+ * Each line of a manifest is a job: a name, the source of a configuration and its arguments,
+ * then optional solver settings, separated by spaces (empty lines and lines starting with #
+ * being skipped):
+ *
+ *     NAME assignment FILE
+ *     NAME binary FILE
+ *     NAME gram FILE
+ *     NAME hypergram HYPERGRAPH GRAM
+ *     NAME subspaces N_QUBITS K [sample=COUNT]
+ *     NAME quadric N_QUBITS OBSERVABLE [complement]
+ *     NAME perpset N_QUBITS OBSERVABLE [complement]
+ *     NAME lines N_QUBITS INDEX,INDEX,...
+ *
+ * followed by any of solver=sat|heuristic, iterations=N, threshold=F, flip=F, stop-regular=D,
+ * time=SECONDS (the command line settings being the default ones, the time budget applying to
+ * the heuristic method only). The lines of n qubits are generated once for all the jobs built on
+ * them, a lines job being the sub-configuration of the lines of the given indices (from 1, in the
+ * order of generate_total_lines).
+ *
+ * The jobs are loaded and solved by the threads taking them one after the other from the
+ * manifest; as in family mode (see family.h), the configurations of at least
+ * FAMILY_NESTED_MIN_CONTEXTS contexts are set aside and solved afterwards one at a time, each
+ * solver using all the threads. A result line (JSON Lines or CSV) is written as soon as a job
+ * is done.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+#include "family.h"
+
+/*highest number of qubits of the configurations made of lines*/
+#define BATCH_MAX_LINE_QUBITS 8
+
+typedef enum {
+    BATCH_JSON,
+    BATCH_CSV
+} batch_format;
+
+typedef enum {
+    BATCH_SOURCE_ASSIGNMENT,
+    BATCH_SOURCE_BINARY,
+    BATCH_SOURCE_GRAM,
+    BATCH_SOURCE_HYPERGRAM,
+    BATCH_SOURCE_SUBSPACES,
+    BATCH_SOURCE_QUADRIC,
+    BATCH_SOURCE_PERPSET,
+    BATCH_SOURCE_LINES
+} batch_source;
+
+/**
+ * @brief a line of a manifest
+ *
+ * @param line line of the manifest (from 1)
+ * @param name name of the job
+ * @param error NULL, or the reason why the line could not be read
+ * @param source kind of configuration
+ * @param paths files of an imported configuration
+ * @param n_qubits number of qubits of a generated configuration
+ * @param dimension dimension of the subspaces
+ * @param sample number of subspaces drawn uniformly (0: all of them)
+ * @param observable base of a quadric or perpset
+ * @param complement the complement of the quadric or perpset is solved
+ * @param indices lines of a lines job
+ * @param cpt_indices
+ * @param options solver settings of the job
+ */
+typedef struct {
+    size_t line;
+    char *name;
+    const char *error;
+    batch_source source;
+    char *paths[2];
+    int n_qubits;
+    int dimension;
+    size_t sample;
+    bv observable;
+    bool complement;
+    size_t *indices;
+    size_t cpt_indices;
+    solver_options options;
+} batch_job;
+
+typedef struct {
+    batch_job *jobs;
+    size_t cpt_jobs;
+    size_t capacity;
+} batch_manifest;
+
+/**
+ * @brief result of a job
+ *
+ * @param error NULL, or the reason why the job failed
+ * @param n_qubits
+ * @param contexts number of contexts
+ * @param negative_contexts number of negative contexts
+ * @param degree contextuality degree found
+ * @param time loading and solving time in seconds
+ * @param solution NULL, or the code of the best solution (see solution_code_to_chars), only
+ * written in JSON
+ */
+typedef struct {
+    const char *error;
+    int n_qubits;
+    size_t contexts;
+    int negative_contexts;
+    int degree;
+    double time;
+    const char *solution;
+} batch_result;
+
+/*all the lines of n qubits (and their indices by point), shared by the jobs made of lines*/
+typedef struct {
+    quantum_assignment lines_qa[BATCH_MAX_LINE_QUBITS + 1];
+    size_t **lines_indices[BATCH_MAX_LINE_QUBITS + 1];
+} batch_lines;
+
+/**
+ * @brief reads a line of a manifest (modified by the call)
+ *
+ * @param line
+ * @param defaults solver settings of the job if the line does not change them
+ * @param job (output) its error is set if the line is invalid
+ * @return false if the line is empty or a comment
+ */
+bool batch_job_parse(char *line, const solver_options *defaults, batch_job *job);
+
+/**
+ * @brief reads all the jobs of a manifest, the invalid lines being kept as failed jobs
+ *
+ * @param manifest
+ * @param defaults
+ * @return batch_manifest to be freed by batch_manifest_free
+ */
+batch_manifest batch_manifest_parse(FILE *manifest, const solver_options *defaults);
+
+void batch_job_free(batch_job *job);
+
+void batch_manifest_free(batch_manifest *manifest);
+
+/**
+ * @brief generates the lines of a job made of lines, if they are not generated yet (thread-safe)
+ *
+ * @param job
+ * @param lines
+ */
+void batch_lines_require(const batch_job *job, batch_lines *lines);
+
+void batch_lines_free(batch_lines *lines);
+
+/**
+ * @brief loads or generates the configuration of a job, its lines being already generated
+ *
+ * @param job
+ * @param lines
+ * @param result (output) size of the configuration, or its error on failure
+ * @return quantum_assignment to be freed by batch_job_unload
+ */
+quantum_assignment batch_job_load(const batch_job *job, batch_lines *lines, batch_result *result);
+
+void batch_job_unload(const batch_job *job, quantum_assignment *qa);
+
+/**
+ * @brief writes a result as one JSON object on a line
+ *
+ * @param job
+ * @param result
+ * @param output
+ */
+void batch_result_to_json(const batch_job *job, const batch_result *result, FILE *output);
+
+/**
+ * @brief writes a result as a CSV row (see batch_csv_header for the columns)
+ *
+ * @param job
+ * @param result
+ * @param output
+ */
+void batch_result_to_csv(const batch_job *job, const batch_result *result, FILE *output);
+
+void batch_csv_header(FILE *output);
+
+/**
+ * @brief solves all the jobs of a manifest, writing the result of each one when it is done
+ * (the lines are thus in completion order, and each one gives the line of its job). Once SIGINT
+ * is received, the jobs not yet solved are written with the error "interrupted"
+ *
+ * @param manifest
+ * @param output
+ * @param format
+ * @return size_t number of results written
+ */
+size_t batch_run(batch_manifest *manifest, FILE *output, batch_format format);
+
+#endif //BATCH_H
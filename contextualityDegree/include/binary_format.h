@@ -0,0 +1,171 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file binary_format.h
+ * @brief binary containers for Gram matrices, hypergraphs and quantum assignments
+ *
+ * A binary file is a binary_header followed by rows rows of row_words 64-bit words,
+ * in the byte order of the machine that wrote it:
+ * - a Gram matrix stores the rows of its bit_matrix as they are in memory
+ *   (row 0 and column 0 included, see parse_gram_matrix), so that it can be mapped
+ *   straight into the row storage of a bit_matrix;
+ * - a hypergraph stores the geometries of a hypergram, one context per row, each
+ *   ended by 0 (see parse_geometries);
+ * - a quantum assignment (compact, see quantum_assignment_compact) has rows contexts of
+ *   cols point ids (32-bit, 0 being I), row_words words per context. The contexts follow a
+ *   binary_assignment_info, the observables of the points (bv packed two per word, or
+ *   WIDE_BV_WORDS(n_qubits) words beyond BV_MAX_QUBITS qubits), and are followed by the
+ *   negativity of the contexts (BIT_SIZE(rows) words), then by the optional blocks: a
+ *   solution (BIT_SIZE(points) words) and a binary_assignment_stats. Every part is in the
+ *   layout of the quantum_assignment in memory, so that a loaded assignment points into
+ *   the mapped file.
+ */
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "bit_vector.h"
+#include "quantum_assignment.h"
+
+#define BINARY_MAGIC "QONTXBIN"
+#define BINARY_VERSION 1
+
+typedef enum {
+    BINARY_GRAM = 1,
+    BINARY_HYPERGRAPH = 2,
+    BINARY_ASSIGNMENT = 3
+} binary_kind;
+
+/**
+ * @brief header of a binary file (48 bytes, so that the rows are aligned on 64-bit words)
+ */
+typedef struct {
+    char magic[8];      /*BINARY_MAGIC, without the final '\0'*/
+    uint32_t version;   /*BINARY_VERSION*/
+    uint32_t kind;      /*binary_kind*/
+    uint64_t rows;
+    uint64_t cols;      /*bits per row of a Gram matrix, points per context (0 included) of a hypergraph*/
+    uint64_t row_words; /*64-bit words per row*/
+    uint64_t points;    /*number of points of a hypergraph (0 for a Gram matrix)*/
+} binary_header;
+
+/*optional blocks of a binary assignment*/
+#define BINARY_BLOCK_SOLUTION 1
+#define BINARY_BLOCK_STATS 2
+
+/**
+ * @brief description of a binary assignment, right after its header (8 bytes)
+ */
+typedef struct {
+    uint32_t n_qubits;
+    uint32_t blocks;    /*BINARY_BLOCK_* flags*/
+} binary_assignment_info;
+
+/**
+ * @brief statistics of the solution stored with a binary assignment
+ */
+typedef struct {
+    uint64_t negative_lines;
+    uint64_t invalid_lines; /*Hamming distance of the solution*/
+    uint64_t vertices;      /*number of points of its invalid configuration*/
+    uint64_t max_degree;    /*highest degree of these points*/
+} binary_assignment_stats;
+
+/**
+ * @brief checks if a file starts with a binary header of the given kind, the file
+ * being rewound in any case
+ *
+ * @param f
+ * @param kind
+ * @return true
+ * @return false if the file is a text file (or a binary of another kind)
+ */
+bool binary_file_is(FILE *f, binary_kind kind);
+
+/**
+ * @brief loads a binary Gram matrix by mapping the file, the rows of the bit_matrix
+ * pointing into the (private) mapping; bit_matrix_free unmaps it
+ *
+ * @param f binary Gram file
+ * @return bit_matrix or (bit_matrix){0} if the file is not valid
+ */
+bit_matrix binary_gram_load(FILE *f);
+
+/**
+ * @brief writes a bit_matrix in a binary Gram file
+ *
+ * @param bm
+ * @param f
+ * @return true on success
+ */
+bool binary_gram_save(bit_matrix bm, FILE *f);
+
+/**
+ * @brief loads a binary hypergraph (one read for all the contexts)
+ *
+ * @param f binary hypergraph file
+ * @param cpt_geometries (output) number of contexts
+ * @param points_per_geometry (output) maximum number of points of a context
+ * @param cpt_points (output) number of points
+ * @return size_t** the contexts ended by 0 (freed by free_matrix), NULL if the file is not valid
+ */
+size_t **binary_hypergraph_load(FILE *f, size_t *cpt_geometries, size_t *points_per_geometry, size_t *cpt_points);
+
+/**
+ * @brief writes the contexts of a hypergram in a binary hypergraph file
+ *
+ * @param geometries contexts ended by 0, points_per_geometry + 1 entries each
+ * @param cpt_geometries
+ * @param points_per_geometry
+ * @param cpt_points
+ * @param f
+ * @return true on success
+ */
+bool binary_hypergraph_save(size_t **geometries, size_t cpt_geometries, size_t points_per_geometry, size_t cpt_points, FILE *f);
+
+/**
+ * @brief loads a binary assignment by mapping the file: the contexts, the observables and the
+ * negativity of the assignment point into the (private) mapping, which is unmapped by
+ * quantum_assignment_free_geometries. The observables, the point ids and the negativity of the
+ * contexts (against the product of their observables) are checked
+ *
+ * @param f binary assignment file
+ * @param bool_sol (output, can be NULL) the stored solution (quantum_assignment_n_points entries,
+ * to be freed), NULL if the file has none
+ * @param stats (output, can be NULL) the stored statistics, all 0 if the file has none
+ * @return quantum_assignment or (quantum_assignment){0} if the file is not valid
+ */
+quantum_assignment binary_assignment_load(FILE *f, bool **bool_sol, binary_assignment_stats *stats);
+
+/**
+ * @brief writes a quantum assignment in a binary assignment file (the contexts of an assignment
+ * that is not compact being copied and compacted, its geometry array being left unchanged)
+ *
+ * @param qa
+ * @param bool_sol solution written with its statistics, or NULL (only for a compact assignment,
+ * whose point ids index the solution)
+ * @param f
+ * @return true on success
+ */
+bool binary_assignment_save(quantum_assignment *qa, const bool *bool_sol, FILE *f);
+
+/**
+ * @brief converts a text Gram matrix, hypergraph (the formats of ./misc) or quantum assignment
+ * (see quantum_assignment_parse) into a binary file
+ *
+ * @param kind
+ * @param input text file
+ * @param output binary file
+ * @return true on success
+ */
+bool binary_convert(binary_kind kind, FILE *input, FILE *output);
+
+#endif //BINARY_FORMAT_H
@@ -0,0 +1,158 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file bit_kernels.h
+ * @brief word kernels of the bit sets (popcount, logical operations, scans), with
+ * AVX2 and AVX-512 versions selected at runtime from the cpuid of the processor
+ *
+ * The kernels work on arrays of 64-bit words. The best version supported by the processor
+ * is selected before main, the scalar one being used on other architectures. The
+ * results do not depend on the selected version. Arrays of at most BIT_KERNELS_INLINE_WORDS
+ * words (less than a vector register) are processed by inline word loops, without the indirect
+ * call of the dispatch.
+ */
+#ifndef BIT_KERNELS_H
+#define BIT_KERNELS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*largest number of words processed inline (one AVX2 register)*/
+#define BIT_KERNELS_INLINE_WORDS 4
+
+typedef enum {
+    BIT_KERNELS_SCALAR,
+    BIT_KERNELS_AVX2,
+    BIT_KERNELS_AVX512
+} bit_kernels_level;
+
+/**
+ * @brief table of the kernels of one level
+ */
+typedef struct {
+    const char *name;
+    size_t (*popcount)(const uint64_t *a, size_t words);
+    size_t (*xor_popcount)(const uint64_t *a, const uint64_t *b, size_t words);
+    void (*and_words)(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words);
+    void (*or_words)(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words);
+    void (*xor_words)(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words);
+    void (*andnot_words)(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words);
+    bool (*any)(const uint64_t *a, size_t words);
+} bit_kernels_table;
+
+/*kernels in use*/
+extern bit_kernels_table bit_kernels;
+
+/**
+ * @brief selects the kernels of a level (the best supported one is selected at startup)
+ *
+ * @param level
+ * @return true if the processor supports the level
+ * @return false otherwise (the kernels in use are not changed)
+ */
+bool bit_kernels_select(bit_kernels_level level);
+
+/**
+ * @brief number of set bits of a
+ */
+static inline size_t bit_kernel_popcount(const uint64_t *a, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        size_t count = 0;
+        for (size_t w = 0; w < words; w++)count += __builtin_popcountll(a[w]);
+        return count;
+    }
+    return bit_kernels.popcount(a, words);
+}
+
+/**
+ * @brief number of set bits of a ^ b (the Hamming distance of a and b)
+ */
+static inline size_t bit_kernel_xor_popcount(const uint64_t *a, const uint64_t *b, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        size_t count = 0;
+        for (size_t w = 0; w < words; w++)count += __builtin_popcountll(a[w] ^ b[w]);
+        return count;
+    }
+    return bit_kernels.xor_popcount(a, b, words);
+}
+
+/**
+ * @brief res = a & b (res can be a or b)
+ */
+static inline void bit_kernel_and(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        for (size_t w = 0; w < words; w++)res[w] = a[w] & b[w];
+        return;
+    }
+    bit_kernels.and_words(res, a, b, words);
+}
+
+/**
+ * @brief res = a | b (res can be a or b)
+ */
+static inline void bit_kernel_or(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        for (size_t w = 0; w < words; w++)res[w] = a[w] | b[w];
+        return;
+    }
+    bit_kernels.or_words(res, a, b, words);
+}
+
+/**
+ * @brief res = a ^ b (res can be a or b)
+ */
+static inline void bit_kernel_xor(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        for (size_t w = 0; w < words; w++)res[w] = a[w] ^ b[w];
+        return;
+    }
+    bit_kernels.xor_words(res, a, b, words);
+}
+
+/**
+ * @brief res = a & ~b (res can be a or b)
+ */
+static inline void bit_kernel_andnot(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        for (size_t w = 0; w < words; w++)res[w] = a[w] & ~b[w];
+        return;
+    }
+    bit_kernels.andnot_words(res, a, b, words);
+}
+
+/**
+ * @brief true iff a bit of a is set
+ */
+static inline bool bit_kernel_any(const uint64_t *a, size_t words){
+    if (words <= BIT_KERNELS_INLINE_WORDS){
+        for (size_t w = 0; w < words; w++)if (a[w] != 0)return true;
+        return false;
+    }
+    return bit_kernels.any(a, words);
+}
+
+/**
+ * @brief true iff no bit of a is set
+ */
+static inline bool bit_kernel_none(const uint64_t *a, size_t words){
+    return !bit_kernel_any(a, words);
+}
+
+/**
+ * @brief index of the highest set bit of a
+ *
+ * @return long the index or -1 if no bit is set
+ */
+static inline long bit_kernel_last_set(const uint64_t *a, size_t words){
+    /*a single word is tested per step, the set bit being found in the first non zero word from the top*/
+    for (size_t w = words; w-- > 0;)if (a[w] != 0)return (long)(w * 64 + 63 - __builtin_clzll(a[w]));
+    return -1;
+}
+
+#endif //BIT_KERNELS_H
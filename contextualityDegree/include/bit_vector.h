@@ -36,12 +36,16 @@ typedef struct {
  * @param bit_sets Array of bit sets
  * @param size Number of bit sets (number of rows)
  * @param bits Array of bit set data
+ * @param mapping NULL if the rows are allocated, else the memory mapped file holding them (see binary_format.h)
+ * @param mapping_size size of the mapping in bytes
  */
 typedef struct
 {
     bit_vector *bit_sets;
     size_t size;
     bit_set_type **bits;
+    void *mapping;
+    size_t mapping_size;
 } bit_matrix;
 
 /**
@@ -189,12 +193,15 @@ void bit_matrix_print(bit_matrix bm);
  */
 bool bit_matrix_equals(bit_matrix bm1, bit_matrix bm2);
 
+/**
+ * @brief Product of two bit matrices over GF(2) (see gf2_multiply)
+ */
 bit_matrix bit_matrix_product(bit_matrix bm1, bit_matrix bm2);
 
 bool bit_matrix_is_empty(bit_matrix bm);
 
 /**
- * @brief Frees the memory allocated for a bit matrix
+ * @brief Frees the memory allocated for a bit matrix (or unmaps its file)
  * 
  * @param bm Bit matrix to free
  */
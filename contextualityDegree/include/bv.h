@@ -207,6 +207,19 @@ bv set_gate_custom(bv bv1,bv obs,int index,int n_qubits);
  */
 bv set_gate(bv bv1,bv obs,int index);
 
+/*letter of each 1-qubit observable, indexed by its binary representation*/
+extern const char GATE_CHARS[4];
+
+/**
+ * @brief writes the letters of an observable into a buffer (without '\0')
+ * 
+ * @param bv1 
+ * @param n_qubits 
+ * @param buffer at least n_qubits characters
+ * @return size_t number of characters written (n_qubits)
+ */
+size_t bv_to_chars(bv bv1,int n_qubits,char* buffer);
+
 /**
  * @brief Prints a bitvector in the standard output (used to write files)
  * 
@@ -29,6 +29,7 @@
 
 #include "quadrics.h"
 #include "config_checker.h"
+#include "symplectic.h"
 
 #define NB_LINES_CAYLEY_HEXAGON 63
 #define N_QUBITS_HEX 3
@@ -46,6 +47,53 @@
 bv epsilon(bv bv1);
 
 
+/**
+ * @brief reentrant generator of the embeddings of the split Cayley hexagon: a breadth-first
+ * walk of their orbit under the transvections, which can be consumed by several threads
+ * 
+ * @param orbit walk of the orbit of the sets of lines of the embeddings
+ */
+typedef struct
+{
+    symplectic_orbit_iterator orbit;
+} cayley_hexagon_iterator;
+
+/**
+ * @brief starts the generation of the classical or skew embeddings
+ * 
+ * @param it 
+ * @param lines_qa list of all the three qubit lines
+ * @param skew true for the 7560 skew embeddings, false for the 120 classical ones
+ * @return true 
+ * @return false if the lines are not the three qubit ones
+ */
+bool cayley_hexagon_iterator_init(cayley_hexagon_iterator* it,quantum_assignment lines_qa,bool skew);
+
+/**
+ * @brief allocates the assignments filled by cayley_hexagon_iterator_next (one pair per consumer thread)
+ * 
+ * /!\ The geometry indices need to be freed after use
+ * 
+ * @param lines_qa list of all the three qubit lines
+ * @param qa (output) cayley hexagon
+ * @param complement_qa (output) complement of the cayley hexagon
+ */
+void cayley_hexagon_assignments_init(quantum_assignment lines_qa,quantum_assignment *qa,quantum_assignment *complement_qa);
+
+/**
+ * @brief gets the next embedding (thread safe)
+ * 
+ * @param it 
+ * @param qa cayley hexagon generated
+ * @param complement_qa complement of the cayley hexagon generated
+ * @param index (output, can be NULL) rank of the embedding in the generation
+ * @return true if there is a next hexagon
+ * @return false when all hexagons have been generated
+ */
+bool cayley_hexagon_iterator_next(cayley_hexagon_iterator* it,quantum_assignment *qa,quantum_assignment *complement_qa,size_t* index);
+
+void cayley_hexagon_iterator_free(cayley_hexagon_iterator* it);
+
 /**
  * @brief computes the next classical embeddings of the split cayley hexagon of order 2
  * 
@@ -28,6 +28,7 @@ SYMMETRIC
 #define CONFIG_CHECKER
 
 #include "quantum_assignment.h"
+#include "hashset.h"
 
 #define CONFIG_CHECKER_STR_BUFFER_SIZE 4096
 
@@ -41,6 +42,46 @@ typedef enum
     MODE_SYMMETRIC
 } mode;
 
+/**
+ * @brief types of lines, a type being the sorted degrees of the points of a line
+ * @param types the sorted degrees of each type (one word per point), the id of a type being its rank of appearance
+ * @param counts number of lines of each type
+ * @param capacity number of counts allocated
+ * @param points_per_geometry
+ */
+typedef struct {
+    hash_set types;
+    int *counts;
+    size_t capacity;
+    size_t points_per_geometry;
+} line_categories;
+
+/**
+ * @brief statistics of the invalid configuration of a classical assignment (the invalid lines
+ * and their points)
+ *
+ * The invalid lines and the degrees of the points are updated with each flip. The histogram of
+ * the degrees and the number of vertices are derived from the degrees by invalid_stats_refresh,
+ * in one pass over the points instead of one over the lines: counting them on each flip would
+ * slow down the inner loop of the heuristic solver.
+ * @param n_points
+ * @param cpt_geometries
+ * @param max_degree maximum number of lines through a point
+ * @param invalid_lines true for each invalid line
+ * @param degrees number of invalid lines through each point (the identity padding of the lines being ignored)
+ * @param degree_counts number of points of each degree, from 0 to max_degree (after a refresh)
+ * @param vertices number of points of the invalid configuration, of non zero degree (after a refresh)
+ */
+typedef struct {
+    size_t n_points;
+    size_t cpt_geometries;
+    int max_degree;
+    bool *invalid_lines;
+    int *degrees;
+    int *degree_counts;
+    int vertices;
+} invalid_stats;
+
 bool mode_nothing_filter(quantum_assignment qa,int i,int* param,int* sorted_tab);
 bool mode_all_filter(quantum_assignment qa,int i,int* param,int* sorted_tab);
 bool mode_point_degree_filter(quantum_assignment qa,int i,int* param,int* sorted_tab);
@@ -52,28 +93,85 @@ extern bool (*mode_filters[])(quantum_assignment,int,int*,int*);
 
 void swap(int *a, int *b);
 
-void compute_invalid_lines(quantum_assignment qa, bool *bool_sol, bool **invalid_lines, int **number_of_invalid_lines);
+/**
+ * @brief computes the statistics of the invalid configuration of a solution
+ *
+ * @param qa the negativity of its lines being computed
+ * @param bool_sol
+ * @return invalid_stats refreshed statistics
+ */
+invalid_stats invalid_stats_init(const quantum_assignment *qa, const bool *bool_sol);
 
 /**
- * @brief internal function to find the index of a line in a table
+ * @brief adds adder (+1 or -1) to the degree of a point
  *
- * @param table
- * @param line
- * @param capacity
- * @return int
+ * @return int the new degree of the point
  */
-int get_table_index(int **table, int *line, size_t nb_points_per_line);
+static inline int invalid_stats_add_degree(invalid_stats *stats, bv point, int adder){
+    return stats->degrees[point] += adder;
+}
 
-int compare_integers_increasing(const void *a, const void *b);
+/**
+ * @brief marks a line as valid or invalid (the degrees of its points being updated separately)
+ */
+static inline void invalid_stats_set_line(invalid_stats *stats, size_t line_index, bool invalid){
+    stats->invalid_lines[line_index] = invalid;
+}
+
+/**
+ * @brief updates the statistics when a line changes of validity (after the flip of one of its points)
+ *
+ * @param stats
+ * @param qa
+ * @param line_index
+ */
+void invalid_stats_flip_line(invalid_stats *stats, const quantum_assignment *qa, size_t line_index);
 
 /**
- * @brief Counts the complexity degree of a set of
- * categories based on the provided category_list and category_count, iterating
- * through configurations up to CONFIG_MAX_DEG. If to_print is true, it outputs
- * the category details and their counts, using data from the quantum_assignment
- * structure to determine the number of points per geometry.
+ * @brief recomputes the histogram of the degrees and the number of vertices from the degrees
+ *
+ * @param stats
+ */
+void invalid_stats_refresh(invalid_stats *stats);
+
+/**
+ * @brief true iff the invalid configuration is not empty and all its points have the given degree
+ * (e.g. 3 for a split Cayley hexagon of order two), in constant time after a refresh
+ *
+ * @param stats
+ * @param degree
  */
-void print_category_list(int **category_list, int *category_count, quantum_assignment qa);
+bool invalid_stats_is_regular(const invalid_stats *stats, int degree);
+
+void invalid_stats_free(invalid_stats *stats);
+
+/**
+ * @brief creates an empty set of line types
+ *
+ * @param points_per_geometry
+ * @return line_categories
+ */
+line_categories line_categories_init(size_t points_per_geometry);
+
+/**
+ * @brief counts a line in its type, the type being created if needed
+ *
+ * @param categories
+ * @param degrees sorted degrees of the points of the line
+ * @return size_t id of the type
+ */
+size_t line_categories_add(line_categories *categories, const int *degrees);
+
+/**
+ * @brief prints the types of lines and their number of lines, in order of appearance
+ *
+ * @param categories
+ */
+void line_categories_print(const line_categories *categories);
+
+void line_categories_free(line_categories *categories);
+
+int compare_integers_increasing(const void *a, const void *b);
 
 mode ask_mode(quantum_assignment qa, int *param);
 
@@ -88,10 +186,23 @@ void set_order(quantum_assignment qa, int *obs_specific_type_degree,int index,in
  * @return int the complexity degree of the filtered lines(number of different types of invalid lines
  * in terms of their degrees)
  */
-int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *number_of_invalid_lines, mode m, int *param, bool *line_filter, int **obs_specific_type_degree,int** category_count, int ***category_list);
+int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *number_of_invalid_lines, mode m, int *param, bool *line_filter, int **obs_specific_type_degree,line_categories *categories);
+
+/**
+ * @brief Checks the geometric structure of an invalid configuration from its statistics
+ * (the invalid lines not being recomputed)
+ *
+ * @param qa
+ * @param stats statistics of the solution, refreshed by the function
+ * @param to_print if true prints the results
+ * @param line_filter if not NULL, only checks the lines that are true in the filter
+ * @return int the number of different types of invalid lines
+ */
+int check_structure_stats(quantum_assignment* qa, invalid_stats *stats, bool to_print, bool *line_filter);
 
 /**
  * @brief Checks the geometric structure of the invalid lines of a quantum assignment
+ * (read only on qa once its negativity is computed, so that solver threads can call it on their own solutions)
  *
  * @param qa
  * @param bool_sol given solution
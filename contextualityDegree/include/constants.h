@@ -182,7 +182,7 @@ void implement_sigint();
  * @param dim1
  * @param dim2
  * @param size
- * @return void**
+ * @return void** the matrix (zeroed), NULL if it cannot be allocated
  */
 void** init_matrix(size_t dim1,size_t dim2,size_t size);
 
@@ -16,6 +16,8 @@
 #include "quantum_assignment.h"
 
 #define DISABLED_PARAMETER -1.0f
+#define DISABLED_INT_PARAMETER -1 // DISABLED_PARAMETER of the integer options
+#define NONCONTEXTUAL_CHECK_MAX_BITS (1UL << 30) // largest incidence matrix (contexts x points) solved before calling a solver
 
 typedef enum
 {
@@ -28,6 +30,57 @@ extern solver_mode global_solver_mode;
 extern size_t global_heuristic_iterations; //maximum number of iterations for the heuristic method
 extern float global_heuristic_flip_probability;  // probability of choosing a random assignment in the heuristic method
 extern float global_heuristic_threshold;    // threshold for the heuristic method
+extern int global_heuristic_stop_regular;   // degree of the regular invalid configurations stopping the heuristic method
+extern const char* global_cache_directory;  // directory of the results cache (see results_cache.h), NULL if disabled
+
+/**
+ * @brief settings of one solver call, so that concurrent calls (batch mode) can use different ones
+ * 
+ * @param mode method used to compute the contextuality degree
+ * @param heuristic_iterations maximum number of iterations of the heuristic method
+ * @param heuristic_flip_probability probability of choosing a random assignment in the heuristic method
+ * @param heuristic_threshold threshold of the heuristic method (DISABLED_PARAMETER: automatic)
+ * @param heuristic_stop_regular degree of the regular invalid configurations stopping the heuristic method
+ * (DISABLED_INT_PARAMETER: none)
+ * @param initial_solution if not NULL, the heuristic method starts from this solution instead of all zeros
+ * @param cache_directory if not NULL, the results are read from and written to this cache
+ * @param time_limit time budget of the heuristic method in seconds (DISABLED_PARAMETER: none)
+ * @param on_bound if not NULL, called by the heuristic method with the number of invalid contexts
+ * of each better solution found and the elapsed time, by the thread which found it (outside of any
+ * critical section, so that the calls of different threads may overlap and arrive out of order)
+ * @param on_bound_data last argument of on_bound
+ * @param proved (output) if not NULL, set to true if the degree returned is proved: 0, or given by a
+ * SAT search which ended on an unsatisfiable degree (neither interrupted nor failed)
+ */
+typedef struct
+{
+    solver_mode mode;
+    size_t heuristic_iterations;
+    float heuristic_flip_probability;
+    float heuristic_threshold;
+    int heuristic_stop_regular;
+    const bool* initial_solution;
+    const char* cache_directory;
+    double time_limit;
+    void (*on_bound)(int invalid_contexts, double time, void* data);
+    void* on_bound_data;
+    bool* proved;
+} solver_options;
+
+/**
+ * @brief name of a solver (sat, retrieve or heuristic)
+ * 
+ * @param mode 
+ * @return const char* 
+ */
+const char* solver_mode_name(solver_mode mode);
+
+/**
+ * @brief settings given by the global parameters (command line options)
+ * 
+ * @return solver_options 
+ */
+solver_options solver_options_global(void);
 
 
 /**
@@ -55,6 +108,27 @@ void print_bool(bool* arr,size_t size);
  */
 void parse_bool(bool* arr,size_t size);
 
+/**
+ * @brief parses a solution code written by print_bool (4 bits per letter, from 'a' to 'p')
+ * 
+ * @param code 
+ * @param arr (output) 
+ * @param size number of points
+ * @return true if the code is valid
+ * @return false otherwise
+ */
+bool parse_solution_code(const char* code,bool* arr,size_t size);
+
+/**
+ * @brief writes the code of a solution, as printed by print_bool (without '\n' nor '\0')
+ * 
+ * @param arr 
+ * @param size 
+ * @param buffer at least (size+3)/4 characters
+ * @return size_t number of characters written
+ */
+size_t solution_code_to_chars(const bool* arr,size_t size,char* buffer);
+
 
 /**
  * @brief returns the hamming distance between a quantum assignment and a given
@@ -118,6 +192,31 @@ int **compute_contexts_per_obs(quantum_assignment *qa, bool print_solution);
  */
 int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,bool print_solution,bool* ret_sol);
 
+/**
+ * @brief geometry_contextuality_degree_max_invalid_heuristics with its own settings instead of the
+ * global parameters (a regular invalid configuration only stops this search)
+ * 
+ * @param qa input quantum assignment
+ * @param print_solution 
+ * @param options 
+ * @param ret_sol best solution found
+ * @return int minimal hamming distance found
+ */
+int geometry_contextuality_degree_heuristics_options(quantum_assignment* qa,bool print_solution,const solver_options* options,bool* ret_sol);
+
+/**
+ * @brief Checks if the contextuality degree is 0, i.e. if the negativity of the contexts is
+ * the sum over GF(2) of values given to the points (gf2_solve on the incidence matrix)
+ * 
+ * The check is skipped (false is returned) when the incidence matrix would exceed NONCONTEXTUAL_CHECK_MAX_BITS
+ * 
+ * @param qa 
+ * @param bool_sol if not NULL and the degree is 0, a solution is stored in this array
+ * @return true if the degree is 0
+ * @return false if the configuration is contextual (or too large to be checked)
+ */
+bool noncontextual_solution(quantum_assignment* qa,bool* bool_sol);
+
 
 /**
  * @brief Returns the contextuality degree of a list of geometries
@@ -130,6 +229,7 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
  * @param contextuality_only if true doesn't compute the degree but only wether or not the geometry is contextual
  * @param print_solution if true prints the solution if one is found
  * @param optimistic enables a sat solver heuristic making it faster to find a solution IFF there is one
+ * @return the degree found (the best one so far if interrupted), -1 if the SAT solver could not be run
 */
 int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,bool* ret_sol);
 
@@ -146,6 +246,19 @@ int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_
  * @return int minimal hamming distance found
  */
 int geometry_contextuality_degree_custom(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,solver_mode mode,bool* bool_sol);
+
+/**
+ * @brief Returns the contextuality degree of a list of geometries with the given settings
+ * 
+ * @param qa 
+ * @param contextuality_only if true doesn't compute the degree but only wether or not the geometry is contextual(only for the SAT solver)
+ * @param print_solution if true prints the solution if one is found
+ * @param optimistic enables a sat solver heuristic making it faster to find a solution IFF there is one
+ * @param options method used to compute the contextuality degree and its parameters
+ * @param bool_sol if not NULL, the solution is stored in this array
+ * @return int minimal hamming distance found
+ */
+int geometry_contextuality_degree_options(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,const solver_options* options,bool* bool_sol);
 /**
  * @brief Returns the contextuality degree of a quantum assignment
  * 
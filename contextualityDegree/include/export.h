@@ -0,0 +1,128 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file export.h
+ * @brief exporters of the contexts of a quantum assignment (CSV, readable form, binary, solver instances)
+ *
+ * The contexts are formatted by blocks of EXPORT_BLOCK_CONTEXTS, each thread filling its own
+ * buffer, and the blocks are written in order with one fwrite each. Observables are written
+ * with the letter table GATE_CHARS, and signs are read from the negativity cache of the
+ * assignment (computed once if needed).
+ *
+ * The solver instances (XCNF, WCNF, OPB, CP-SAT) share one numbering of their variables, from 1:
+ * the point p is the variable p (I being left out), the indicator of the context i (true if it is
+ * invalid) is the variable n_points + i, and the auxiliary variables of an encoding come after.
+ * Minimizing the number of true indicators gives the contextuality degree.
+ */
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdio.h>
+
+#include "quantum_assignment.h"
+
+/*number of contexts formatted in one buffer before being written*/
+#define EXPORT_BLOCK_CONTEXTS 4096
+/*size of the buffer of a thread, fewer contexts being formatted at once when they are long*/
+#define EXPORT_BUFFER_SIZE (1 << 22)
+
+typedef enum {
+    EXPORT_FORMAT_CSV,
+    EXPORT_FORMAT_BINARY,
+    EXPORT_FORMAT_XCNF,
+    EXPORT_FORMAT_WCNF,
+    EXPORT_FORMAT_OPB,
+    EXPORT_FORMAT_CPSAT
+} export_format;
+
+/**
+ * @brief reads the name of an export format (csv, binary, xcnf, wcnf, opb or cpsat)
+ *
+ * @param name
+ * @param format (output)
+ * @return true if the name is known
+ */
+bool export_format_parse(const char *name, export_format *format);
+
+/**
+ * @brief writes the contexts as one line of observables separated by commas each
+ * (see quantum_assignment_parse)
+ *
+ * @param qa
+ * @param output
+ */
+void export_csv(quantum_assignment *qa, FILE *output);
+
+/**
+ * @brief writes the contexts as [observable][observable]... followed by their sign (+ or -)
+ *
+ * @param qa
+ * @param output
+ */
+void export_readable(quantum_assignment *qa, FILE *output);
+
+/**
+ * @brief writes the parity constraints of the contexts in the XCNF format (DIMACS CNF with
+ * XOR clauses, as read by CryptoMiniSat): the variable p is the value of the point p, and the
+ * XOR clause of a context is satisfied iff the context is valid. The instance is satisfiable
+ * iff the configuration has contextuality degree 0.
+ *
+ * With a bound k > 0, the XOR clause of each context also has its indicator, and a sequential
+ * counter (Sinz, 2005) of (n-1)k auxiliary variables allows at most k true indicators: the
+ * instance is satisfiable iff the contextuality degree is at most k.
+ *
+ * @param qa
+ * @param bound maximum number of invalid contexts, 0 for none
+ * @param output
+ */
+void export_xcnf(quantum_assignment *qa, size_t bound, FILE *output);
+
+/**
+ * @brief writes a weighted partial MaxSAT instance (WCNF, with the top weight in the header):
+ * the hard clauses encode the parity of each context with its indicator, long XOR constraints
+ * being split by auxiliary variables (Tseitin), and the soft clause of weight 1 of a context
+ * asks for its indicator to be false. The optimum cost is the contextuality degree.
+ *
+ * @param qa
+ * @param output
+ */
+void export_wcnf(quantum_assignment *qa, FILE *output);
+
+/**
+ * @brief writes a pseudo-Boolean optimization instance (OPB): the parity of each context is
+ * the linear equality sum(points) + indicator - 2 sum(2^b y_b) = sign, with auxiliary variables
+ * y_b, and the objective is the sum of the indicators.
+ *
+ * @param qa
+ * @param output
+ */
+void export_opb(quantum_assignment *qa, FILE *output);
+
+/**
+ * @brief writes a CP-SAT model (CpModelProto in protobuf text format, as read by OR-Tools):
+ * one bool_xor constraint per context over its points and its indicator, minimizing the sum
+ * of the indicators. CP-SAT variables being indexed from 0, the variable v of the other
+ * formats is v-1 here.
+ *
+ * @param qa
+ * @param output
+ */
+void export_cpsat(quantum_assignment *qa, FILE *output);
+
+/**
+ * @brief writes the contexts in the given format (see binary_assignment_save for the binary one)
+ *
+ * @param qa
+ * @param format
+ * @param bound maximum number of invalid contexts of an XCNF instance (see export_xcnf)
+ * @param output
+ * @return true on success
+ */
+bool export_quantum_assignment(quantum_assignment *qa, export_format format, size_t bound, FILE *output);
+
+#endif //EXPORT_H
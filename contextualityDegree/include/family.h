@@ -0,0 +1,122 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file family.h
+ * @brief non-interactive computation of the contextuality degrees of a whole family of
+ * configurations (all quadrics, perpsets, hexagons...), spread over all the cores
+ */
+#ifndef FAMILY_H
+#define FAMILY_H
+
+#include "quantum_assignment.h"
+#include "contextuality_degree.h"
+
+#include <stdio.h>
+
+/*configurations with at least this number of contexts are solved one at a time, each
+solver using all its threads, the smaller ones are solved concurrently by single-threaded solvers*/
+#define FAMILY_NESTED_MIN_CONTEXTS 20000
+
+/**
+ * @brief configurations sharing the same geometries (typically all the lines of n qubits)
+ * 
+ * @param configurations configurations of the family
+ * @param ids identifier of each configuration (base observable for quadrics and perpsets, rank for hexagons)
+ * @param multiplicities number of configurations isomorphic to each one (NULL if the family was not reduced to orbits)
+ * @param cpt_configurations number of configurations
+ * @param capacity allocated size of the arrays
+ */
+typedef struct
+{
+    quantum_assignment* configurations;
+    size_t* ids;
+    size_t* multiplicities;
+    size_t cpt_configurations;
+    size_t capacity;
+} configuration_family;
+
+/**
+ * @brief a row of the results table of a family
+ * 
+ * @param id identifier of the configuration
+ * @param contexts number of contexts
+ * @param negative_contexts number of negative contexts
+ * @param degree contextuality degree found (-1 if not computed)
+ * @param multiplicity number of configurations of the family isomorphic to this one
+ * @param time computation time in seconds
+ */
+typedef struct
+{
+    size_t id;
+    size_t multiplicity;
+    size_t contexts;
+    int negative_contexts;
+    int degree;
+    double time;
+} family_result;
+
+/**
+ * @brief adds a configuration to a family, which takes ownership of its indices and signs
+ * 
+ * @param family 
+ * @param id identifier of the configuration
+ * @param qa 
+ */
+void family_add(configuration_family* family,size_t id,quantum_assignment qa);
+
+/**
+ * @brief adds a copy of a configuration to a family (for iterators reusing their buffers)
+ * 
+ * @param family 
+ * @param id identifier of the configuration
+ * @param qa 
+ */
+void family_add_copy(configuration_family* family,size_t id,quantum_assignment* qa);
+
+/**
+ * @brief keeps one configuration per orbit under Sp(2n,2) (they share the same
+ * contextuality degree) and records the size of each orbit in the family
+ * 
+ * @param family configurations made of lines
+ * @param lines_qa all the lines of n qubits
+ * @return size_t number of orbits
+ */
+size_t family_reduce_to_orbits(configuration_family* family,quantum_assignment lines_qa);
+
+/**
+ * @brief computes the contextuality degree of every configuration of a family
+ * 
+ * The configurations smaller than FAMILY_NESTED_MIN_CONTEXTS are spread over the
+ * threads with one single-threaded solver each, then the bigger ones are solved
+ * one after the other with the solver's own parallelism.
+ * 
+ * /!\ The result array needs to be freed after use
+ * 
+ * @param family 
+ * @param mode solver used (the retrieve mode is not supported)
+ * @return family_result* one result per configuration, in the order of the family (NULL on error)
+ */
+family_result* family_contextuality_degrees(configuration_family* family,solver_mode mode);
+
+/**
+ * @brief writes the results table of a family in the CSV format
+ * 
+ * @param results 
+ * @param cpt_results 
+ * @param output 
+ */
+void family_results_to_csv(family_result* results,size_t cpt_results,FILE* output);
+
+/**
+ * @brief frees the configurations of a family (but not their shared geometries)
+ * 
+ * @param family 
+ */
+void family_free(configuration_family* family);
+
+#endif
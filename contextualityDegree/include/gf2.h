@@ -0,0 +1,91 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file gf2.h
+ * @brief linear algebra over GF(2) on bit matrices (the bit j of the row i being the entry (i,j))
+ *
+ * Products and eliminations use the Method of Four Russians: GF2_M4R_BITS rows are combined
+ * in a table of all their sums, and each row is then updated by a single table lookup
+ * per group of GF2_M4R_BITS columns. The rows are updated in parallel with OpenMP.
+ */
+#ifndef GF2_H
+#define GF2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bit_vector.h"
+
+/*number of rows combined in the tables of the Method of Four Russians*/
+#define GF2_M4R_BITS 8
+
+/**
+ * @brief creates a zero matrix whose rows are aligned on cache lines (freed by bit_matrix_free)
+ *
+ * @param rows
+ * @param cols
+ * @return bit_matrix
+ */
+bit_matrix gf2_matrix_create(size_t rows, size_t cols);
+
+/**
+ * @brief transposes a matrix by blocks of 64x64 bits
+ *
+ * @param m
+ * @return bit_matrix the transpose (cols x rows)
+ */
+bit_matrix gf2_transpose(bit_matrix m);
+
+/**
+ * @brief product of two matrices
+ *
+ * @param a rows x n
+ * @param b n x cols
+ * @return bit_matrix rows x cols, or (bit_matrix){0} (NULL bits) if the sizes do not match or
+ * the product cannot be allocated
+ */
+bit_matrix gf2_multiply(bit_matrix a, bit_matrix b);
+
+/**
+ * @brief row echelon form, in place
+ *
+ * @param m
+ * @param reduced if true, the pivot columns are also cleared above the pivots
+ * @param pivots (output, can be NULL) the pivot column of each of the first rank rows
+ * @return size_t the rank of the matrix
+ */
+size_t gf2_echelon(bit_matrix m, bool reduced, size_t *pivots);
+
+/**
+ * @brief rank of a matrix (not modified)
+ *
+ * @param m
+ * @return size_t
+ */
+size_t gf2_rank(bit_matrix m);
+
+/**
+ * @brief basis of the right kernel {x : m.x = 0}
+ *
+ * @param m rows x cols
+ * @return bit_matrix one basis vector of cols bits per row (cols - rank rows, possibly none)
+ */
+bit_matrix gf2_nullspace(bit_matrix m);
+
+/**
+ * @brief solves the affine system m.x = b
+ *
+ * @param m rows x cols
+ * @param b BIT_SIZE(rows) words
+ * @param x (output) BIT_SIZE(cols) words, a solution (the free variables being 0)
+ * @return true if the system has a solution
+ * @return false otherwise
+ */
+bool gf2_solve(bit_matrix m, const bit_set_type *b, bit_set_type *x);
+
+#endif //GF2_H
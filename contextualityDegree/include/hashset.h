@@ -27,18 +27,81 @@ typedef uint64_t hash_set_store_type;
  * thus the object used for this purpose is composed of 4 64-bit integers
  */
 typedef struct {hash_set_store_type v[ELT_SIZE];} hash_set_bitset;
+#define HASH_SET_NOT_FOUND ((size_t)-1)
+
+/**
+ * @brief growable open-addressing set of fixed-width keys, with stable ids
+ * (the keys are stored in insertion order, their id being their rank)
+ * 
+ * @param key_words width of the keys (in 64-bit words)
+ * @param keys the keys, stored one after the other
+ * @param cpt_keys number of keys
+ * @param capacity_keys number of keys allocated
+ * @param slots id+1 of the key stored in each slot, 0 if the slot is empty (linear probing)
+ * @param n_slots number of slots, a power of 2 kept at least twice the number of keys
+ */
 typedef struct {
-    hash_set_bitset *list;
-    size_t size;
-    size_t max;
+    size_t key_words;
+    hash_set_store_type *keys;
+    size_t cpt_keys;
+    size_t capacity_keys;
+    size_t *slots;
+    size_t n_slots;
 }hash_set;
 
 /**
- * @brief initializes the hashset of permutations
+ * @brief 64-bit hash of a key (each word goes through the murmur3 finalizer)
+ * 
+ * @param key 
+ * @param key_words 
+ * @return uint64_t 
+ */
+uint64_t hash_words(const hash_set_store_type* key,size_t key_words);
+
+/**
+ * @brief initializes the hashset of permutations (keys of ELT_SIZE words)
  * 
  */
 hash_set hash_set_init();
 
+/**
+ * @brief initializes an empty hash set
+ * 
+ * @param key_words width of the keys (in 64-bit words)
+ * @return hash_set 
+ */
+hash_set hash_set_init_custom(size_t key_words);
+
+/**
+ * @brief looks for a key (read only, several threads can search at the same time)
+ * 
+ * @param set 
+ * @param key 
+ * @return size_t id of the key, HASH_SET_NOT_FOUND if absent
+ */
+size_t hash_set_find(const hash_set* set,const hash_set_store_type* key);
+
+/**
+ * @brief looks for a key and inserts it if absent
+ * 
+ * @param set 
+ * @param key 
+ * @param added (output, can be NULL) true iff the key was inserted
+ * @return size_t id of the key
+ */
+size_t hash_set_find_or_add(hash_set* set,const hash_set_store_type* key,bool* added);
+
+/**
+ * @brief gets a key from its id
+ * 
+ * /!\ The pointer is invalidated by the next insertion
+ * 
+ * @param set 
+ * @param id 
+ * @return const hash_set_store_type* 
+ */
+const hash_set_store_type* hash_set_key(const hash_set* set,size_t id);
+
 /**
  * @brief returns true iff a permutation is empty
  * 
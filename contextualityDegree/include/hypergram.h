@@ -31,6 +31,7 @@ typedef struct hypergram {
     bit_matrix commutation_matrix;
     bv* assignment;
     size_t n_qubits;
+    wide_word* wide_assignment;/*assignment beyond BV_MAX_QUBITS qubits (WIDE_BV_WORDS(n_qubits) words per point), assignment being NULL*/
 } hypergram;
 
 /**
@@ -72,6 +73,8 @@ bool is_hypergram_valid(hypergram ccs);
  * 101
  * 110
  * 
+ * A binary Gram file (see binary_format.h) is detected and mapped instead
+ * 
  * @param f 
  * @return bit_matrix 
  */
@@ -87,6 +90,8 @@ bit_matrix parse_gram_matrix(FILE *f);
  * 
  * no zero allowed
  * 
+ * A binary hypergraph file (see binary_format.h) is detected and read at once instead
+ * 
  * @param f 
  * @return CCS 
  */
@@ -152,27 +157,29 @@ hypergram quantum_assignment_to_hypergram(quantum_assignment qa);
 
 
 /**
- * @brief Finds a set bit in a gram matrix
+ * @brief Symplectic Gram-Schmidt: finds observables whose anticommutations are given by a gram matrix
  * 
- * @param bm Bit matrix
- * @param pivot_i (output) index of the row of the first set bit
- * @param pivot_j (output) index of the column of the first set bit
+ * While the residual anticommutation matrix (the gram matrix minus the anticommutations of the
+ * qubits already built) has a set bit (i,j), a qubit is added where i gets a Z, j a X, and every
+ * point anticommuting with i (resp. j) a X (resp. Z). The residual rows are updated by XOR of whole
+ * words, so each qubit costs O(V^2/64). The number of qubits is rank/2, the minimum for this matrix.
  * 
- * @return true if a set bit was found, false otherwise
+ * @param gram_matrix symmetric gram matrix
+ * @param n_qubits (output) number of qubits
+ * @return wide_word* observable of each row (WIDE_BV_WORDS(n_qubits) words each, qubit t on the bit t of each half)
  */
-bool gram_matrix_find_set_bit(bit_matrix bm, bv *assignment, int n_qubits, size_t *pivot_i, size_t *pivot_j);
-
+wide_word *symplectic_gram_schmidt(bit_matrix gram_matrix, size_t *n_qubits);
 
 /**
  * @brief Finds the assignment of a CCS from its independent gram matrix
  * by following the algorithm described in the paper
  * 
- * Contrary to the paper, instead of using a mutable matrix alone, we use a static matrix 
- * and the assignment to keep track of the anticommutations
+ * The anticommutations left to explain are kept in a residual matrix updated
+ * by whole words (see symplectic_gram_schmidt)
  * 
  * @param gram_matrix Independent gram matrix
  * @param assignment (output) Assignment
- * @return int Number of qubits
+ * @return int Number of qubits, -1 if more than BV_MAX_QUBITS are needed (see symplectic_gram_schmidt)
  */
 int pauli_assignment_from_anticommutations(bit_matrix gram_matrix, bv *assignment);
 
@@ -183,6 +190,14 @@ int pauli_assignment_from_anticommutations(bit_matrix gram_matrix, bv *assignmen
  */
 void hypergram_compute_assignment(hypergram *ccs);
 
+/**
+ * @brief Prints the observable assigned to a point
+ * 
+ * @param ccs Hypergram with an assignment
+ * @param point 
+ */
+void hypergram_print_point(hypergram ccs, size_t point);
+
 /**
  * @brief Transforms a hypergram into a quantum assignment
  */
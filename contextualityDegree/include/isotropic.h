@@ -0,0 +1,94 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file isotropic.h
+ * @brief bijection between the totally isotropic subspaces of dimension m of the
+ * n-qubit symplectic space and the integers 0..N(n,m)-1
+ * 
+ * With p the Z coordinate and f the X coordinate of the last qubit (<p,f> = 1) and W
+ * the symplectic space of the n-1 other qubits, a subspace S is in one of three cases:
+ *  - (a) p in S: S = <p> + S' with S' isotropic of dimension m-1 in W, N(n-1,m-1) subspaces
+ *  - (b) S in p^perp, p not in S: S is the graph of a linear form on its projection
+ *        (dimension m in W), 2^m N(n-1,m) subspaces
+ *  - (c) S not in p^perp: S = S0 + <f + a.p + w>, with the projection of S0 of dimension m-1
+ *        in W and w reduced modulo this projection, 2^(2n-m) N(n-1,m-1) subspaces
+ * The ranks of the three cases are consecutive, the bases being handled in reduced row echelon form.
+ */
+#ifndef ISOTROPIC_H
+#define ISOTROPIC_H
+
+#include "bv.h"
+#include "quantum_assignment.h"
+
+/**
+ * @brief counts the totally isotropic subspaces of dimension m of n qubits
+ * 
+ * @param n_qubits 
+ * @param dim dimension m of the subspaces (k+1 for projective dimension k)
+ * @return uint64_t 
+ */
+uint64_t isotropic_count(int n_qubits,int dim);
+
+/**
+ * @brief computes a basis of the subspace of a given rank
+ * 
+ * @param n_qubits 
+ * @param dim dimension m of the subspace
+ * @param rank integer smaller than isotropic_count(n_qubits,dim)
+ * @param basis (output) array of dim observables
+ */
+void isotropic_unrank(int n_qubits,int dim,uint64_t rank,bv* basis);
+
+/**
+ * @brief computes the rank of a subspace (inverse of isotropic_unrank)
+ * 
+ * @param n_qubits 
+ * @param dim dimension m of the subspace
+ * @param basis any basis of the subspace (dim independent observables)
+ * @return uint64_t 
+ */
+uint64_t isotropic_rank(int n_qubits,int dim,const bv* basis);
+
+/**
+ * @brief lists the 2^dim-1 points of a subspace in the layout of subspaces():
+ * the i-th point (from 1) is the sum of the generators selected by the bits of i,
+ * the generators being greedily chosen as the smallest points outside the previous ones' span
+ * 
+ * @param dim 
+ * @param basis any basis of the subspace
+ * @param row (output) array of 2^dim-1 observables
+ */
+void isotropic_points(int dim,const bv* basis,bv* row);
+
+/**
+ * @brief generates the subspaces of ranks first..first+count-1, the rows being
+ * computed independently of each other by all the threads
+ * 
+ * /!\ The geometries need to be freed after use
+ * 
+ * @param n_qubits 
+ * @param k projective dimension of the subspaces
+ * @param first first rank
+ * @param count number of subspaces (truncated to the number of subspaces)
+ * @return quantum_assignment 
+ */
+quantum_assignment isotropic_subspaces_range(int n_qubits,int k,uint64_t first,uint64_t count);
+
+/**
+ * @brief samples subspaces uniformly at random (with repetitions)
+ * 
+ * /!\ The geometries need to be freed after use
+ * 
+ * @param n_qubits 
+ * @param k projective dimension of the subspaces
+ * @param count number of subspaces to draw
+ * @return quantum_assignment 
+ */
+quantum_assignment isotropic_subspaces_sample(int n_qubits,int k,size_t count);
+
+#endif
@@ -70,6 +70,44 @@ void insert_line_index(bv obs, size_t index,size_t** lines_indices,int n_qubits)
  * @param n_qubits number of qubits of the geometry
 */
 quantum_assignment generate_total_lines(size_t*** lines_indices,int n_qubits);
+
+#define LINE_TABLE_DENSE_MAX_QUBITS 5 /*above, the pair table would not fit in the caches (33MB for 6 qubits)*/
+
+/**
+ * @brief lookup of the line passing through two points
+ * 
+ * Up to LINE_TABLE_DENSE_MAX_QUBITS qubits, a dense triangular table gives the line of each pair
+ * of points, otherwise the line is binary searched in the lines (which generate_total_lines
+ * sorts lexicographically).
+ * 
+ * @param lines_qa all the lines, as generated by generate_total_lines
+ * @param pairs line index of the pair (a,b), a < b, at b(b-1)/2+a (NULL for the binary search)
+ */
+typedef struct
+{
+    quantum_assignment lines_qa;
+    uint32_t* pairs;
+} line_table;
+
+/**
+ * @brief builds the lookup of the lines of all the pairs of points
+ * 
+ * @param lines_qa all the lines, as generated by generate_total_lines
+ * @return line_table 
+ */
+line_table line_table_create(quantum_assignment lines_qa);
+
+/**
+ * @brief finds the line passing through two points
+ * 
+ * @param table 
+ * @param a 
+ * @param b 
+ * @return size_t index of the line, NO_LINE if the points are equal or do not commute
+ */
+size_t line_table_find(const line_table* table,bv a,bv b);
+
+void line_table_free(line_table* table);
 /**
  * @brief returns the index of the leftmost set bit, or -1 if it doesn't exist
  * 
@@ -83,9 +121,10 @@ int bv_left_most(bv obs);
 int bv_anti_cmp(const void * first, const void * second );
 /**
  * @brief computes the basis of a set of observables
- * using Gaussian elimination
+ * using Gaussian elimination (gf2_echelon), the basis being sorted in descending order
+ * with distinct leftmost bits
  * 
- * @param obss set of observables, will be sorted as an output
+ * @param obss set of observables
  * @param size number of observables
  * @param basis (output) the basis
  * 
@@ -137,10 +176,9 @@ quantum_assignment commuting(uint32_t size,int n_qubits);
  */
 void subspace_neg_lines_count(int n_qubits,int k,bv bv1[]);
 
-
-void subspaces_rec(int n_qubits,int k,int l,bv bv1[]);
 /**
- * @brief Generates all subspaces of a given dimension
+ * @brief Generates all subspaces of a given dimension, in the order of their ranks
+ * (see isotropic.h)
  * 
  * /!\ The geometries need to be freed after use
  * 
@@ -161,13 +199,52 @@ quantum_assignment affine_planes(quantum_assignment planes);
  * @param form function determining if a point belongs to a geometry
  * @param lines_indices array specifying for each point all the lines it belongs to
  * @param n_qubits number of qubits of the geometry
- * @param lines array of all the lines of n qubits
+ * @param lines_qa all the lines of n qubits, the resulting geometry inherits their negativity
  * 
  * @param lines_res array of all the lines of the resulting geometry
 */
-quantum_assignment zero_locus(bv obs, unsigned int (*form)(bv, bv, int),size_t** lines_indices,int n_qubits,bv** lines,size_t* lines_res,bool complement);
-quantum_assignment perpset(bv obs,size_t** lines_indices,int n_qubits,bv** lines,bool complement);
-quantum_assignment quadric(bv obs,size_t** lines_indices,int n_qubits,bv** lines,bool complement);
+quantum_assignment zero_locus(bv obs, unsigned int (*form)(bv, bv, int),size_t** lines_indices,int n_qubits,quantum_assignment lines_qa,size_t* lines_res,bool complement);
+quantum_assignment perpset(bv obs,size_t** lines_indices,int n_qubits,quantum_assignment lines_qa,bool complement);
+quantum_assignment quadric(bv obs,size_t** lines_indices,int n_qubits,quantum_assignment lines_qa,bool complement);
+
+#define ZERO_LOCUS_BLOCK_SIZE 64 /*number of base observables handled at once by zero_locus_block (one bit per base)*/
+
+typedef enum
+{
+    ZERO_LOCUS_QUADRIC,
+    ZERO_LOCUS_PERPSET
+} zero_locus_type;
+
+/**
+ * @brief computes the geometries of ZERO_LOCUS_BLOCK_SIZE consecutive base observables in one pass
+ * 
+ * The forms of the 64 bases are bit-sliced into one 64-bit word per point: the inner products
+ * are updated along a Gray code with a single XOR per point, and a line belongs to the geometry
+ * of the t-th base iff the t-th bit of the AND of the words of its 3 points is set.
+ * Quadrics are classified on the fly: Q_base is elliptic iff Q_0(base) = 1 (Arf invariant).
+ * 
+ * @param type quadrics or perpsets (same lines as zero_locus)
+ * @param first_base first base observable of the block
+ * @param complement if true, each row contains the complement of the geometry
+ * @param lines_qa all the lines of n qubits
+ * @param lines_indices array specifying for each point all the lines it belongs to
+ * @param block (output) bit matrix with ZERO_LOCUS_BLOCK_SIZE rows of NB_LINES_CUSTOM(n)+1 bits,
+ * the row t being the set of line indices of the geometry of the base first_base+t
+ * @param elliptic (output, can be NULL) for quadrics, true iff the quadric of the base first_base+t is elliptic
+ * @return int number of bases in the block (smaller than ZERO_LOCUS_BLOCK_SIZE for the last block)
+ */
+int zero_locus_block(zero_locus_type type,bv first_base,bool complement,quantum_assignment lines_qa,size_t** lines_indices,bit_matrix block,bool* elliptic);
+
+/**
+ * @brief builds the sub-configuration of the lines whose indices are set in a bit set
+ * 
+ * /!\ The geometry indices need to be freed after use
+ * 
+ * @param lines_qa all the lines (the result inherits their negativity)
+ * @param line_set bit set over the line indices
+ * @return quantum_assignment 
+ */
+quantum_assignment lines_subset(quantum_assignment lines_qa,bit_vector line_set);
 
 /**
  * @brief Generates a 2-spread by removing the given spread from the doily
@@ -16,6 +16,8 @@
 #define QUANTUM_ASSIGNMENT
 
 #include "bv.h"
+#include "bit_vector.h"
+#include "wide_bv.h"
 
 /**
  * @brief quantum assignment used to check contextuality
@@ -25,6 +27,11 @@
  * @param cpt_geometries number of geometries checked
  * @param points_per_geometry number of observables in each geometry
  * @param n_qubits number of qubits per observable
+ * @param lines_negativity negativity of each checked geometry (indexed like geometry_indices)
+ * @param geometries_negativity negativity of each row of the geometry array, shared by every
+ * assignment carved out of the same array (no bits if it has not been computed)
+ * @param mapping NULL if the geometries, observables and negativity are allocated, else the
+ * memory mapped binary file holding them (see binary_format.h)
  *
  */
 typedef struct
@@ -36,10 +43,70 @@ typedef struct
     int n_qubits;
 
     bool *lines_negativity;
+    bit_vector geometries_negativity;
+
+    bv *observables;
+    size_t n_observables;
+    wide_word *wide_observables;
+
+    void *mapping;
+    size_t mapping_size;
 } quantum_assignment;
 
 bool quantum_assignment_autofill_indices(quantum_assignment* qa);
 
+/**
+ * @brief Number of point ids of a quantum assignment: the size of the arrays indexed
+ * by its points (classical assignments, point degrees...)
+ * @param qa 
+ * @return size_t n_observables if the assignment is compact, 4^n_qubits otherwise
+ */
+size_t quantum_assignment_n_points(const quantum_assignment* qa);
+
+/**
+ * @brief Observable of a point of the geometries
+ * (only for assignments of at most BV_MAX_QUBITS qubits)
+ * @param qa 
+ * @param point point id if the assignment is compact, observable otherwise
+ * @return bv 
+ */
+bv quantum_assignment_observable(const quantum_assignment* qa,bv point);
+
+/**
+ * @brief Writes the letters of the observable of a point into a buffer (without '\0')
+ * @param qa 
+ * @param point 
+ * @param buffer at least n_qubits characters
+ * @return size_t number of characters written (n_qubits)
+ */
+size_t quantum_assignment_point_to_chars(const quantum_assignment* qa,bv point,char* buffer);
+
+/**
+ * @brief Prints the observable of a point of the geometries (whatever the number of qubits)
+ * @param qa 
+ * @param point 
+ * @param output 
+ */
+void quantum_assignment_print_point(const quantum_assignment* qa,bv point,FILE* output);
+
+/**
+ * @brief returns true iff the observable of a point has an even number of Y
+ * @param qa 
+ * @param point 
+ * @return true 
+ * @return false 
+ */
+bool quantum_assignment_point_is_symmetric(const quantum_assignment* qa,bv point);
+
+/**
+ * @brief Relabels the observables present in the geometries to the ids 1..V (by increasing
+ * observable, I keeping the id 0), so that the arrays indexed by points have V+1 entries
+ * instead of 4^n_qubits.
+ * The negativity is computed before relabeling, as it needs the observables
+ * @param qa assignment owning its geometry array
+ */
+void quantum_assignment_compact(quantum_assignment* qa);
+
 /**
  * @brief returns true if the product of all the observables is minus the identity,
  * and false if it is the identity matrix
@@ -55,7 +122,17 @@ bool is_negative_custom(bv geometry[], int size, int n_qubits, bool verbose, FIL
 bool is_negative(bv geometry[], int size, int n_qubits);
 
 /**
- * @brief Prints a quantum assignment
+ * @brief sign of the product of the observables of a row of the geometry array (nothing is printed)
+ *
+ * @param qa
+ * @param row
+ * @return int 1 if the product is minus the identity, 0 if it is the identity, -1 if it is not the
+ * identity up to a sign
+ */
+int quantum_assignment_geometry_sign(const quantum_assignment* qa,size_t row);
+
+/**
+ * @brief Prints a quantum assignment with the sign of each context (see export_readable)
  * 
  * @param qa 
  */
@@ -70,11 +147,10 @@ void print_quantum_assignment(quantum_assignment* qa);
 void quantum_assignment_to_CSV(quantum_assignment qa, FILE *output);
 
 /**
- * @brief writes clauses to a file to be read by ortools
- *
- * @param quantum_assignment
+ * @brief writes the contexts as a CP-SAT model to be read by ortools (see export_cpsat)
  *
- * @param points_per_geometry
+ * @param qa
+ * @param output
  */
 void quantum_assignment_to_ortools(quantum_assignment qa, FILE *output);
 
@@ -94,6 +170,33 @@ void quantum_assignment_print_to_file(quantum_assignment *qa, FILE *output);
  */
 bool quantum_assignment_compute_negativity(quantum_assignment* qa);
 
+/**
+ * @brief Computes once the negativity of every row of the geometry array,
+ * so that the sub-configurations using these rows inherit it by index
+ * 
+ * @param qa 
+ * @param cpt_rows number of rows of the geometry array
+ * @return true if the cache has been computed, false if it already existed
+ */
+bool quantum_assignment_compute_geometries_negativity(quantum_assignment* qa,size_t cpt_rows);
+
+/**
+ * @brief Shares the negativity cache of a parent assignment with one of its
+ * sub-configurations (both must use the same geometry array)
+ * 
+ * @param qa sub-configuration
+ * @param parent 
+ */
+void quantum_assignment_inherit_negativity(quantum_assignment* qa,quantum_assignment parent);
+
+/**
+ * @brief Recomputes the negativity of the contexts after their indices changed,
+ * by gathering it from the cache when there is one
+ * 
+ * @param qa 
+ */
+void quantum_assignment_refresh_negativity(quantum_assignment* qa);
+
 /**
  * @brief Conts the number of negative lines in a quantum assignment
  * 
@@ -113,12 +216,13 @@ int negative_lines_count(quantum_assignment* qa);
  */
 quantum_assignment quantum_assignment_from_invalid_contexts(quantum_assignment qa,bool* bool_sol,bool validity);
 
-
-// Function to determine the maximum number of columns
-void parse_matrix_dimensions(FILE *file, size_t *rows, size_t *cols);
-
 /**
- * @brief parses a file containing a quantum assignment
+ * @brief parses a file containing a quantum assignment (one context per line, observables
+ * separated by commas, lines of any length)
+ * 
+ * The file is mapped in memory when possible, split in chunks at line boundaries, and the
+ * chunks are parsed in parallel (sequentially beyond BV_MAX_QUBITS qubits, the points being
+ * numbered in order of appearance).
  * 
  * @param file 
  * @return quantum_assignment 
@@ -141,4 +245,12 @@ quantum_assignment quantum_assignment_merge(quantum_assignment qa1,quantum_assig
  */
 void free_quantum_assignment(quantum_assignment* qa);
 
+/**
+ * @brief frees the geometry array of a quantum assignment and its negativity cache
+ * (only for the assignment owning them, not for its sub-configurations)
+ * 
+ * @param qa 
+ */
+void quantum_assignment_free_geometries(quantum_assignment* qa);
+
 #endif //QUANTUM_ASSIGNMENT
\ No newline at end of file
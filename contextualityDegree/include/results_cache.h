@@ -0,0 +1,110 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file results_cache.h
+ * @brief on-disk cache of the contextuality degrees of configurations (--cache)
+ *
+ * A configuration is identified by a canonical key which does not depend on the order of its
+ * contexts, of the points in a context, nor on the numbering of its points: the points are
+ * ranked by observable, each context is hashed from the sorted ranks of its points and its
+ * sign, and the sorted hashes of the contexts are hashed with the sorted observables. The same
+ * quadric reached from another base observable, or a configuration imported again from another
+ * file, thus gets the same key.
+ *
+ * Each entry is a small text file of the cache directory, named after the key, holding the
+ * bounds of the degree, the best solution found (the print_bool code of the values of the
+ * points in canonical order) and the cumulated solver statistics. Entries are written to a
+ * temporary file then renamed, so that several threads or processes can share a directory.
+ */
+#ifndef RESULTS_CACHE_H
+#define RESULTS_CACHE_H
+
+#include "contextuality_degree.h"
+
+#define RESULTS_CACHE_VERSION 1
+
+/**
+ * @brief canonical key of a configuration
+ *
+ * @param hash two independent 64-bit hashes (of the contexts, and of the observables)
+ * @param points points of the configuration in canonical order (by observable)
+ * @param cpt_points number of points of the configuration (I excluded)
+ */
+typedef struct {
+    uint64_t hash[2];
+    bv *points;
+    size_t cpt_points;
+} results_cache_key;
+
+/**
+ * @brief an entry of the cache
+ *
+ * @param lower_bound proved lower bound of the contextuality degree
+ * @param upper_bound number of invalid contexts of the best solution found
+ * @param solver last solver which improved or confirmed the entry
+ * @param iterations cumulated heuristic iterations
+ * @param time cumulated solving time in seconds
+ */
+typedef struct {
+    int lower_bound;
+    int upper_bound;
+    solver_mode solver;
+    size_t iterations;
+    double time;
+} results_cache_entry;
+
+/**
+ * @brief computes the canonical key of a configuration
+ *
+ * @param qa
+ * @return results_cache_key to be freed by results_cache_key_free
+ */
+results_cache_key results_cache_key_compute(quantum_assignment *qa);
+
+void results_cache_key_free(results_cache_key *key);
+
+/**
+ * @brief reads the entry of a configuration
+ *
+ * @param directory
+ * @param key
+ * @param qa
+ * @param entry (output)
+ * @param bool_sol if not NULL, receives the cached solution (in the numbering of the points of qa)
+ * @return true if the configuration has a valid entry
+ */
+bool results_cache_load(const char *directory, const results_cache_key *key, quantum_assignment *qa, results_cache_entry *entry, bool *bool_sol);
+
+/**
+ * @brief writes (or replaces) the entry of a configuration
+ *
+ * @param directory
+ * @param key
+ * @param qa
+ * @param entry
+ * @param bool_sol best solution found, with entry->upper_bound invalid contexts
+ * @return true on success
+ */
+bool results_cache_store(const char *directory, const results_cache_key *key, quantum_assignment *qa, const results_cache_entry *entry, const bool *bool_sol);
+
+/**
+ * @brief contextuality degree through the cache of options->cache_directory: a proved entry
+ * (equal bounds) is returned without solving, a partial one is the initial solution of the
+ * heuristic, and the entry is updated with the bounds, the best solution and the statistics
+ * of the new search
+ *
+ * @param qa
+ * @param print_solution
+ * @param optimistic
+ * @param options
+ * @param bool_sol if not NULL, the best solution is stored in this array
+ * @return int best number of invalid contexts found (-1 if the solver failed)
+ */
+int results_cache_contextuality_degree(quantum_assignment *qa, bool print_solution, bool optimistic, const solver_options *options, bool *bool_sol);
+
+#endif //RESULTS_CACHE_H
@@ -0,0 +1,54 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file server.h
+ * @brief long-running server answering requests on a Unix domain socket (--serve)
+ *
+ * The lines of n qubits generated for a request stay in memory for all the following ones, so
+ * that quadrics, perpsets and sub-configurations of lines are solved without generating them
+ * again (the results cache, if enabled, being shared as well).
+ *
+ * A client sends one request per line, in the syntax of a batch manifest line (see batch.h), and
+ * receives JSON Lines: one {"status":"bound"} line with the number of invalid contexts of each
+ * better solution found by the heuristic method, then the result line of the request (as in
+ * batch mode, with the code of the best solution). The requests of a connection are answered in
+ * order; the requests of different connections are solved concurrently by a pool of threads, one
+ * thread per request, while another thread reads the connections. Besides the requests, a client
+ * can send:
+ *
+ *     status      one line with the number of threads, of requests served and the resident lines
+ *     quit        closes the connection
+ *     shutdown    stops the server once the current requests are answered
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "batch.h"
+
+/*maximum length of a request line, longer ones closing the connection*/
+#define SERVER_MAX_REQUEST (1 << 20)
+
+/*period (in milliseconds) at which the idle server checks whether it is stopped*/
+#define SERVER_POLL_PERIOD 200
+
+/*period (in milliseconds) at which the server checks whether a request is answered, so that
+the next request of its connection is read*/
+#define SERVER_BUSY_POLL_PERIOD 5
+
+/**
+ * @brief serves the clients of a Unix domain socket until a shutdown request or SIGINT (which
+ * also sets is_done, so that the requests being solved stop; the previous handler of SIGINT is
+ * restored at the end)
+ *
+ * @param socket_path path of the socket, replaced if it is an existing socket and removed at the end
+ * @param defaults solver settings of the requests which do not change them
+ * @return long number of requests answered, -1 if the socket could not be created
+ */
+long server_run(const char *socket_path, const solver_options *defaults);
+
+#endif //SERVER_H
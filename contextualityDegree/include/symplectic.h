@@ -0,0 +1,124 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file symplectic.h
+ * @brief action of the symplectic group Sp(2n,2) on configurations made of lines
+ * 
+ * The group is generated by the transvections T_p (see transvection in bv.h), which map
+ * lines to lines. A configuration is seen as the set of its line indices, and two
+ * configurations in the same orbit share the same contextuality degree.
+ */
+#ifndef SYMPLECTIC_H
+#define SYMPLECTIC_H
+
+#include "bv.h"
+#include "bit_vector.h"
+#include "quantum_assignment.h"
+#include "quadrics.h"
+#include "hashset.h"
+
+#include <omp.h>
+
+/**
+ * @brief breadth-first walk of the orbit of a set of lines, which can be shared by several threads
+ * 
+ * Only the newly discovered sets are expanded by the transvections, the queue being
+ * the insertion order of the visited sets.
+ * 
+ * @param visited sets of the orbit discovered so far
+ * @param permutations line permutations of the transvections T_p, p = 1..4^n-1
+ * @param n_generators number of transvections
+ * @param n_lines size of each permutation (NB_LINES_CUSTOM(n)+1)
+ * @param expanded number of visited sets whose images have been computed
+ * @param returned number of sets returned by the iterator
+ * @param lock protects the fields above
+ */
+typedef struct
+{
+    hash_set visited;
+    size_t* permutations;
+    size_t n_generators;
+    size_t n_lines;
+    size_t expanded;
+    size_t returned;
+    omp_lock_t lock;
+} symplectic_orbit_iterator;
+
+/**
+ * @brief computes the permutation of the line indices induced by the transvection T_p
+ * 
+ * @param p base observable of the transvection
+ * @param lines lookup of the lines of n qubits
+ * @param permutation (output) array of NB_LINES_CUSTOM(n)+1 line indices
+ */
+void transvection_line_permutation(bv p,const line_table* lines,size_t* permutation);
+
+/**
+ * @brief applies a permutation of the line indices to a set of lines
+ * 
+ * @param line_set 
+ * @param permutation 
+ * @param image (output) bit set of the same size as line_set
+ */
+void line_set_permute(bit_vector line_set,const size_t* permutation,bit_vector image);
+
+/**
+ * @brief starts the walk of the orbit of a set of lines under Sp(2n,2)
+ * 
+ * @param it 
+ * @param seed first set of the orbit
+ * @param lines_qa all the lines of n qubits
+ */
+void symplectic_orbit_iterator_init(symplectic_orbit_iterator* it,bit_vector seed,quantum_assignment lines_qa);
+
+/**
+ * @brief gets the next set of the orbit (thread safe)
+ * 
+ * @param it 
+ * @param line_set (output) bit set of the size of the seed
+ * @param index (output, can be NULL) position of the set in the walk
+ * @return true if a set was returned
+ * @return false when the whole orbit has been returned
+ */
+bool symplectic_orbit_iterator_next(symplectic_orbit_iterator* it,bit_vector line_set,size_t* index);
+
+/**
+ * @brief frees the walk of an orbit
+ * 
+ * @param it 
+ */
+void symplectic_orbit_iterator_free(symplectic_orbit_iterator* it);
+
+/**
+ * @brief computes the canonical form of a set of lines, i.e. the smallest set of its orbit
+ * under Sp(2n,2), by walking the whole orbit with the transvections
+ * 
+ * @param line_set set of line indices
+ * @param lines_qa all the lines of n qubits
+ * @param max_orbit_size the walk is abandoned beyond this number of configurations
+ * @param canonical (output) bit set of the same size as line_set
+ * @return size_t size of the orbit, 0 if it exceeds max_orbit_size
+ */
+size_t symplectic_canonical_form(bit_vector line_set,quantum_assignment lines_qa,size_t max_orbit_size,bit_vector canonical);
+
+/**
+ * @brief splits sets of lines into orbits under Sp(2n,2)
+ * 
+ * Two sets are merged when a transvection maps one onto the other: when the sets are
+ * closed under the group (all quadrics, all hexagons...), the classes are exactly the orbits.
+ * Otherwise they are finer than the orbits, but two sets of a class are always isomorphic.
+ * 
+ * @param line_sets sets of line indices, all of the same size
+ * @param cpt_line_sets 
+ * @param lines_qa all the lines of n qubits
+ * @param orbit_of (output) for each set, the index of the first set of its orbit
+ * @return size_t number of orbits
+ */
+size_t symplectic_orbits(bit_vector* line_sets,size_t cpt_line_sets,quantum_assignment lines_qa,size_t* orbit_of);
+
+#endif
@@ -0,0 +1,146 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file wide_bv.h
+ * @brief observables of any number of qubits, stored on several 64-bit words
+ *
+ * A wide observable is an array of WIDE_BV_WORDS(n) words: the Z half followed by the X half,
+ * each half being WIDE_BV_HALF_WORDS(n) words long. As in a bv, the i-th qubit (from the left)
+ * is the bit n-1-i of each half, so that a bv is a wide observable of one word per half.
+ * The number of words is chosen at runtime from the number of qubits, and the word loops
+ * are left to the compiler vectorization.
+ */
+#ifndef WIDE_BV_H
+#define WIDE_BV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "bv.h"
+
+/*largest number of qubits of a bv (a Z half and a X half in 32 bits)*/
+#define BV_MAX_QUBITS 16
+
+typedef uint64_t wide_word;
+
+#define WIDE_BV_HALF_WORDS(N) (((size_t)(N) + 63) / 64)
+#define WIDE_BV_WORDS(N) (2 * WIDE_BV_HALF_WORDS(N))
+
+/**
+ * @brief symplectic product of 2 observables
+ *
+ * @param w1
+ * @param w2
+ * @param n_qubits
+ * @return unsigned int
+ */
+unsigned int wide_bv_inner_product(const wide_word* w1,const wide_word* w2,int n_qubits);
+
+/**
+ * @brief quadratic form Q_base(w) = Q0(w) + <base,w>, Q0 counting the Y of w
+ *
+ * @param base
+ * @param w
+ * @param n_qubits
+ * @return unsigned int
+ */
+unsigned int wide_bv_quadratic_form(const wide_word* base,const wide_word* w,int n_qubits);
+
+/**
+ * @brief transvection T_p(q) = q + <p,q>p
+ *
+ * @param p
+ * @param q
+ * @param res (output, can be q)
+ * @param n_qubits
+ */
+void wide_bv_transvection(const wide_word* p,const wide_word* q,wide_word* res,int n_qubits);
+
+/**
+ * @brief returns true iff the observable has an even number of Y
+ *
+ * @param w
+ * @param n_qubits
+ * @return true
+ * @return false
+ */
+bool wide_bv_is_symmetric(const wide_word* w,int n_qubits);
+
+/**
+ * @brief gets the gate of the index-th qubit (from the left)
+ *
+ * @param w
+ * @param index
+ * @param n_qubits
+ * @return unsigned int I, X, Y or Z
+ */
+unsigned int wide_bv_get_gate(const wide_word* w,int index,int n_qubits);
+
+/**
+ * @brief sets the gate of the index-th qubit (from the left)
+ *
+ * @param w
+ * @param gate I, X, Y or Z
+ * @param index
+ * @param n_qubits
+ */
+void wide_bv_set_gate(wide_word* w,unsigned int gate,int index,int n_qubits);
+
+/**
+ * @brief converts a bv into a wide observable
+ *
+ * @param bv1
+ * @param n_qubits at most BV_MAX_QUBITS
+ * @param res (output) WIDE_BV_WORDS(n_qubits) words
+ */
+void wide_bv_from_bv(bv bv1,int n_qubits,wide_word* res);
+
+/**
+ * @brief parses an observable written with the letters I, X, Y and Z (stops at any other character)
+ *
+ * @param str
+ * @param n_qubits
+ * @param res (output) WIDE_BV_WORDS(n_qubits) words
+ * @return int number of letters read
+ */
+int wide_bv_parse(const char* str,int n_qubits,wide_word* res);
+
+/**
+ * @brief writes the letters of an observable into a buffer (without '\0')
+ *
+ * @param w
+ * @param n_qubits
+ * @param buffer at least n_qubits characters
+ * @return size_t number of characters written (n_qubits)
+ */
+size_t wide_bv_to_chars(const wide_word* w,int n_qubits,char* buffer);
+
+/**
+ * @brief prints an observable to a file (without brackets)
+ *
+ * @param w
+ * @param n_qubits
+ * @param output
+ */
+void wide_bv_print_to_file(const wide_word* w,int n_qubits,FILE* output);
+
+/**
+ * @brief sign of the product of the observables (the sign is accumulated qubitwise by word, as in
+ * the Aaronson-Gottesman tableau, instead of multiplying 2x2 matrices)
+ *
+ * @param observables pool of observables, WIDE_BV_WORDS(n_qubits) words each
+ * @param points indices in the pool of the observables of the product, the first 0 (I) ending it
+ * @param size maximum number of points
+ * @param n_qubits
+ * @return int 1 if the product is minus the identity, 0 if it is the identity, -1 if it is not
+ * the identity up to a sign (nothing is printed)
+ */
+int wide_bv_product_sign(const wide_word* observables,const bv* points,size_t size,int n_qubits);
+
+#endif //WIDE_BV_H
@@ -0,0 +1,221 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file analysis.c
+ * @brief non-interactive structure analysis of a list of solutions of a configuration
+ */
+#include "constants.h"
+#include "analysis.h"
+#include "contextuality_degree.h"
+
+/*runs a filter of the configuration checker, returns the number of filtered lines and their number of types*/
+static int analysis_filter(const quantum_assignment *qa, invalid_stats *stats, mode m, int *param, int *types){
+    int *specific_degrees = NULL;
+    line_categories categories;
+    *types = filter_lines(false, *qa, stats->invalid_lines, stats->degrees, m, param, NULL, &specific_degrees, &categories);
+
+    int lines = 0;
+    for (size_t i = 0; i < categories.types.cpt_keys; i++)lines += categories.counts[i];
+
+    line_categories_free(&categories);
+    free(specific_degrees);
+    return lines;
+}
+
+analysis_record analysis_record_compute(const quantum_assignment *qa, const bool *bool_sol){
+    invalid_stats stats = invalid_stats_init(qa, bool_sol);
+    analysis_record record = {
+        .valid = true,
+        .vertices = stats.vertices,
+        .degree_counts = calloc(stats.max_degree + 1, sizeof(int)),
+        .degree_lines = calloc(stats.max_degree + 1, sizeof(int)),
+        .degree_types = calloc(stats.max_degree + 1, sizeof(int)),
+        .points = malloc(MAX(stats.vertices, 1) * sizeof(bv)),
+        .point_degrees = malloc(MAX(stats.vertices, 1) * sizeof(int)),
+        .point_lines = malloc(MAX(stats.vertices, 1) * sizeof(int)),
+        .point_types = malloc(MAX(stats.vertices, 1) * sizeof(int))
+    };
+    for (size_t i = 0; i < qa->cpt_geometries; i++)record.invalid_lines += stats.invalid_lines[i];
+
+    /*filter ALL: the line degree types, kept for the record*/
+    int param[qa->points_per_geometry];
+    int *specific_degrees = NULL;
+    filter_lines(false, *qa, stats.invalid_lines, stats.degrees, MODE_ALL, param, NULL, &specific_degrees, &record.line_types);
+    free(specific_degrees);
+
+    /*filter POINT DEGREE, for each degree present in the configuration*/
+    for (int d = 0; d <= stats.max_degree; d++){
+        record.degree_counts[d] = stats.degree_counts[d];
+        if (d == 0 || stats.degree_counts[d] == 0)continue;
+        record.max_degree = d;
+        param[0] = d;
+        record.degree_lines[d] = analysis_filter(qa, &stats, MODE_POINT_DEGREE, param, &record.degree_types[d]);
+    }
+
+    /*filter OBSERVABLE VALUE, for each point of the configuration (wide observables are given by their point)*/
+    int cpt_points = 0;
+    for (bv p = 1; p < stats.n_points; p++){
+        if (stats.degrees[p] == 0)continue;
+        record.points[cpt_points] = p;
+        record.point_degrees[cpt_points] = stats.degrees[p];
+        param[0] = qa->wide_observables != NULL ? (int)p : (int)quantum_assignment_observable(qa, p);
+        record.point_lines[cpt_points] = analysis_filter(qa, &stats, MODE_OBSERVABLE_VALUE, param, &record.point_types[cpt_points]);
+        cpt_points++;
+    }
+
+    /*filter SYMMETRIC*/
+    record.symmetric_lines = analysis_filter(qa, &stats, MODE_SYMMETRIC, param, &record.symmetric_types);
+
+    invalid_stats_free(&stats);
+    return record;
+}
+
+void analysis_record_to_json(const quantum_assignment *qa, const analysis_record *record, FILE *output){
+    fprintf(output, "{\"solution\":%ld,\"valid\":%s", record->solution, record->valid ? "true" : "false");
+    if (!record->valid){
+        fprintf(output, "}\n");
+        return;
+    }
+    fprintf(output, ",\"invalid_lines\":%d,\"vertices\":%d,\"line_types\":%ld",
+            record->invalid_lines, record->vertices, record->line_types.types.cpt_keys);
+
+    fprintf(output, ",\"point_degrees\":[");
+    bool first = true;
+    for (int d = 1; d <= record->max_degree; d++){
+        if (record->degree_counts[d] == 0)continue;
+        fprintf(output, "%s{\"degree\":%d,\"points\":%d,\"lines\":%d,\"line_types\":%d}",
+                first ? "" : ",", d, record->degree_counts[d], record->degree_lines[d], record->degree_types[d]);
+        first = false;
+    }
+
+    fprintf(output, "],\"line_degree_types\":[");
+    for (size_t t = 0; t < record->line_types.types.cpt_keys; t++){
+        const hash_set_store_type *degrees = hash_set_key(&record->line_types.types, t);
+        fprintf(output, "%s{\"degrees\":[", t == 0 ? "" : ",");
+        for (size_t j = 0; j < record->line_types.points_per_geometry; j++)
+            fprintf(output, "%s%d", j == 0 ? "" : ",", (int)degrees[j]);
+        fprintf(output, "],\"lines\":%d}", record->line_types.counts[t]);
+    }
+
+    fprintf(output, "],\"observables\":[");
+    for (int i = 0; i < record->vertices; i++){
+        fprintf(output, "%s{\"observable\":\"", i == 0 ? "" : ",");
+        quantum_assignment_print_point(qa, record->points[i], output);
+        fprintf(output, "\",\"degree\":%d,\"lines\":%d,\"line_types\":%d}",
+                record->point_degrees[i], record->point_lines[i], record->point_types[i]);
+    }
+
+    fprintf(output, "],\"symmetric_lines\":%d,\"symmetric_line_types\":%d}\n", record->symmetric_lines, record->symmetric_types);
+}
+
+void analysis_csv_header(FILE *output){
+    fprintf(output, "solution,valid,invalid lines,vertices,line types,point degrees,line degree types,observable line types,symmetric lines,symmetric line types\n");
+}
+
+void analysis_record_to_csv(const analysis_record *record, FILE *output){
+    fprintf(output, "%ld,%d", record->solution, record->valid);
+    if (!record->valid){
+        fprintf(output, ",,,,,,,,\n");
+        return;
+    }
+    fprintf(output, ",%d,%d,%ld,", record->invalid_lines, record->vertices, record->line_types.types.cpt_keys);
+
+    /*degree:points:lines:line types*/
+    bool first = true;
+    for (int d = 1; d <= record->max_degree; d++){
+        if (record->degree_counts[d] == 0)continue;
+        fprintf(output, "%s%d:%d:%d:%d", first ? "" : ";", d, record->degree_counts[d], record->degree_lines[d], record->degree_types[d]);
+        first = false;
+    }
+    fprintf(output, ",");
+
+    /*degrees separated by spaces:lines*/
+    for (size_t t = 0; t < record->line_types.types.cpt_keys; t++){
+        const hash_set_store_type *degrees = hash_set_key(&record->line_types.types, t);
+        if (t != 0)fprintf(output, ";");
+        for (size_t j = 0; j < record->line_types.points_per_geometry; j++)
+            fprintf(output, "%s%d", j == 0 ? "" : " ", (int)degrees[j]);
+        fprintf(output, ":%d", record->line_types.counts[t]);
+    }
+    fprintf(output, ",");
+
+    /*lines:line types of each point, in the order of the points*/
+    for (int i = 0; i < record->vertices; i++)
+        fprintf(output, "%s%d:%d", i == 0 ? "" : ";", record->point_lines[i], record->point_types[i]);
+    fprintf(output, ",%d,%d\n", record->symmetric_lines, record->symmetric_types);
+}
+
+void analysis_record_free(analysis_record *record){
+    if (record->valid)line_categories_free(&record->line_types);
+    free(record->degree_counts);
+    free(record->degree_lines);
+    free(record->degree_types);
+    free(record->points);
+    free(record->point_degrees);
+    free(record->point_lines);
+    free(record->point_types);
+    *record = (analysis_record){0};
+}
+
+/*reads the next solution code of a file, returns false at its end*/
+static bool analysis_read_code(FILE *solutions, char **line, size_t *capacity, size_t *line_number){
+    ssize_t length;
+    while ((length = getline(line, capacity, solutions)) != -1){
+        (*line_number)++;
+        while (length > 0 && ((*line)[length - 1] == '\n' || (*line)[length - 1] == '\r' || (*line)[length - 1] == ' '))
+            (*line)[--length] = '\0';
+        if (length > 0 && (*line)[0] != '#')return true;
+    }
+    return false;
+}
+
+size_t analysis_run(quantum_assignment *qa, FILE *solutions, FILE *output, analysis_format format){
+    quantum_assignment_compute_negativity(qa);
+    size_t n_points = quantum_assignment_n_points(qa);
+
+    char **codes = calloc(ANALYSIS_BLOCK_SIZE, sizeof(char *));
+    size_t *line_numbers = calloc(ANALYSIS_BLOCK_SIZE, sizeof(size_t));
+    analysis_record *records = calloc(ANALYSIS_BLOCK_SIZE, sizeof(analysis_record));
+    char *line = NULL;
+    size_t capacity = 0, line_number = 0, cpt_records = 0;
+
+    if (format == ANALYSIS_CSV)analysis_csv_header(output);
+
+    bool end = false;
+    while (!end && !is_done){
+        /*the codes of a block are read first, then analysed in parallel, then written in order*/
+        size_t cpt = 0;
+        while (cpt < ANALYSIS_BLOCK_SIZE && !(end = !analysis_read_code(solutions, &line, &capacity, &line_number))){
+            codes[cpt] = strdup(line);
+            line_numbers[cpt++] = line_number;
+        }
+
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < cpt; i++){
+            bool *bool_sol = calloc(n_points, sizeof(bool));
+            if (parse_solution_code(codes[i], bool_sol, n_points))records[i] = analysis_record_compute(qa, bool_sol);
+            else records[i] = (analysis_record){.valid = false};
+            records[i].solution = line_numbers[i];
+            free(bool_sol);
+        }
+
+        for (size_t i = 0; i < cpt; i++){
+            if (format == ANALYSIS_JSON)analysis_record_to_json(qa, &records[i], output);
+            else analysis_record_to_csv(&records[i], output);
+            analysis_record_free(&records[i]);
+            free(codes[i]);
+        }
+        cpt_records += cpt;
+    }
+
+    free(line);
+    free(codes);
+    free(line_numbers);
+    free(records);
+    return cpt_records;
+}
@@ -0,0 +1,421 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file batch.c
+ * @brief non-interactive solving of the configurations listed in a manifest (batch mode)
+ */
+#include "constants.h"
+#include "batch.h"
+#include "binary_format.h"
+#include "hypergram.h"
+#include "isotropic.h"
+#include "quadrics.h"
+
+#include <limits.h>
+#include <omp.h>
+#include <string.h>
+
+static const char *BATCH_SOURCE_NAMES[] = {"assignment", "binary", "gram", "hypergram", "subspaces", "quadric", "perpset", "lines"};
+
+/*number of file arguments of each source, -1 for the generated configurations*/
+static const int BATCH_SOURCE_PATHS[] = {1, 1, 1, 2, -1, -1, -1, -1};
+
+static bool batch_source_uses_lines(const batch_job *job){
+    return job->source == BATCH_SOURCE_QUADRIC || job->source == BATCH_SOURCE_PERPSET || job->source == BATCH_SOURCE_LINES ||
+           (job->source == BATCH_SOURCE_SUBSPACES && job->dimension == 1);
+}
+
+/*reads an integer argument, returns false if it is not one*/
+static bool batch_parse_int(const char *token, long min, long max, long *value){
+    char *end;
+    if (token == NULL)return false;
+    *value = strtol(token, &end, 10);
+    return *end == '\0' && end != token && *value >= min && *value <= max;
+}
+
+/*reads an observable of n_qubits gates*/
+static bool batch_parse_observable(const char *token, int n_qubits, bv *observable){
+    if (token == NULL || strlen(token) != (size_t)n_qubits || strspn(token, "IXYZ") != (size_t)n_qubits)return false;
+    *observable = str_to_bv_custom((char *)token, n_qubits);
+    return true;
+}
+
+/*reads a comma separated list of line indices, from 1 to the number of lines of n_qubits*/
+static bool batch_parse_indices(const char *token, int n_qubits, batch_job *job){
+    if (token == NULL)return false;
+    size_t capacity = 1;
+    for (const char *c = token; *c != '\0'; c++)if (*c == ',')capacity++;
+    job->indices = malloc(capacity * sizeof(size_t));
+
+    char *end;
+    for (const char *c = token; job->cpt_indices < capacity; c = end + 1){
+        if (*c < '0' || *c > '9')return false;
+        unsigned long index = strtoul(c, &end, 10);
+        if ((*end != ',' && *end != '\0') || index < 1 || index > (unsigned long)NB_LINES_CUSTOM(n_qubits))return false;
+        job->indices[job->cpt_indices++] = index;
+        if (*end == '\0')break;
+    }
+    return job->cpt_indices == capacity;
+}
+
+/*reads a KEY=VALUE setting (or the complement flag)*/
+static bool batch_parse_option(char *token, batch_job *job){
+    if (strcmp(token, "complement") == 0 && (job->source == BATCH_SOURCE_QUADRIC || job->source == BATCH_SOURCE_PERPSET)){
+        job->complement = true;
+        return true;
+    }
+    char *value = strchr(token, '=');
+    if (value == NULL || value[1] == '\0')return false;
+    *value++ = '\0';
+
+    char *end;
+    long integer;
+    if (strcmp(token, "solver") == 0){
+        if (strcmp(value, "sat") == 0)job->options.mode = SAT_SOLVER;
+        else if (strcmp(value, "heuristic") == 0)job->options.mode = INVALID_LINES_HEURISTIC_SOLVER;
+        else return false;
+    }
+    else if (strcmp(token, "iterations") == 0){
+        if (!batch_parse_int(value, 1, LONG_MAX, &integer))return false;
+        job->options.heuristic_iterations = integer;
+    }
+    else if (strcmp(token, "threshold") == 0 || strcmp(token, "flip") == 0){
+        float number = strtof(value, &end);
+        if (*end != '\0' || number < 0.0f || number > 1.0f)return false;
+        if (token[0] == 't')job->options.heuristic_threshold = number;
+        else job->options.heuristic_flip_probability = number;
+    }
+    else if (strcmp(token, "time") == 0){
+        double seconds = strtod(value, &end);
+        if (*end != '\0' || !(seconds > 0.0))return false;
+        job->options.time_limit = seconds;
+    }
+    else if (strcmp(token, "stop-regular") == 0){
+        if (!batch_parse_int(value, 1, INT_MAX, &integer))return false;
+        job->options.heuristic_stop_regular = integer;
+    }
+    else if (strcmp(token, "sample") == 0 && job->source == BATCH_SOURCE_SUBSPACES){
+        if (!batch_parse_int(value, 1, LONG_MAX, &integer))return false;
+        job->sample = integer;
+    }
+    else return false;
+    return true;
+}
+
+bool batch_job_parse(char *line, const solver_options *defaults, batch_job *job){
+    char *save = NULL;
+    char *name = strtok_r(line, " \t\r\n", &save);
+    if (name == NULL || name[0] == '#')return false;
+
+    size_t line_number = job->line;
+    *job = (batch_job){.line = line_number, .name = strdup(name), .options = *defaults};
+
+    char *source = strtok_r(NULL, " \t\r\n", &save);
+    int s = 0;
+    while (source != NULL && s <= BATCH_SOURCE_LINES && strcmp(source, BATCH_SOURCE_NAMES[s]) != 0)s++;
+    if (source == NULL || s > BATCH_SOURCE_LINES){
+        job->error = "unknown source";
+        return true;
+    }
+    job->source = (batch_source)s;
+
+    if (BATCH_SOURCE_PATHS[s] > 0){
+        for (int p = 0; p < BATCH_SOURCE_PATHS[s]; p++){
+            char *path = strtok_r(NULL, " \t\r\n", &save);
+            if (path == NULL){
+                job->error = "missing file";
+                return true;
+            }
+            job->paths[p] = strdup(path);
+        }
+    }else{
+        long n_qubits, dimension;
+        if (!batch_parse_int(strtok_r(NULL, " \t\r\n", &save), 2, BATCH_MAX_LINE_QUBITS, &n_qubits)){
+            job->error = "invalid number of qubits";
+            return true;
+        }
+        job->n_qubits = n_qubits;
+        char *argument = strtok_r(NULL, " \t\r\n", &save);
+        if (job->source == BATCH_SOURCE_SUBSPACES){
+            if (!batch_parse_int(argument, 1, n_qubits - 1, &dimension)){
+                job->error = "invalid dimension";
+                return true;
+            }
+            job->dimension = dimension;
+        }
+        else if (job->source == BATCH_SOURCE_LINES){
+            if (!batch_parse_indices(argument, job->n_qubits, job)){
+                job->error = "invalid line indices";
+                return true;
+            }
+        }
+        else if (!batch_parse_observable(argument, job->n_qubits, &job->observable) || job->observable == I){
+            job->error = "invalid observable";
+            return true;
+        }
+    }
+
+    for (char *token = strtok_r(NULL, " \t\r\n", &save); token != NULL; token = strtok_r(NULL, " \t\r\n", &save)){
+        if (!batch_parse_option(token, job)){
+            job->error = "invalid option";
+            return true;
+        }
+    }
+    if (job->options.mode == RETRIEVE_SOLUTION)job->error = "the retrieve solver cannot be used in batch mode";
+    else if (job->options.mode == SAT_SOLVER && job->options.time_limit != DISABLED_PARAMETER)job->error = "the time budget only applies to the heuristic solver";
+    return true;
+}
+
+batch_manifest batch_manifest_parse(FILE *manifest, const solver_options *defaults){
+    batch_manifest res = {0};
+    char *line = NULL;
+    size_t capacity = 0, line_number = 0;
+    while (getline(&line, &capacity, manifest) != -1){
+        line_number++;
+        if (res.cpt_jobs == res.capacity){
+            res.capacity = MAX(2 * res.capacity, 16);
+            res.jobs = realloc(res.jobs, res.capacity * sizeof(batch_job));
+        }
+        res.jobs[res.cpt_jobs].line = line_number;
+        if (batch_job_parse(line, defaults, &res.jobs[res.cpt_jobs]))res.cpt_jobs++;
+    }
+    free(line);
+    return res;
+}
+
+void batch_job_free(batch_job *job){
+    free(job->name);
+    free(job->paths[0]);
+    free(job->paths[1]);
+    free(job->indices);
+}
+
+void batch_manifest_free(batch_manifest *manifest){
+    for (size_t i = 0; i < manifest->cpt_jobs; i++)batch_job_free(&manifest->jobs[i]);
+    free(manifest->jobs);
+    *manifest = (batch_manifest){0};
+}
+
+/////////////////////////////////////////// results
+
+/*a JSON string (names and paths may hold quotes or backslashes)*/
+static void batch_json_string(const char *str, FILE *output){
+    fputc('"', output);
+    for (; *str != '\0'; str++){
+        if (*str == '"' || *str == '\\')fputc('\\', output);
+        fputc(*str, output);
+    }
+    fputc('"', output);
+}
+
+void batch_result_to_json(const batch_job *job, const batch_result *result, FILE *output){
+    fprintf(output, "{\"line\":%ld,\"name\":", job->line);
+    batch_json_string(job->name, output);
+    if (result->error != NULL){
+        fprintf(output, ",\"status\":\"error\",\"error\":");
+        batch_json_string(result->error, output);
+        fprintf(output, "}\n");
+        return;
+    }
+    fprintf(output, ",\"source\":\"%s\",\"status\":\"ok\",\"qubits\":%d,\"contexts\":%ld,\"negative_contexts\":%d,\"degree\":%d,\"solver\":\"%s\",\"time\":%.3f",
+            BATCH_SOURCE_NAMES[job->source], result->n_qubits, result->contexts, result->negative_contexts, result->degree,
+            solver_mode_name(job->options.mode), result->time);
+    if (result->solution != NULL)fprintf(output, ",\"solution\":\"%s\"", result->solution);
+    fprintf(output, "}\n");
+}
+
+void batch_csv_header(FILE *output){
+    fprintf(output, "line,name,source,status,qubits,contexts,negative contexts,degree,solver,time\n");
+}
+
+void batch_result_to_csv(const batch_job *job, const batch_result *result, FILE *output){
+    fprintf(output, "%ld,%s,", job->line, job->name);
+    if (result->error != NULL){
+        fprintf(output, ",%s,,,,,,\n", result->error);
+        return;
+    }
+    fprintf(output, "%s,ok,%d,%ld,%d,%d,%s,%.3f\n", BATCH_SOURCE_NAMES[job->source], result->n_qubits, result->contexts,
+            result->negative_contexts, result->degree, solver_mode_name(job->options.mode), result->time);
+}
+
+/////////////////////////////////////////// jobs
+
+void batch_lines_require(const batch_job *job, batch_lines *lines){
+    if (job->error != NULL || !batch_source_uses_lines(job))return;
+    #pragma omp critical(batch_lines)
+    {
+        if (lines->lines_qa[job->n_qubits].geometries == NULL)
+            lines->lines_qa[job->n_qubits] = generate_total_lines(&lines->lines_indices[job->n_qubits], job->n_qubits);
+    }
+}
+
+void batch_lines_free(batch_lines *lines){
+    for (int n = 0; n <= BATCH_MAX_LINE_QUBITS; n++){
+        if (lines->lines_qa[n].geometries == NULL)continue;
+        free_quantum_assignment(&lines->lines_qa[n]);
+        free_matrix(lines->lines_indices[n]);
+        quantum_assignment_free_geometries(&lines->lines_qa[n]);
+    }
+    *lines = (batch_lines){0};
+}
+
+quantum_assignment batch_job_load(const batch_job *job, batch_lines *lines, batch_result *result){
+    quantum_assignment qa = {0};
+    FILE *files[2] = {NULL, NULL};
+    for (int p = 0; p < BATCH_SOURCE_PATHS[job->source]; p++){
+        files[p] = fopen(job->paths[p], job->source == BATCH_SOURCE_BINARY ? "rb" : "r");
+        if (files[p] == NULL)result->error = "cannot open file";
+    }
+    if (result->error != NULL){
+        for (int p = 0; p < 2; p++)if (files[p] != NULL)fclose(files[p]);
+        return qa;
+    }
+
+    const quantum_assignment *lines_qa = &lines->lines_qa[job->n_qubits];
+    hypergram hg;
+    switch (job->source){
+    case BATCH_SOURCE_ASSIGNMENT:
+        qa = quantum_assignment_parse(files[0]);
+        break;
+    case BATCH_SOURCE_BINARY:
+        qa = binary_assignment_load(files[0], NULL, NULL);
+        break;
+    case BATCH_SOURCE_GRAM:
+    case BATCH_SOURCE_HYPERGRAM:
+        hg = (job->source == BATCH_SOURCE_GRAM) ? hypergram_create_from_gram_file(files[0]) : hypergram_create_from_file(files[0], files[1]);
+        if (hg.geometries == NULL)break;
+        if (job->source == BATCH_SOURCE_HYPERGRAM)hypergram_compute_assignment(&hg);
+        qa = hypergram_to_quantum_assignment(hg);
+        hypergram_free(hg);
+        break;
+    case BATCH_SOURCE_SUBSPACES:
+        if (job->dimension > 1){
+            qa = (job->sample > 0) ? isotropic_subspaces_sample(job->n_qubits, job->dimension, job->sample)
+                                   : subspaces(job->n_qubits, job->dimension);
+            break;
+        }
+        /*the lines themselves (rows 1 to NB_LINES_CUSTOM), with their own indices and signs*/
+        qa = *lines_qa;
+        qa.geometry_indices = malloc(qa.cpt_geometries * sizeof(size_t));
+        memcpy(qa.geometry_indices, lines_qa->geometry_indices, qa.cpt_geometries * sizeof(size_t));
+        qa.lines_negativity = NULL;
+        quantum_assignment_compute_negativity(&qa);
+        break;
+    case BATCH_SOURCE_QUADRIC:
+        qa = quadric(job->observable, lines->lines_indices[job->n_qubits], job->n_qubits, *lines_qa, job->complement);
+        break;
+    case BATCH_SOURCE_PERPSET:
+        qa = perpset(job->observable, lines->lines_indices[job->n_qubits], job->n_qubits, *lines_qa, job->complement);
+        break;
+    case BATCH_SOURCE_LINES:
+        qa = (quantum_assignment){
+            .geometry_indices = malloc(job->cpt_indices * sizeof(size_t)),
+            .geometries = lines_qa->geometries,
+            .cpt_geometries = job->cpt_indices,
+            .points_per_geometry = NB_POINTS_PER_LINE,
+            .n_qubits = job->n_qubits
+        };
+        memcpy(qa.geometry_indices, job->indices, job->cpt_indices * sizeof(size_t));
+        break;
+    }
+    for (int p = 0; p < 2; p++)if (files[p] != NULL)fclose(files[p]);
+
+    if (qa.geometries == NULL || qa.cpt_geometries == 0){
+        result->error = "empty or invalid configuration";
+        return qa;
+    }
+    quantum_assignment_autofill_indices(&qa);
+    quantum_assignment_compute_negativity(&qa);
+    result->n_qubits = qa.n_qubits;
+    result->contexts = qa.cpt_geometries;
+    result->negative_contexts = negative_lines_count(&qa);
+    return qa;
+}
+
+void batch_job_unload(const batch_job *job, quantum_assignment *qa){
+    free_quantum_assignment(qa);
+    /*the configurations made of lines share the geometries of the lines*/
+    if (!batch_source_uses_lines(job))quantum_assignment_free_geometries(qa);
+}
+
+/*writes a result and flushes it, so that the results of a long batch can be read while it runs*/
+static void batch_write(const batch_job *job, const batch_result *result, FILE *output, batch_format format){
+    #pragma omp critical(batch_output)
+    {
+        if (format == BATCH_JSON)batch_result_to_json(job, result, output);
+        else batch_result_to_csv(job, result, output);
+        fflush(output);
+    }
+}
+
+/*the solving time is added to the loading time of the result, a solver which could not be run
+(or was interrupted before any degree) failing the job*/
+static void batch_solve(const batch_job *job, quantum_assignment *qa, batch_result *result){
+    double start = omp_get_wtime();
+    result->degree = geometry_contextuality_degree_options(qa, false, false, false, &job->options, NULL);
+    result->time += omp_get_wtime() - start;
+    if (result->degree < 0)result->error = is_done ? "interrupted" : "solver failure";
+}
+
+size_t batch_run(batch_manifest *manifest, FILE *output, batch_format format){
+    size_t cpt = manifest->cpt_jobs, cpt_results = 0;
+
+    /*the lines are generated once, before the jobs*/
+    batch_lines lines = {0};
+    for (size_t i = 0; i < cpt; i++)batch_lines_require(&manifest->jobs[i], &lines);
+
+    /*the configurations too large to be solved by one thread, with their partial results*/
+    quantum_assignment *deferred = calloc(MAX(cpt, 1), sizeof(quantum_assignment));
+    batch_result *deferred_results = calloc(MAX(cpt, 1), sizeof(batch_result));
+
+    /*the solvers' own parallel regions only get one thread inside the loop below*/
+    int max_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:cpt_results)
+    for (size_t i = 0; i < cpt; i++){
+        batch_job *job = &manifest->jobs[i];
+        batch_result result = {.error = job->error, .degree = -1};
+        if (is_done){/*the jobs not started when SIGINT is received are reported as interrupted*/
+            if (result.error == NULL)result.error = "interrupted";
+            batch_write(job, &result, output, format);
+            cpt_results++;
+            continue;
+        }
+        double start = omp_get_wtime();
+        quantum_assignment qa = {0};
+        if (result.error == NULL)qa = batch_job_load(job, &lines, &result);
+        result.time = omp_get_wtime() - start;
+
+        if (result.error == NULL && qa.cpt_geometries >= FAMILY_NESTED_MIN_CONTEXTS){
+            deferred[i] = qa;
+            deferred_results[i] = result;
+            continue;
+        }
+        if (result.error == NULL)batch_solve(job, &qa, &result);
+        batch_job_unload(job, &qa);
+        batch_write(job, &result, output, format);
+        cpt_results++;
+    }
+
+    omp_set_max_active_levels(max_levels);
+
+    for (size_t i = 0; i < cpt; i++){
+        if (deferred[i].geometries == NULL)continue;
+        if (!is_done)batch_solve(&manifest->jobs[i], &deferred[i], &deferred_results[i]);
+        else deferred_results[i].error = "interrupted";
+        batch_write(&manifest->jobs[i], &deferred_results[i], output, format);
+        cpt_results++;
+        batch_job_unload(&manifest->jobs[i], &deferred[i]);
+    }
+
+    batch_lines_free(&lines);
+    free(deferred);
+    free(deferred_results);
+    return cpt_results;
+}
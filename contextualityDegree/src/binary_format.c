@@ -0,0 +1,420 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file binary_format.c
+ * @brief binary containers for Gram matrices, hypergraphs and quantum assignments
+ */
+#include "constants.h"
+#include "binary_format.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hypergram.h"
+#include "config_checker.h"
+
+/*64-bit words of a context of cols 32-bit point ids*/
+#define BINARY_ASSIGNMENT_ROW_WORDS(cols) (((cols) + 1) / 2)
+/*bound on the qubits of a loaded assignment, whose observables are printed from buffers on the stack*/
+#define BINARY_ASSIGNMENT_MAX_QUBITS (1 << 16)
+
+/*the sizes come from the header of the file, so that they are computed without overflow before
+being compared with the length of the file*/
+static bool binary_size_mul(size_t a, size_t b, size_t *res){
+    if (b != 0 && a > SIZE_MAX / b)return false;
+    *res = a * b;
+    return true;
+}
+
+static bool binary_size_add(size_t a, size_t b, size_t *res){
+    if (a > SIZE_MAX - b)return false;
+    *res = a + b;
+    return true;
+}
+
+/*true if the file holds at least size bytes*/
+static bool binary_file_holds(FILE *f, size_t size){
+    struct stat st;
+    return fstat(fileno(f), &st) == 0 && st.st_size >= 0 && (uint64_t)st.st_size >= size;
+}
+
+static bool binary_read_header(FILE *f, binary_kind kind, binary_header *header){
+    rewind(f);
+    bool ok = fread(header, sizeof(binary_header), 1, f) == 1 &&
+              memcmp(header->magic, BINARY_MAGIC, sizeof(header->magic)) == 0 &&
+              header->kind == (uint32_t)kind;
+    if (!ok)rewind(f);
+    return ok;
+}
+
+static bool binary_write_header(FILE *f, binary_kind kind, uint64_t rows, uint64_t cols, uint64_t row_words, uint64_t points){
+    binary_header header = {
+        .version = BINARY_VERSION,
+        .kind = kind,
+        .rows = rows,
+        .cols = cols,
+        .row_words = row_words,
+        .points = points
+    };
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    return fwrite(&header, sizeof(binary_header), 1, f) == 1;
+}
+
+bool binary_file_is(FILE *f, binary_kind kind){
+    binary_header header;
+    bool res = binary_read_header(f, kind, &header);
+    rewind(f);
+    return res;
+}
+
+bit_matrix binary_gram_load(FILE *f){
+    binary_header header;
+    if (!binary_read_header(f, BINARY_GRAM, &header)){
+        print("error : not a binary gram file\n");
+        return (bit_matrix){0};
+    }
+    /*a commutation matrix is square*/
+    if (header.version != BINARY_VERSION || header.rows == 0 || header.rows != header.cols || header.row_words != BIT_SIZE(header.cols)){
+        print("error : invalid binary gram header (version %u, %lux%lu, %lu words per row)\n",
+              header.version, (unsigned long)header.rows, (unsigned long)header.cols, (unsigned long)header.row_words);
+        return (bit_matrix){0};
+    }
+
+    size_t mapping_size;
+    if (!binary_size_mul(header.rows, header.row_words, &mapping_size) || !binary_size_mul(mapping_size, sizeof(bit_set_type), &mapping_size) ||
+        !binary_size_add(mapping_size, sizeof(binary_header), &mapping_size) || !binary_file_holds(f, mapping_size)){
+        print("error : truncated binary gram file\n");
+        return (bit_matrix){0};
+    }
+    /*private mapping: the rows can be modified in memory without changing the file*/
+    void *mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(f), 0);
+    if (mapping == MAP_FAILED){
+        print("error : the binary gram file cannot be mapped\n");
+        return (bit_matrix){0};
+    }
+
+    bit_set_type *rows = (bit_set_type *)((char *)mapping + sizeof(binary_header));
+    bit_matrix bm = {
+        .size = header.rows,
+        .bit_sets = (bit_vector *)calloc(header.rows, sizeof(bit_vector)),
+        .bits = (bit_set_type **)calloc(header.rows, sizeof(bit_set_type *)),
+        .mapping = mapping,
+        .mapping_size = mapping_size
+    };
+    if (bm.bit_sets == NULL || bm.bits == NULL){
+        print("error : not enough memory for the binary gram matrix\n");
+        free(bm.bit_sets);
+        free(bm.bits);
+        munmap(mapping, mapping_size);
+        return (bit_matrix){0};
+    }
+    for (size_t i = 0; i < bm.size; i++){
+        bm.bits[i] = rows + i * header.row_words;
+        bm.bit_sets[i] = bit_set_create(header.cols, bm.bits[i]);
+    }
+    print("matrix size : %ldx%ld\n", bm.size, bm.bit_sets[0].size);
+    return bm;
+}
+
+bool binary_gram_save(bit_matrix bm, FILE *f){
+    if (bm.size == 0)return false;
+    size_t row_words = BIT_SET_ARR_SIZE(bm.bit_sets[0]);
+    if (!binary_write_header(f, BINARY_GRAM, bm.size, bm.bit_sets[0].size, row_words, 0))return false;
+    for (size_t i = 0; i < bm.size; i++)
+        if (fwrite(bm.bits[i], sizeof(bit_set_type), row_words, f) != row_words)return false;
+    return true;
+}
+
+size_t **binary_hypergraph_load(FILE *f, size_t *cpt_geometries, size_t *points_per_geometry, size_t *cpt_points){
+    binary_header header;
+    if (!binary_read_header(f, BINARY_HYPERGRAPH, &header)){
+        print("error : not a binary hypergraph file\n");
+        return NULL;
+    }
+    /*the contexts are read as they are, size_t being 64-bit wide*/
+    if (header.version != BINARY_VERSION || header.rows == 0 || header.cols < 2 || header.row_words != header.cols ||
+        sizeof(size_t) != sizeof(uint64_t)){
+        print("error : invalid binary hypergraph header (version %u, %lux%lu)\n",
+              header.version, (unsigned long)header.rows, (unsigned long)header.cols);
+        return NULL;
+    }
+
+    size_t cpt_ids, file_size;
+    if (!binary_size_mul(header.rows, header.cols, &cpt_ids) || !binary_size_mul(cpt_ids, sizeof(size_t), &file_size) ||
+        !binary_size_add(file_size, sizeof(binary_header), &file_size) || !binary_file_holds(f, file_size)){
+        print("error : truncated binary hypergraph file\n");
+        return NULL;
+    }
+    size_t **geometries = (size_t **)init_matrix(header.rows, header.cols, sizeof(size_t));
+    if (geometries == NULL){
+        print("error : not enough memory for the binary hypergraph\n");
+        return NULL;
+    }
+    if (fread(geometries[0], sizeof(size_t), cpt_ids, f) != cpt_ids){
+        print("error : truncated binary hypergraph file\n");
+        free_matrix(geometries);
+        return NULL;
+    }
+    /*the points are numbered from 1 to header.points, 0 ending a context*/
+    for (size_t i = 0; i < header.rows; i++){
+        if (geometries[i][header.cols - 1] != 0){
+            print("error : context %ld of the binary hypergraph is not ended by 0\n", i);
+            free_matrix(geometries);
+            return NULL;
+        }
+        for (size_t j = 0; j < header.cols; j++){
+            if (geometries[i][j] > header.points){
+                print("error : context %ld of the binary hypergraph has the point %ld, out of %ld points\n", i, geometries[i][j], (size_t)header.points);
+                free_matrix(geometries);
+                return NULL;
+            }
+        }
+    }
+
+    *cpt_geometries = header.rows;
+    *points_per_geometry = header.cols - 1;
+    *cpt_points = header.points;
+    print("cpt_geometries = %ld ; points_per_geometry = %ld\n", *cpt_geometries, *points_per_geometry);
+    return geometries;
+}
+
+bool binary_hypergraph_save(size_t **geometries, size_t cpt_geometries, size_t points_per_geometry, size_t cpt_points, FILE *f){
+    size_t cols = points_per_geometry + 1;
+    if (cpt_geometries == 0 || !binary_write_header(f, BINARY_HYPERGRAPH, cpt_geometries, cols, cols, cpt_points))return false;
+    for (size_t i = 0; i < cpt_geometries; i++){
+        for (size_t j = 0; j < cols; j++){
+            uint64_t point = geometries[i][j];
+            if (fwrite(&point, sizeof(uint64_t), 1, f) != 1)return false;
+        }
+    }
+    return true;
+}
+
+static size_t binary_assignment_observable_words(uint32_t n_qubits, size_t points){
+    return n_qubits > BV_MAX_QUBITS ? points * WIDE_BV_WORDS(n_qubits) : (points + 1) / 2;
+}
+
+quantum_assignment binary_assignment_load(FILE *f, bool **bool_sol, binary_assignment_stats *stats){
+    if (bool_sol != NULL)*bool_sol = NULL;
+    if (stats != NULL)*stats = (binary_assignment_stats){0};
+
+    binary_header header;
+    binary_assignment_info info;
+    if (!binary_read_header(f, BINARY_ASSIGNMENT, &header) || fread(&info, sizeof(info), 1, f) != 1){
+        print("error : not a binary assignment file\n");
+        return (quantum_assignment){0};
+    }
+    if (header.version != BINARY_VERSION || header.rows == 0 || header.cols == 0 || header.points == 0 ||
+        header.row_words != BINARY_ASSIGNMENT_ROW_WORDS(header.cols) || header.cols > 2 * header.row_words ||
+        header.points > (uint64_t)UINT32_MAX + 1 || info.n_qubits == 0 || info.n_qubits > BINARY_ASSIGNMENT_MAX_QUBITS ||
+        (info.blocks & ~(uint32_t)(BINARY_BLOCK_SOLUTION | BINARY_BLOCK_STATS)) != 0){
+        print("error : invalid binary assignment header (version %u, %lux%lu, %u qubits)\n",
+              header.version, (unsigned long)header.rows, (unsigned long)header.cols, info.n_qubits);
+        return (quantum_assignment){0};
+    }
+
+    size_t observable_words = (header.points + 1) / 2, negativity_words = BIT_SIZE(header.rows), solution_words = BIT_SIZE(header.points);
+    size_t context_words, words, mapping_size;
+    bool sizes_ok = (info.n_qubits <= BV_MAX_QUBITS || binary_size_mul(header.points, WIDE_BV_WORDS(info.n_qubits), &observable_words)) &&
+                    binary_size_mul(header.rows, header.row_words, &context_words) &&
+                    binary_size_add(observable_words, context_words, &words) &&
+                    binary_size_add(words, negativity_words, &words) &&
+                    (!(info.blocks & BINARY_BLOCK_SOLUTION) || binary_size_add(words, solution_words, &words)) &&
+                    binary_size_mul(words, sizeof(uint64_t), &mapping_size) &&
+                    binary_size_add(mapping_size, sizeof(binary_header) + sizeof(binary_assignment_info), &mapping_size) &&
+                    (!(info.blocks & BINARY_BLOCK_STATS) || binary_size_add(mapping_size, sizeof(binary_assignment_stats), &mapping_size));
+    if (!sizes_ok || !binary_file_holds(f, mapping_size)){
+        print("error : truncated binary assignment file\n");
+        return (quantum_assignment){0};
+    }
+    /*private mapping: the assignment can be modified in memory without changing the file*/
+    void *mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(f), 0);
+    if (mapping == MAP_FAILED){
+        print("error : the binary assignment file cannot be mapped\n");
+        return (quantum_assignment){0};
+    }
+
+    char *cursor = (char *)mapping + sizeof(binary_header) + sizeof(binary_assignment_info);
+    quantum_assignment qa = {
+        .cpt_geometries = header.rows,
+        .points_per_geometry = header.cols,
+        .n_qubits = info.n_qubits,
+        .n_observables = header.points,
+        .geometries = malloc(header.rows * sizeof(bv *)),
+        .mapping = mapping,
+        .mapping_size = mapping_size
+    };
+    if (qa.geometries == NULL){
+        print("error : not enough memory for the binary assignment\n");
+        munmap(mapping, mapping_size);
+        return (quantum_assignment){0};
+    }
+    if (info.n_qubits > BV_MAX_QUBITS)qa.wide_observables = (wide_word *)cursor;
+    else qa.observables = (bv *)cursor;
+    cursor += observable_words * sizeof(uint64_t);
+
+    bv *contexts = (bv *)cursor;
+    size_t row_ids = header.row_words * 2;
+    for (size_t i = 0; i < header.rows; i++)qa.geometries[i] = contexts + i * row_ids;
+    cursor += header.rows * header.row_words * sizeof(uint64_t);
+
+    qa.geometries_negativity = bit_set_create(header.rows, (bit_set_type *)cursor);
+    cursor += negativity_words * sizeof(uint64_t);
+
+    /*the observables must have n_qubits qubits*/
+    size_t invalid_observables = 0;
+    if (qa.wide_observables != NULL){
+        size_t half = WIDE_BV_HALF_WORDS(info.n_qubits);
+        wide_word high = info.n_qubits % 64 == 0 ? 0 : ~(wide_word)0 << (info.n_qubits % 64);
+        #pragma omp parallel for schedule(static) reduction(+:invalid_observables)
+        for (size_t p = 0; p < header.points; p++){
+            const wide_word *observable = qa.wide_observables + p * 2 * half;
+            invalid_observables += (observable[half - 1] & high) != 0 || (observable[2 * half - 1] & high) != 0;
+        }
+    }
+    else if (info.n_qubits < BV_MAX_QUBITS){
+        #pragma omp parallel for schedule(static) reduction(+:invalid_observables)
+        for (size_t p = 0; p < header.points; p++)invalid_observables += qa.observables[p] >= BV_LIMIT_CUSTOM(info.n_qubits);
+    }
+    if (invalid_observables != 0){
+        print("error : %ld observables of the binary assignment have more than %u qubits\n", invalid_observables, info.n_qubits);
+        quantum_assignment_free_geometries(&qa);
+        return (quantum_assignment){0};
+    }
+
+    /*the point ids are checked, as they index every array of the solvers, then the negativity of the
+    contexts is checked against the product of their observables*/
+    size_t out_of_range = 0, wrong_signs = 0;
+    #pragma omp parallel for schedule(static) reduction(+:out_of_range)
+    for (size_t i = 0; i < header.rows; i++)
+        for (size_t j = 0; j < header.cols; j++)out_of_range += contexts[i * row_ids + j] >= header.points;
+    if (out_of_range == 0){
+        #pragma omp parallel for schedule(static) reduction(+:wrong_signs)
+        for (size_t i = 0; i < header.rows; i++)
+            wrong_signs += quantum_assignment_geometry_sign(&qa, i) != (int)bit_set_get_bit(qa.geometries_negativity, i);
+    }
+    if (out_of_range != 0 || wrong_signs != 0){
+        if (out_of_range != 0)print("error : %ld point ids of the binary assignment are out of range\n", out_of_range);
+        else print("error : %ld contexts of the binary assignment have a wrong sign\n", wrong_signs);
+        quantum_assignment_free_geometries(&qa);
+        return (quantum_assignment){0};
+    }
+
+    if (info.blocks & BINARY_BLOCK_SOLUTION){
+        if (bool_sol != NULL){
+            bit_vector solution = bit_set_create(header.points, (bit_set_type *)cursor);
+            *bool_sol = malloc(header.points * sizeof(bool));
+            for (size_t p = 0; p < header.points; p++)(*bool_sol)[p] = bit_set_get_bit(solution, p);
+        }
+        cursor += solution_words * sizeof(uint64_t);
+    }
+    if ((info.blocks & BINARY_BLOCK_STATS) && stats != NULL)memcpy(stats, cursor, sizeof(binary_assignment_stats));
+
+    print("cpt_geometries = %ld ; points_per_geometry = %ld ; points = %ld\n", qa.cpt_geometries, qa.points_per_geometry, qa.n_observables);
+    return qa;
+}
+
+/*writes the words of a bit vector built from an array of booleans*/
+static bool binary_write_bools(const bool *values, size_t size, FILE *f){
+    bit_vector bits = bit_set_create(size, NULL);
+    for (size_t i = 0; i < size; i++)if (values[i])bit_set_set_bit(bits, i, true);
+    bool res = fwrite(bits.bits, sizeof(bit_set_type), BIT_SET_ARR_SIZE(bits), f) == BIT_SET_ARR_SIZE(bits);
+    bit_set_free(bits);
+    return res;
+}
+
+/*copy of the contexts of an assignment into its own geometry array, which can then be compacted*/
+static quantum_assignment binary_assignment_copy(quantum_assignment *qa){
+    quantum_assignment_compute_negativity(qa);
+    quantum_assignment copy = {
+        .geometries = (bv **)init_matrix(qa->cpt_geometries, qa->points_per_geometry, sizeof(bv)),
+        .cpt_geometries = qa->cpt_geometries,
+        .points_per_geometry = qa->points_per_geometry,
+        .n_qubits = qa->n_qubits,
+        .lines_negativity = malloc(qa->cpt_geometries * sizeof(bool))
+    };
+    for (size_t i = 0; i < qa->cpt_geometries; i++)
+        memcpy(copy.geometries[i], qa->geometries[qa->geometry_indices[i]], qa->points_per_geometry * sizeof(bv));
+    memcpy(copy.lines_negativity, qa->lines_negativity, qa->cpt_geometries * sizeof(bool));
+    quantum_assignment_compact(&copy);
+    return copy;
+}
+
+bool binary_assignment_save(quantum_assignment *qa, const bool *bool_sol, FILE *f){
+    if (qa->cpt_geometries == 0 || qa->points_per_geometry == 0)return false;
+    if (qa->observables == NULL && qa->wide_observables == NULL){
+        /*the geometry array may be shared with other assignments, so it is not relabeled in place*/
+        if (bool_sol != NULL){
+            print("error : a solution can only be saved with a compact assignment\n");
+            return false;
+        }
+        quantum_assignment copy = binary_assignment_copy(qa);
+        bool res = binary_assignment_save(&copy, NULL, f);
+        free_quantum_assignment(&copy);
+        quantum_assignment_free_geometries(&copy);
+        return res;
+    }
+    quantum_assignment_compute_negativity(qa);
+
+    size_t points = quantum_assignment_n_points(qa), row_words = BINARY_ASSIGNMENT_ROW_WORDS(qa->points_per_geometry);
+    binary_assignment_info info = {
+        .n_qubits = qa->n_qubits,
+        .blocks = bool_sol != NULL ? BINARY_BLOCK_SOLUTION | BINARY_BLOCK_STATS : 0
+    };
+    if (!binary_write_header(f, BINARY_ASSIGNMENT, qa->cpt_geometries, qa->points_per_geometry, row_words, points) ||
+        fwrite(&info, sizeof(info), 1, f) != 1)return false;
+
+    /*observables, the last word being padded with I*/
+    size_t observable_words = binary_assignment_observable_words(info.n_qubits, points);
+    if (qa->wide_observables != NULL){
+        if (fwrite(qa->wide_observables, sizeof(wide_word), observable_words, f) != observable_words)return false;
+    }else{
+        bv padding = I;
+        if (fwrite(qa->observables, sizeof(bv), points, f) != points || (points % 2 == 1 && fwrite(&padding, sizeof(bv), 1, f) != 1))return false;
+    }
+
+    /*contexts in the order of geometry_indices, padded with I*/
+    bv row[row_words * 2];
+    memset(row, 0, sizeof(row));
+    for (size_t i = 0; i < qa->cpt_geometries; i++){
+        memcpy(row, qa->geometries[qa->geometry_indices[i]], qa->points_per_geometry * sizeof(bv));
+        if (fwrite(row, sizeof(bv), row_words * 2, f) != row_words * 2)return false;
+    }
+
+    if (!binary_write_bools(qa->lines_negativity, qa->cpt_geometries, f))return false;
+    if (bool_sol == NULL)return true;
+
+    invalid_stats invalid = invalid_stats_init(qa, bool_sol);
+    binary_assignment_stats stats = {.negative_lines = negative_lines_count(qa), .vertices = invalid.vertices};
+    for (size_t i = 0; i < qa->cpt_geometries; i++)stats.invalid_lines += invalid.invalid_lines[i];
+    for (int d = 1; d <= invalid.max_degree; d++)if (invalid.degree_counts[d] != 0)stats.max_degree = d;
+    invalid_stats_free(&invalid);
+
+    return binary_write_bools(bool_sol, points, f) && fwrite(&stats, sizeof(stats), 1, f) == 1;
+}
+
+bool binary_convert(binary_kind kind, FILE *input, FILE *output){
+    bool res = false;
+    if (kind == BINARY_GRAM){
+        bit_matrix bm = parse_gram_matrix(input);
+        res = bm.size != 0 && binary_gram_save(bm, output);
+        if (bm.size != 0)bit_matrix_free(bm);
+    }else if (kind == BINARY_HYPERGRAPH){
+        size_t cpt_geometries, points_per_geometry, cpt_points;
+        size_t **geometries = parse_geometries(input, &cpt_geometries, &points_per_geometry, &cpt_points);
+        res = geometries != NULL && binary_hypergraph_save(geometries, cpt_geometries, points_per_geometry, cpt_points, output);
+        free_matrix(geometries);
+    }else if (kind == BINARY_ASSIGNMENT){
+        quantum_assignment qa = quantum_assignment_parse(input);
+        res = binary_assignment_save(&qa, NULL, output);
+        free_quantum_assignment(&qa);
+        quantum_assignment_free_geometries(&qa);
+    }
+    if (!res)print("error : conversion failed\n");
+    return res;
+}
@@ -0,0 +1,185 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file bit_kernels.c
+ * @brief word kernels of the bit sets, with runtime selection of the instruction set
+ */
+#include "bit_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BIT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+/*element-wise operations, written once and compiled for each instruction set (the loops being vectorized)*/
+#define BIT_KERNELS_LOGIC(SUFFIX, TARGET)                                                                  \
+    TARGET static void and_words_##SUFFIX(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){    \
+        for (size_t i = 0; i < words; i++)res[i] = a[i] & b[i];                                            \
+    }                                                                                                      \
+    TARGET static void or_words_##SUFFIX(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){     \
+        for (size_t i = 0; i < words; i++)res[i] = a[i] | b[i];                                            \
+    }                                                                                                      \
+    TARGET static void xor_words_##SUFFIX(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){    \
+        for (size_t i = 0; i < words; i++)res[i] = a[i] ^ b[i];                                            \
+    }                                                                                                      \
+    TARGET static void andnot_words_##SUFFIX(uint64_t *res, const uint64_t *a, const uint64_t *b, size_t words){ \
+        for (size_t i = 0; i < words; i++)res[i] = a[i] & ~b[i];                                           \
+    }
+
+/////////////////////////////////////////// scalar
+
+BIT_KERNELS_LOGIC(scalar, )
+
+static size_t popcount_scalar(const uint64_t *a, size_t words){
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++)count += __builtin_popcountll(a[i]);
+    return count;
+}
+
+static size_t xor_popcount_scalar(const uint64_t *a, const uint64_t *b, size_t words){
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++)count += __builtin_popcountll(a[i] ^ b[i]);
+    return count;
+}
+
+static bool any_scalar(const uint64_t *a, size_t words){
+    for (size_t i = 0; i < words; i++)if (a[i] != 0)return true;
+    return false;
+}
+
+#ifdef BIT_KERNELS_X86
+
+/////////////////////////////////////////// AVX2
+
+#define TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+
+BIT_KERNELS_LOGIC(avx2, TARGET_AVX2)
+
+/*popcount of each 64-bit lane, by nibble lookup (W. Mula), AVX2 having no popcount instruction*/
+TARGET_AVX2 static inline __m256i popcount_lanes_avx2(__m256i v){
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_and_si256(v, low_mask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+TARGET_AVX2 static inline size_t sum_lanes_avx2(__m256i acc){
+    return (size_t)(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                    _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+}
+
+TARGET_AVX2 static size_t popcount_avx2(const uint64_t *a, size_t words){
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4)acc = _mm256_add_epi64(acc, popcount_lanes_avx2(_mm256_loadu_si256((const __m256i *)(a + i))));
+    size_t count = sum_lanes_avx2(acc);
+    for (; i < words; i++)count += __builtin_popcountll(a[i]);
+    return count;
+}
+
+TARGET_AVX2 static size_t xor_popcount_avx2(const uint64_t *a, const uint64_t *b, size_t words){
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4){
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i)));
+        acc = _mm256_add_epi64(acc, popcount_lanes_avx2(v));
+    }
+    size_t count = sum_lanes_avx2(acc);
+    for (; i < words; i++)count += __builtin_popcountll(a[i] ^ b[i]);
+    return count;
+}
+
+TARGET_AVX2 static bool any_avx2(const uint64_t *a, size_t words){
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4){
+        __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+        if (!_mm256_testz_si256(v, v))return true;
+    }
+    for (; i < words; i++)if (a[i] != 0)return true;
+    return false;
+}
+
+/////////////////////////////////////////// AVX-512
+
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+
+BIT_KERNELS_LOGIC(avx512, TARGET_AVX512)
+
+/*the tail of less than 8 words is loaded under a mask*/
+TARGET_AVX512 static size_t popcount_avx512(const uint64_t *a, size_t words){
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= words; i += 8)acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(a + i)));
+    if (i < words)acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64((__mmask8)((1u << (words - i)) - 1), a + i)));
+    return (size_t)_mm512_reduce_add_epi64(acc);
+}
+
+TARGET_AVX512 static size_t xor_popcount_avx512(const uint64_t *a, const uint64_t *b, size_t words){
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= words; i += 8)
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i))));
+    if (i < words){
+        __mmask8 mask = (__mmask8)((1u << (words - i)) - 1);
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, a + i), _mm512_maskz_loadu_epi64(mask, b + i))));
+    }
+    return (size_t)_mm512_reduce_add_epi64(acc);
+}
+
+TARGET_AVX512 static bool any_avx512(const uint64_t *a, size_t words){
+    size_t i = 0;
+    for (; i + 8 <= words; i += 8)if (_mm512_test_epi64_mask(_mm512_loadu_si512(a + i), _mm512_loadu_si512(a + i)))return true;
+    for (; i < words; i++)if (a[i] != 0)return true;
+    return false;
+}
+
+#endif //BIT_KERNELS_X86
+
+#define BIT_KERNELS_TABLE(SUFFIX, NAME) \
+    (bit_kernels_table){                \
+        .name = NAME,                   \
+        .popcount = popcount_##SUFFIX,  \
+        .xor_popcount = xor_popcount_##SUFFIX, \
+        .and_words = and_words_##SUFFIX, \
+        .or_words = or_words_##SUFFIX,  \
+        .xor_words = xor_words_##SUFFIX, \
+        .andnot_words = andnot_words_##SUFFIX, \
+        .any = any_##SUFFIX             \
+    }
+
+bit_kernels_table bit_kernels = BIT_KERNELS_TABLE(scalar, "scalar");
+
+bool bit_kernels_select(bit_kernels_level level){
+    switch (level){
+    case BIT_KERNELS_SCALAR:
+        bit_kernels = BIT_KERNELS_TABLE(scalar, "scalar");
+        return true;
+#ifdef BIT_KERNELS_X86
+    case BIT_KERNELS_AVX2:
+        __builtin_cpu_init();/*cpuid (also needed when called before main)*/
+        if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("popcnt"))return false;
+        bit_kernels = BIT_KERNELS_TABLE(avx2, "avx2");
+        return true;
+    case BIT_KERNELS_AVX512:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512vpopcntdq"))return false;
+        bit_kernels = BIT_KERNELS_TABLE(avx512, "avx512");
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+/*the best supported kernels are selected before main, so that the table is never written concurrently*/
+__attribute__((constructor)) static void bit_kernels_init(void){
+    if (!bit_kernels_select(BIT_KERNELS_AVX512))bit_kernels_select(BIT_KERNELS_AVX2);
+}
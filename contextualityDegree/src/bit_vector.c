@@ -14,8 +14,11 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <sys/mman.h>
 
 #include "bit_vector.h"
+#include "bit_kernels.h"
+#include "gf2.h"
 
 #include "constants.h"
 
@@ -68,19 +71,11 @@ bool bit_set_get_bit(bit_vector bs, size_t index) {
 }
 
 size_t bit_set_cardinality(bit_vector bs) {
-    size_t count = 0;
-    for (size_t i = 0; i < BIT_SET_ARR_SIZE(bs); i++) {
-        bit_set_type bits = bs.bits[i];
-        for (size_t j = 0; j < sizeof(bit_set_type)*8; j++) {
-            count += BGET(bits, j);
-        }
-    }
-    return count;
+    return bit_kernel_popcount(bs.bits, BIT_SET_ARR_SIZE(bs));
 }
 
 bool bit_set_is_empty(bit_vector bs) {
-    for (size_t i = 0; i < BIT_SET_ARR_SIZE(bs); i++)if (bs.bits[i] != 0)return false;
-    return true;
+    return bit_kernel_none(bs.bits, BIT_SET_ARR_SIZE(bs));
 }
 
 bit_vector bit_set_op(bit_vector bs1, bit_vector bs2,char op,bit_set_type* bits) {
@@ -91,15 +86,16 @@ bit_vector bit_set_op(bit_vector bs1, bit_vector bs2,char op,bit_set_type* bits)
 
     bit_vector result = bit_set_create(bs1.size, bits);
     
+    /*the operator only selects the kernel, which handles all the words*/
     switch (op) {
         case '&':
-            for (size_t i = 0; i < BIT_SET_ARR_SIZE(bs1); i++)result.bits[i] = bs1.bits[i] & bs2.bits[i];
+            bit_kernel_and(result.bits, bs1.bits, bs2.bits, BIT_SET_ARR_SIZE(bs1));
             break;
         case '|':
-            for (size_t i = 0; i < BIT_SET_ARR_SIZE(bs1); i++)result.bits[i] = bs1.bits[i] | bs2.bits[i];
+            bit_kernel_or(result.bits, bs1.bits, bs2.bits, BIT_SET_ARR_SIZE(bs1));
             break;
         case '^':
-            for (size_t i = 0; i < BIT_SET_ARR_SIZE(bs1); i++)result.bits[i] = bs1.bits[i] ^ bs2.bits[i];
+            bit_kernel_xor(result.bits, bs1.bits, bs2.bits, BIT_SET_ARR_SIZE(bs1));
             break;
         default:
             print("Invalid operator\n");
@@ -134,12 +130,7 @@ void print_bitset(bit_vector bs) {
 // Provided bit_vector definition and utility functions here...
 
 int bit_set_left_most(bit_vector bs) {
-    for (long i = bs.size-1; i >= 0; i--) {
-        if (bit_set_get_bit(bs, i)) {
-            return i;
-        }
-    }
-    return -1; // No set bit found
+    return bit_kernel_last_set(bs.bits, BIT_SET_ARR_SIZE(bs)); // -1 if no set bit found
 }
 
 bit_matrix bit_matrix_create(size_t size, size_t col_size) {
@@ -188,35 +179,22 @@ bool bit_matrix_equals(bit_matrix bm1, bit_matrix bm2) {
             return false;
         }
         
-        for (size_t j = 0; j < bm1.bit_sets[i].size; j++) {
-            if (bit_set_get_bit(bm1.bit_sets[i], j) != bit_set_get_bit(bm2.bit_sets[i], j)){
-                print("mismatch at %ld,%ld : %d != %d\n",i,j,bit_set_get_bit(bm1.bit_sets[i], j),bit_set_get_bit(bm2.bit_sets[i], j));
-                return false;
-            }
+        size_t words = BIT_SET_ARR_SIZE(bm1.bit_sets[i]);
+        if (bit_kernel_xor_popcount(bm1.bits[i], bm2.bits[i], words) == 0)continue;
+        /*the first differing word gives the reported bit*/
+        for (size_t w = 0; w < words; w++) {
+            bit_set_type diff = bm1.bits[i][w] ^ bm2.bits[i][w];
+            if (diff == 0)continue;
+            size_t j = w * 64 + __builtin_ctzll(diff);
+            print("mismatch at %ld,%ld : %d != %d\n",i,j,bit_set_get_bit(bm1.bit_sets[i], j),bit_set_get_bit(bm2.bit_sets[i], j));
+            return false;
         }
     }
     return true;
 }
 
 bit_matrix bit_matrix_product(bit_matrix bm1, bit_matrix bm2) {
-    if (bm1.bit_sets[0].size != bm2.size) {
-        print("BitMatrix column size must match row size of second matrix: %ld != %ld\n", bm1.bit_sets[0].size, bm2.size);
-        return (bit_matrix){0};
-    }
-
-    bit_matrix result = bit_matrix_create(bm1.size, bm2.bit_sets[0].size);
-
-    for (size_t i = 0; i < bm1.size; i++) {
-        for (size_t j = 0; j < bm2.bit_sets[0].size; j++) {
-            bool value = false;
-            for (size_t k = 0; k < bm1.bit_sets[0].size; k++) {
-                value ^= bit_matrix_get_bit(bm1, i, k) & bit_matrix_get_bit(bm2, k, j);
-            }
-            bit_matrix_set_bit(result, i, j, value);
-        }
-    }
-
-    return result;
+    return gf2_multiply(bm1, bm2);
 }
 
 bool bit_matrix_is_empty(bit_matrix bm) {
@@ -232,5 +210,10 @@ void bit_matrix_free(bit_matrix bm) {
 
     /*No bitset_free because the data is in bits*/
     free(bm.bit_sets);
+    if (bm.mapping != NULL){/*the rows are in the mapped file, only the row pointers are allocated*/
+        free(bm.bits);
+        munmap(bm.mapping, bm.mapping_size);
+        return;
+    }
     free_matrix(bm.bits);
 }
\ No newline at end of file
@@ -134,29 +134,22 @@ bv set_gate_custom(bv bv1,bv obs,int index,int n_qubits){
 
 bv set_gate(bv bv1,bv obs,int index){return set_gate_custom(bv1,obs,index,N_QUBITS);}
 
+const char GATE_CHARS[4] = {[I] = 'I',[X] = 'X',[Y] = 'Y',[Z] = 'Z'};
+
+size_t bv_to_chars(bv bv1,int n_qubits,char* buffer){
+  word z = get_Z(bv1,n_qubits),x = get_X(bv1,n_qubits);
+  for(int i = n_qubits - 1;i >= 0;i--,z >>= 1,x >>= 1)buffer[i] = GATE_CHARS[((z & 1) << 1) | (x & 1)];
+  return n_qubits;
+}
+
 void print_BV_to_file(bv bv1,int n_qubits,FILE* output){
-  for(size_t i = 0;i < (size_t)n_qubits;i++){
-    switch (get_gate(bv1,i,n_qubits)){
-    case I: fprintf(output,"I");break;
-    case X: fprintf(output,"X");break;
-    case Y: fprintf(output,"Y");break;
-    case Z: fprintf(output,"Z");break;
-    }
-  }
+  char buffer[n_qubits];
+  fwrite(buffer,1,bv_to_chars(bv1,n_qubits,buffer),output);
 }
 
 void print_BV_custom(bv bv1,int n_qubits){
-
-  print("[");
-  for(size_t i = 0;i < (size_t)n_qubits;i++){
-    switch (get_gate(bv1,i,n_qubits)){
-    case I: print("I");break;
-    case X: print("X");break;
-    case Y: print("Y");break;
-    case Z: print("Z");break;
-    }
-  }
-  print("]");
+  char buffer[n_qubits];
+  print("[%.*s]",(int)bv_to_chars(bv1,n_qubits,buffer),buffer);
 }
 void print_BV_W2(bv bv1){print_BV_custom(bv1,INDEX_DOILY_SIZE);}
 
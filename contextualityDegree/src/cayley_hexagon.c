@@ -28,7 +28,7 @@
 #include "constants.h"
 #include "complex_int.h"
 #include "quadrics.h"
-#include "hashset.h"
+#include "symplectic.h"
 #include "bit_vector.h"
 #include "config_checker.h"
 
@@ -65,35 +65,6 @@ bool points_aligned(bv bv1,bv bv2){
         (com(bv71,bv72,0,3) Qplus com(bv71,bv72,1,4) Qplus com(bv71,bv72,2,5)) == 0;
 }
 
-/**
- * @brief finds the index of the line passing through 3 points
- * 
- * @param a 
- * @param b 
- * @param c 
- * @param lines_indices 
- * @return size_t 
- */
-size_t get_line_index(bv a,bv b,bv c,size_t** lines_indices){
-    for (size_t i = 0; i < NB_LINES_PER_POINT_CUSTOM(N_QUBITS_HEX); i++){
-        for (size_t j = 0; j < NB_LINES_PER_POINT_CUSTOM(N_QUBITS_HEX); j++){
-            if(lines_indices[a][i] == lines_indices[b][j]){
-                for (size_t k = 0; k < NB_LINES_PER_POINT_CUSTOM(N_QUBITS_HEX); k++){
-                    if(lines_indices[b][j] == lines_indices[c][k]){
-                        return lines_indices[c][k];
-                    }
-                }
-                break;
-            }
-        }
-    }
-    print("\nerror line:");
-    print_BV_custom(a,N_QUBITS_HEX);
-    print_BV_custom(b,N_QUBITS_HEX);
-    print_BV_custom(c,N_QUBITS_HEX);
-    return 0;
-}
-
 /**
  * @brief computes the coordinate of a skew embedding of a split Cayley hexagon
  * from a classical one using this map
@@ -122,16 +93,16 @@ bv epsilon(bv bv1){
 /**
  * @brief computes the lines indices of embeddings of a split Cayley hexagon and its complement
  * 
- * @param permut 
+ * @param line_set 
  * @param set 
  * @param complement 
  */
-void indices_arrays_from_sets(hash_set_bitset permut,size_t* set,size_t* complement){
+void indices_arrays_from_sets(bit_vector line_set,size_t* set,size_t* complement){
     size_t set_index = 0,complement_index = 0;
 
     for (size_t i = 1; i <= NB_LINES_CUSTOM(N_QUBITS_HEX); i++)
     {
-        if (hash_set_bitset_get(permut, i))
+        if (bit_set_get_bit(line_set, i))
         {
             set[set_index] = i;
             set_index++;
@@ -147,193 +118,103 @@ void indices_arrays_from_sets(hash_set_bitset permut,size_t* set,size_t* complem
     }
 }
 
-
-hash_set _hexagon_set = {0};
-
-bool next_classical_cayley_hexagon(quantum_assignment lines_qa,size_t **lines_indices, quantum_assignment *qa, quantum_assignment *complement_qa)
-{
-    static int cpt_copies = 0;
-
-    static bv i = 0, j = 0;
-
-    static bv hexagon_indices[NB_LINES_CAYLEY_HEXAGON];
-
-    if (lines_qa.cpt_geometries != NB_LINES_CUSTOM(N_QUBITS_HEX))
-    {
+bool cayley_hexagon_iterator_init(cayley_hexagon_iterator* it,quantum_assignment lines_qa,bool skew){
+    if(lines_qa.cpt_geometries != NB_LINES_CUSTOM(N_QUBITS_HEX)){
         print("incorrect lines for hexagons\n");
         return false;
     }
 
-    /*if the function is called for the first time, we initialize the structures*/
-    if (_hexagon_set.list == NULL){
-
-        *qa = (quantum_assignment){
-            .geometries = lines_qa.geometries,
-            .cpt_geometries = NB_LINES_CAYLEY_HEXAGON,
-            .points_per_geometry = NB_POINTS_PER_LINE,
-            .n_qubits = N_QUBITS_HEX};
-        
-        qa->geometry_indices = calloc(NB_LINES_CAYLEY_HEXAGON,sizeof(size_t));
-
-        *complement_qa = (quantum_assignment){
-            .geometries = lines_qa.geometries,
-            .cpt_geometries = NB_LINES_CUSTOM(N_QUBITS_HEX) - NB_LINES_CAYLEY_HEXAGON,
-            .points_per_geometry = NB_POINTS_PER_LINE,
-            .n_qubits = N_QUBITS_HEX};
-
-        complement_qa->geometry_indices = calloc(NB_LINES_CUSTOM(N_QUBITS_HEX) - NB_LINES_CAYLEY_HEXAGON,sizeof(size_t));
-
-        /*We first initialize the hexagon formed by the equation in [HBS22]*/
-        size_t cpt = 0;
-        for (size_t i = 1; i <= NB_LINES_CUSTOM(N_QUBITS_HEX); i++){
-            bv a = lines_qa.geometries[i][0], b = lines_qa.geometries[i][1], c = lines_qa.geometries[i][2];
-            if (points_aligned(a, b) && points_aligned(b, c) && points_aligned(a, c)){
-                hexagon_indices[cpt] = i;
-
-                cpt++;
-            }
+    /*We first initialize the hexagon formed by the equation in [HBS22], or its skew embedding*/
+    bit_vector seed = bit_set_create(NB_LINES_CUSTOM(N_QUBITS_HEX) + 1,NULL);
+    line_table lines = line_table_create(lines_qa);
+    size_t cpt = 0;
+    for (size_t i = 1; i <= NB_LINES_CUSTOM(N_QUBITS_HEX); i++){
+        bv a = lines_qa.geometries[i][0], b = lines_qa.geometries[i][1], c = lines_qa.geometries[i][2];
+        if (points_aligned(a, b) && points_aligned(b, c) && points_aligned(a, c)){
+            bit_set_set_bit(seed, skew ? line_table_find(&lines, epsilon(a), epsilon(b)) : i, true);
+            cpt++;
         }
-        _hexagon_set = hash_set_init();
     }
-    
-    /*Using at least 2 transvections, it is possible to generate all the 120 classical embeddings of hexagons*/
-    for (; i < BV_LIMIT_CUSTOM(N_QUBITS_HEX); i++){
-        for (; j < BV_LIMIT_CUSTOM(N_QUBITS_HEX); j++){
-            hash_set_bitset permut = {0};
+    if(cpt != NB_LINES_CAYLEY_HEXAGON)print("cpt:%ld\n",cpt);
 
-            for (size_t k = 0; k < NB_LINES_CAYLEY_HEXAGON; k++)
-            {
-                bv a = lines_qa.geometries[hexagon_indices[k]][0], b = lines_qa.geometries[hexagon_indices[k]][1], c = lines_qa.geometries[hexagon_indices[k]][2];
+    /*the transvections generate all the 120 classical (or 7560 skew) embeddings from the first one*/
+    symplectic_orbit_iterator_init(&it->orbit, seed, lines_qa);
+    line_table_free(&lines);
+    bit_set_free(seed);
+    return true;
+}
 
-                a = transvection(j, transvection(i, a, N_QUBITS_HEX), N_QUBITS_HEX);
-                b = transvection(j, transvection(i, b, N_QUBITS_HEX), N_QUBITS_HEX);
-                c = transvection(j, transvection(i, c, N_QUBITS_HEX), N_QUBITS_HEX);
-                hash_set_bitset_add(&permut, get_line_index(a, b, c, lines_indices));
-            }
-            /*We check if the hexagon has already been generated*/
-            if(hash_set_exists(&_hexagon_set, permut))continue;
+void cayley_hexagon_assignments_init(quantum_assignment lines_qa,quantum_assignment *qa,quantum_assignment *complement_qa){
+    *qa = (quantum_assignment){
+        .geometries = lines_qa.geometries,
+        .cpt_geometries = NB_LINES_CAYLEY_HEXAGON,
+        .points_per_geometry = NB_POINTS_PER_LINE,
+        .n_qubits = N_QUBITS_HEX};
 
-            cpt_copies++;
+    qa->geometry_indices = calloc(NB_LINES_CAYLEY_HEXAGON,sizeof(size_t));
 
-            indices_arrays_from_sets(permut, qa->geometry_indices, complement_qa->geometry_indices);
-            free(qa->lines_negativity);
-            free(complement_qa->lines_negativity);
-            qa->lines_negativity = NULL;
-            complement_qa->lines_negativity = NULL;
-            quantum_assignment_compute_negativity(qa);
-            quantum_assignment_compute_negativity(complement_qa);
+    *complement_qa = (quantum_assignment){
+        .geometries = lines_qa.geometries,
+        .cpt_geometries = NB_LINES_CUSTOM(N_QUBITS_HEX) - NB_LINES_CAYLEY_HEXAGON,
+        .points_per_geometry = NB_POINTS_PER_LINE,
+        .n_qubits = N_QUBITS_HEX};
 
-            print("%d,", cpt_copies);
+    complement_qa->geometry_indices = calloc(NB_LINES_CUSTOM(N_QUBITS_HEX) - NB_LINES_CAYLEY_HEXAGON,sizeof(size_t));
 
-            return true;
-            
-        }
-        j = 0;
-    }
-
-    return false;
+    /*the signs of the hexagon lines are gathered from the ones of all the lines*/
+    quantum_assignment_inherit_negativity(qa, lines_qa);
+    quantum_assignment_inherit_negativity(complement_qa, lines_qa);
 }
 
-hash_set _skew_hexagon_set = {0};
+bool cayley_hexagon_iterator_next(cayley_hexagon_iterator* it,quantum_assignment *qa,quantum_assignment *complement_qa,size_t* index){
+    bit_set_type bits[BIT_SIZE(NB_LINES_CUSTOM(N_QUBITS_HEX) + 1)];
+    bit_vector line_set = bit_set_create(NB_LINES_CUSTOM(N_QUBITS_HEX) + 1,bits);
 
-bool next_skew_cayley_hexagon(quantum_assignment lines_qa, size_t **lines_indices, quantum_assignment *qa, quantum_assignment *complement_qa)
-{
-    static int skew_copies = 0;
+    if(!symplectic_orbit_iterator_next(&it->orbit, line_set, index))return false;
 
-    static bv i = 0, j = 0, k = 0, l = 0;
+    indices_arrays_from_sets(line_set, qa->geometry_indices, complement_qa->geometry_indices);
+    quantum_assignment_refresh_negativity(qa);
+    quantum_assignment_refresh_negativity(complement_qa);
+    return true;
+}
 
-    static bv skex_hexagon_indices[NB_LINES_CAYLEY_HEXAGON];
+void cayley_hexagon_iterator_free(cayley_hexagon_iterator* it){
+    symplectic_orbit_iterator_free(&it->orbit);
+}
 
-    if(lines_qa.cpt_geometries != NB_LINES_CUSTOM(N_QUBITS_HEX)){
-        print("incorrect lines for hexagons\n");
-        return false;
-    }
+cayley_hexagon_iterator _classical_hexagons = {0},_skew_hexagons = {0};
+bool _classical_hexagons_started = false,_skew_hexagons_started = false;
 
+bool next_classical_cayley_hexagon(quantum_assignment lines_qa,size_t **lines_indices, quantum_assignment *qa, quantum_assignment *complement_qa)
+{
+    (void)lines_indices;/*the lines are looked up in a pair table*/
     /*if the function is called for the first time, we initialize the structures*/
-    if (_skew_hexagon_set.list == NULL){
-
-        *qa = (quantum_assignment){
-            .geometries = lines_qa.geometries,
-            .cpt_geometries = NB_LINES_CAYLEY_HEXAGON,
-            .points_per_geometry = NB_POINTS_PER_LINE,
-            .n_qubits = N_QUBITS_HEX};
-
-        qa->geometry_indices = calloc(NB_LINES_CAYLEY_HEXAGON,sizeof(size_t));
-
-        *complement_qa = (quantum_assignment){
-            .geometries = lines_qa.geometries,
-            .cpt_geometries = NB_LINES_CUSTOM(N_QUBITS_HEX) - NB_LINES_CAYLEY_HEXAGON,
-            .points_per_geometry = NB_POINTS_PER_LINE,
-            .n_qubits = N_QUBITS_HEX};
-
-        complement_qa->geometry_indices = calloc(NB_LINES_CUSTOM(N_QUBITS_HEX) - NB_LINES_CAYLEY_HEXAGON,sizeof(size_t));
-
-        /*We first initialize the skew embedding of the first hexagon formed by the equation in [HBS22]*/
-        size_t cpt = 0;
-        for (size_t i = 1; i <= NB_LINES_CUSTOM(N_QUBITS_HEX); i++){
-            bv a = lines_qa.geometries[i][0], b = lines_qa.geometries[i][1], c = lines_qa.geometries[i][2];
-            if (points_aligned(a, b) && points_aligned(b, c) && points_aligned(a, c)){
-
-                bv sa = epsilon(a), sb = epsilon(b), sc = epsilon(c);
-                skex_hexagon_indices[cpt] = get_line_index(sa, sb, sc, lines_indices);
-
-                cpt++;
-            }
-        }
-
-        print("cpt:%ld\n",cpt);
-
-        _skew_hexagon_set = hash_set_init();
+    if (!_classical_hexagons_started){
+        if(!cayley_hexagon_iterator_init(&_classical_hexagons, lines_qa, false))return false;
+        cayley_hexagon_assignments_init(lines_qa, qa, complement_qa);
+        _classical_hexagons_started = true;
     }
 
-    /*Using at least 4 transvections, it is possible to generate all the 7560 skew embeddings of hexagons*/
-    for (/*i=0*/; i < BV_LIMIT_CUSTOM(N_QUBITS_HEX); i++){
-        for (/*j=i*/; j < BV_LIMIT_CUSTOM(N_QUBITS_HEX); j++){
-            for (/*k=j*/; k < BV_LIMIT_CUSTOM(N_QUBITS_HEX); k++){
-                for (/*l=k*/; l < BV_LIMIT_CUSTOM(N_QUBITS_HEX); l++){
-
-                    hash_set_bitset permut = {0};
-
-                    for (size_t m = 0; m < NB_LINES_CAYLEY_HEXAGON; m++)
-                    {
-                        bv a = lines_qa.geometries[skex_hexagon_indices[m]][0], b = lines_qa.geometries[skex_hexagon_indices[m]][1], c = lines_qa.geometries[skex_hexagon_indices[m]][2];
+    size_t index;
+    if(!cayley_hexagon_iterator_next(&_classical_hexagons, qa, complement_qa, &index))return false;
+    print("%ld,", index + 1);
+    return true;
+}
 
-                        a = transvection(l, transvection(k, transvection(j, transvection(i, a, N_QUBITS_HEX), N_QUBITS_HEX), N_QUBITS_HEX), N_QUBITS_HEX);
-                        b = transvection(l, transvection(k, transvection(j, transvection(i, b, N_QUBITS_HEX), N_QUBITS_HEX), N_QUBITS_HEX), N_QUBITS_HEX);
-                        c = transvection(l, transvection(k, transvection(j, transvection(i, c, N_QUBITS_HEX), N_QUBITS_HEX), N_QUBITS_HEX), N_QUBITS_HEX);
-                        hash_set_bitset_add(&permut, get_line_index(a, b, c, lines_indices));
-                    }
-                    /*We check if the hexagon has already been generated*/
-                    if (hash_set_exists(&_skew_hexagon_set, permut))continue;
-                    
-                    skew_copies++;
-                    indices_arrays_from_sets(permut, qa->geometry_indices, complement_qa->geometry_indices);
-                    free(qa->lines_negativity);
-                    free(complement_qa->lines_negativity);
-                    qa->lines_negativity = NULL;
-                    complement_qa->lines_negativity = NULL;
-                    quantum_assignment_compute_negativity(qa);
-                    quantum_assignment_compute_negativity(complement_qa);
-                    
-                    return true;
-                    
-                    
-                }
-                l = k;
-            }
-            k = j;
-        }
-        j = i;
+bool next_skew_cayley_hexagon(quantum_assignment lines_qa, size_t **lines_indices, quantum_assignment *qa, quantum_assignment *complement_qa)
+{
+    (void)lines_indices;/*the lines are looked up in a pair table*/
+    if (!_skew_hexagons_started){
+        if(!cayley_hexagon_iterator_init(&_skew_hexagons, lines_qa, true))return false;
+        cayley_hexagon_assignments_init(lines_qa, qa, complement_qa);
+        _skew_hexagons_started = true;
     }
-
-    return false;
+    return cayley_hexagon_iterator_next(&_skew_hexagons, qa, complement_qa, NULL);
 }
 
 void free_cayley_hexagons()
 {
-    hash_set_free(&_hexagon_set);
-    _hexagon_set.list = NULL;
-    hash_set_free(&_skew_hexagon_set);
-    _skew_hexagon_set.list = NULL;
+    if(_classical_hexagons_started)cayley_hexagon_iterator_free(&_classical_hexagons);
+    if(_skew_hexagons_started)cayley_hexagon_iterator_free(&_skew_hexagons);
+    _classical_hexagons_started = _skew_hexagons_started = false;
 }
-
@@ -29,8 +29,6 @@ SYMMETRIC
 
 #include "quantum_assignment.h"
 
-#define CONFIG_MAX_DEG 20000000
-
 bool (*mode_filters[])(quantum_assignment, int, int *, int *) = {
     mode_nothing_filter,
     mode_all_filter,
@@ -58,7 +56,8 @@ bool mode_point_degree_filter(quantum_assignment qa,int i,int* param,int* sorted
 bool mode_observable_value_filter(quantum_assignment qa,int i,int* param,int* sorted_tab){
     (void)sorted_tab;
     for (size_t j = 0; j < qa.points_per_geometry; j++)
-        if (qa.geometries[qa.geometry_indices[i]][j] == (bv)param[0])
+        if ((qa.wide_observables != NULL ? qa.geometries[qa.geometry_indices[i]][j] /*point id*/
+                                          : quantum_assignment_observable(&qa,qa.geometries[qa.geometry_indices[i]][j])) == (bv)param[0])
             return true;
     return false;
 }
@@ -72,7 +71,7 @@ bool mode_line_degree_filter(quantum_assignment qa,int i,int* param,int* sorted_
 bool mode_symmetric_filter(quantum_assignment qa,int i,int* param,int* sorted_tab){
     (void)param;(void)sorted_tab;
     for (size_t j = 0; j < qa.points_per_geometry; j++)
-        if (!is_symmetric(qa.geometries[qa.geometry_indices[i]][j], qa.n_qubits))
+        if (!quantum_assignment_point_is_symmetric(&qa,qa.geometries[qa.geometry_indices[i]][j]))
             return false;
     return true;
 }
@@ -84,71 +83,109 @@ void swap(int *a, int *b)
     *b = tmp;
 }
 
-void compute_invalid_lines(quantum_assignment qa, bool *bool_sol, bool **invalid_lines, int **number_of_invalid_lines)
+invalid_stats invalid_stats_init(const quantum_assignment *qa, const bool *bool_sol)
 {
-    /*true for each invalid line*/
-    (*invalid_lines) = (bool *)calloc(qa.cpt_geometries, sizeof(bool));
-    if (!(*invalid_lines)){
+    invalid_stats stats = {
+        .n_points = quantum_assignment_n_points(qa),
+        .cpt_geometries = qa->cpt_geometries,
+        .invalid_lines = (bool *)calloc(qa->cpt_geometries, sizeof(bool)),
+        .degrees = (int *)calloc(quantum_assignment_n_points(qa), sizeof(int))
+    };
+    if (!stats.invalid_lines || !stats.degrees){
         print("ERROR: invalid lines allocation\n");
-        return;
+        return stats;
     }
-    /*number of invalid lines per point*/
-    (*number_of_invalid_lines) = (int *)calloc(BV_LIMIT_CUSTOM(qa.n_qubits), sizeof(int));
-    if (!(*number_of_invalid_lines)){
-        print("ERROR: invalid lines allocation\n");
-        free(*invalid_lines);
-        return;
+
+    /*the histogram is sized by the maximum number of lines through a point*/
+    for (size_t i = 0; i < qa->cpt_geometries; i++)
+    {
+        const bv *line = qa->geometries[qa->geometry_indices[i]];
+        for (size_t j = 0; j < qa->points_per_geometry && line[j] != I; j++)
+            stats.max_degree = MAX(stats.max_degree, ++stats.degrees[line[j]]);
     }
+    memset(stats.degrees, 0, stats.n_points * sizeof(int));
+    stats.degree_counts = (int *)calloc(stats.max_degree + 1, sizeof(int));
 
-    for (size_t i = 0; i < qa.cpt_geometries; i++)
+    for (size_t i = 0; i < qa->cpt_geometries; i++)
     {
         bool test = false;
-        for (size_t j = 0; j < qa.points_per_geometry; j++)
+        for (size_t j = 0; j < qa->points_per_geometry; j++)
         {
-            test ^= bool_sol[qa.geometries[qa.geometry_indices[i]][j]];
-        }
-        (*invalid_lines)[i] = (test != qa.lines_negativity[i]);
-        if (!(*invalid_lines)[i])
-            continue;
-
-        for (size_t j = 0; j < qa.points_per_geometry; j++)
-        {
-            (*number_of_invalid_lines)[qa.geometries[qa.geometry_indices[i]][j]]++;
+            test ^= bool_sol[qa->geometries[qa->geometry_indices[i]][j]];
         }
+        if (test != qa->lines_negativity[i])
+            invalid_stats_flip_line(&stats, qa, i);
     }
+    invalid_stats_refresh(&stats);
+    return stats;
+}
+
+void invalid_stats_flip_line(invalid_stats *stats, const quantum_assignment *qa, size_t line_index)
+{
+    bool invalid = !stats->invalid_lines[line_index];
+    invalid_stats_set_line(stats, line_index, invalid);
+
+    const bv *line = qa->geometries[qa->geometry_indices[line_index]];
+    for (size_t j = 0; j < qa->points_per_geometry && line[j] != I; j++)
+        invalid_stats_add_degree(stats, line[j], invalid ? +1 : -1);
+}
+
+void invalid_stats_refresh(invalid_stats *stats)
+{
+    memset(stats->degree_counts, 0, (stats->max_degree + 1) * sizeof(int));
+    for (size_t p = 1; p < stats->n_points; p++)
+        stats->degree_counts[stats->degrees[p]]++;
+    stats->vertices = (int)(stats->n_points - 1) - stats->degree_counts[0];
 }
 
-int get_table_index(int **table, int *line, size_t nb_points_per_line)
+bool invalid_stats_is_regular(const invalid_stats *stats, int degree)
 {
-    for (size_t i = 0; i < CONFIG_MAX_DEG; i++)
+    return degree > 0 && degree <= stats->max_degree &&
+           stats->vertices > 0 && stats->degree_counts[degree] == stats->vertices;
+}
+
+void invalid_stats_free(invalid_stats *stats)
+{
+    free(stats->invalid_lines);
+    free(stats->degrees);
+    free(stats->degree_counts);
+    *stats = (invalid_stats){0};
+}
+
+line_categories line_categories_init(size_t points_per_geometry)
+{
+    return (line_categories){
+        .types = hash_set_init_custom(points_per_geometry),
+        .counts = NULL,
+        .capacity = 0,
+        .points_per_geometry = points_per_geometry};
+}
+
+size_t line_categories_add(line_categories *categories, const int *degrees)
+{
+    hash_set_store_type key[categories->points_per_geometry];
+    for (size_t j = 0; j < categories->points_per_geometry; j++)
+        key[j] = (hash_set_store_type)degrees[j];
+
+    bool added;
+    size_t id = hash_set_find_or_add(&categories->types, key, &added);
+    if (added && id >= categories->capacity)
     {
-        bool valid = true;
-        bool all_zeroes = true;
-        for (size_t j = 0; j < nb_points_per_line; j++)
-        {
-            if (table[i][j] != 0)
-                all_zeroes = false; // we check at the same time if the entry is empty
-            if (table[i][j] != line[j])
-            {
-                valid = false;
-                if (!all_zeroes)
-                    break;
-            }
-        }
-        if (valid)
-            return i; // if found return index
-        if (all_zeroes)
-        { // else we create that entry
-            for (size_t j = 0; j < nb_points_per_line; j++)
-            {
-                table[i][j] = line[j];
-            }
-            return i;
-        }
+        categories->capacity = MAX(2 * categories->capacity, 16);
+        categories->counts = realloc(categories->counts, categories->capacity * sizeof(int));
     }
-    print("\n\nERROR: table overflow\n");
+    if (added)
+        categories->counts[id] = 0;
+    categories->counts[id]++;
+    return id;
+}
 
-    return -1;
+void line_categories_free(line_categories *categories)
+{
+    hash_set_free(&categories->types);
+    free(categories->counts);
+    categories->counts = NULL;
+    categories->capacity = 0;
 }
 
 int compare_integers_increasing(const void *a, const void *b)
@@ -156,27 +193,21 @@ int compare_integers_increasing(const void *a, const void *b)
     return (*(int *)a - *(int *)b);
 }
 
-void print_category_list(int **category_list, int *category_count, quantum_assignment qa)
+void line_categories_print(const line_categories *categories)
 {
     print("\n\nLine degree types:\n");
     
-    for (int i = 0; i < CONFIG_MAX_DEG; i++)
+    for (size_t i = 0; i < categories->types.cpt_keys; i++)
     {
-        bool all_zeroes = true;
-        
-        for (size_t j = 0; j < qa.points_per_geometry; j++){
-            if (category_list[i][j] != 0)all_zeroes = false;
-        }
-        if (all_zeroes)break;         
-
+        const hash_set_store_type *degrees = hash_set_key(&categories->types, i);
         print("[");
-        for (size_t j = 0; j < qa.points_per_geometry; j++)
+        for (size_t j = 0; j < categories->points_per_geometry; j++)
         {
-            print("%d", category_list[i][j]);
-            if (j < qa.points_per_geometry - 1)
+            print("%d", (int)degrees[j]);
+            if (j < categories->points_per_geometry - 1)
                 print(",");
         }
-        print("] (x%d)\n", category_count[i]);
+        print("] (x%d)\n", categories->counts[i]);
     }
 }
 
@@ -197,6 +228,16 @@ mode ask_mode(quantum_assignment qa, int *param)
         print("\nobservable value: ");
         nul += scanf("%s", str);
         param[0] = str_to_bv_custom(str, qa.n_qubits);
+        if (qa.wide_observables != NULL)
+        {/*wide observables are looked for among the points*/
+            size_t words = WIDE_BV_WORDS(qa.n_qubits);
+            wide_word observable[words];
+            wide_bv_parse(str, qa.n_qubits, observable);
+            param[0] = -1;
+            for (size_t p = 1; p < qa.n_observables && param[0] == -1; p++)
+                if (memcmp(qa.wide_observables + p * words, observable, sizeof(observable)) == 0)
+                    param[0] = p;
+        }
     }
     else if (mode == MODE_LINE_DEGREE)
     {
@@ -230,11 +271,11 @@ void set_order(quantum_assignment qa, int *obs_specific_type_degree,int index,in
     }
 }
 
-int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *number_of_invalid_lines, mode m, int *param, bool *line_filter, int **obs_specific_type_degree,int** category_count, int ***category_list)
+int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *number_of_invalid_lines, mode m, int *param, bool *line_filter, int **obs_specific_type_degree,line_categories *categories)
 {
     bool *is_line_in_specific_type = calloc(qa.cpt_geometries, sizeof(bool));
 
-    *obs_specific_type_degree = calloc(BV_LIMIT_CUSTOM(qa.n_qubits), sizeof(int));
+    *obs_specific_type_degree = calloc(quantum_assignment_n_points(&qa), sizeof(int));
     if (!(*obs_specific_type_degree))
     {
         print("ERROR: obs_specific_type_degree allocation\n");
@@ -248,11 +289,7 @@ int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *
 
         int sorted_tab[qa.points_per_geometry];
         for (size_t j = 0; j < qa.points_per_geometry; j++)
-        {
             sorted_tab[j] = number_of_invalid_lines[qa.geometries[qa.geometry_indices[i]][j]];
-            if (sorted_tab[j] >= CONFIG_MAX_DEG)
-                print("\noverflow error!(%d)\n", sorted_tab[j]);
-        }
         qsort(sorted_tab, qa.points_per_geometry, sizeof(int), compare_integers_increasing);
 
         if (!mode_filters[m](qa,i,param,sorted_tab))continue;
@@ -271,16 +308,9 @@ int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *
         print("\nOn the right: degree of the points relative to the whole invalid configuration\n");
         print("\n\nspecific / obs / general");
     }
-    /*number of lines with that category*/
-    *category_count = calloc(CONFIG_MAX_DEG, sizeof(int));
     /*for each type of invalid line, determined by the degrees of its vertices, we count the
     number of lines with that type*/
-    *category_list = (int **)init_matrix(CONFIG_MAX_DEG, qa.points_per_geometry, sizeof(int));
-
-    
-    
-
-    int max_index = 0;
+    *categories = line_categories_init(qa.points_per_geometry);
 
     for (size_t i = 0; i < qa.cpt_geometries; i++)
     {
@@ -304,9 +334,7 @@ int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *
         int line[qa.points_per_geometry];
         for (size_t j = 0; j < qa.points_per_geometry; j++)
             line[j] = (*obs_specific_type_degree)[qa.geometries[qa.geometry_indices[i]][order[j]]];
-        int index = get_table_index(*category_list, line, qa.points_per_geometry);
-        (*category_count)[index]++;
-        if (index > max_index)max_index = index;
+        line_categories_add(categories, line);
 
         if (!to_print)continue;
 
@@ -314,90 +342,81 @@ int filter_lines(bool to_print,quantum_assignment qa, bool *invalid_lines, int *
         for (size_t j = 0; j < qa.points_per_geometry; j++)
             print("%d ", (*obs_specific_type_degree)[qa.geometries[qa.geometry_indices[i]][order[j]]]);
         for (size_t j = 0; j < qa.points_per_geometry; j++)
-            print_BV_custom(qa.geometries[qa.geometry_indices[i]][order[j]], qa.n_qubits);
+        {
+            print("[");
+            quantum_assignment_print_point(&qa,qa.geometries[qa.geometry_indices[i]][order[j]],stderr);
+            print("]");
+        }
         for (size_t j = 0; j < qa.points_per_geometry; j++)
             print(" %d", number_of_invalid_lines[qa.geometries[qa.geometry_indices[i]][order[j]]]);
     }
-    return max_index+1;
+    free(is_line_in_specific_type);
+    return categories->types.cpt_keys;
 }
 
-int check_structure(quantum_assignment* qa, bool *bool_sol, bool to_print, bool *line_filter)
+int check_structure_stats(quantum_assignment* qa, invalid_stats *stats, bool to_print, bool *line_filter)
 {
-
-    quantum_assignment_compute_negativity(qa);
-
-    
-    
     int ccpt = 0;
     if (to_print && line_filter != NULL)
         for (size_t i = 0; i < (size_t)NB_LINES_CUSTOM(qa->n_qubits); i++)
             ccpt++;
 
-    
-
-    bool *invalid_lines = NULL;
-    int *number_of_invalid_lines = NULL;
-    compute_invalid_lines(*qa, bool_sol, &invalid_lines, &number_of_invalid_lines);
-
     mode m = 1;
     int param[qa->points_per_geometry];
     if (to_print && global_interact_with_user)m = ask_mode(*qa, param);
 
     int *obs_specific_type_degree = NULL;
-    int *category_count = NULL;
-    int **category_list = NULL;
+    line_categories categories;
 
-    int complexity_degree = filter_lines(to_print, *qa, invalid_lines, number_of_invalid_lines, m, param, line_filter, &obs_specific_type_degree, &category_count, &category_list);
+    int complexity_degree = filter_lines(to_print, *qa, stats->invalid_lines, stats->degrees, m, param, line_filter, &obs_specific_type_degree, &categories);
     //second_filter(to_print, obs_specific_type_degree, is_line_in_specific_type, number_of_invalid_lines, qa, );
-    //print("[[%d]]\n", category_list[0][0]);
 
     /*for each number of invalid lines, we count the number of points with that number of invalid lines*/
-    int *number_of_obs_with_degree = calloc(qa->cpt_geometries, sizeof(int));
-
-    for (bv i = 1; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)
-        number_of_obs_with_degree[number_of_invalid_lines[i]]++;
+    invalid_stats_refresh(stats);
 
     if (to_print)print("\nPoint degree types:\n");
 
-    for (size_t i = 1; i < qa->cpt_geometries; i++)
+    for (int i = 1; i <= stats->max_degree; i++)
     {
-        if (to_print && number_of_obs_with_degree[i] != 0)
-            print("degree %ld (x%d);", i, number_of_obs_with_degree[i]);
+        if (to_print && stats->degree_counts[i] != 0)
+            print("degree %d (x%d);", i, stats->degree_counts[i]);
     }
 
     if (to_print)print("\n\nspecific degrees : ");
 
     /*for each present point degree, we count the number of points with that degree*/
-    int *cpt_specific_degrees = calloc(qa->cpt_geometries, sizeof(int));
+    int *cpt_specific_degrees = calloc(qa->cpt_geometries + 1, sizeof(int));
 
-    for (bv j = 0; j < BV_LIMIT_CUSTOM(qa->n_qubits); j++)
+    for (bv j = 0; j < quantum_assignment_n_points(qa); j++)
         cpt_specific_degrees[obs_specific_type_degree[j]]++;
 
     if (to_print)
-        for (size_t i = 1; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)
+        for (size_t i = 1; i < qa->cpt_geometries; i++)
             if (cpt_specific_degrees[i] != 0)
                 print("%ld(x%d)", i, cpt_specific_degrees[i]);
 
-    int vertices_count = 0;
-    for (size_t i = 0; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)
-        if (number_of_invalid_lines[i] > 0)
-            vertices_count++;
-
     if (to_print)
-        print("\n\nNumber of vertices in the invalid configuration: %d ; \n", vertices_count);
+        print("\n\nNumber of vertices in the invalid configuration: %d ; \n", stats->vertices);
 
-    if(to_print)print_category_list(category_list, category_count, *qa);
+    if(to_print)line_categories_print(&categories);
 
     if (to_print
     )print("Number of different line types: %d\n", complexity_degree);
 
-    free_matrix(category_list);
-    free(category_count);
-    free(number_of_invalid_lines);
-    free(invalid_lines);
+    line_categories_free(&categories);
     free(obs_specific_type_degree);
-    free(number_of_obs_with_degree);
     free(cpt_specific_degrees);
 
+    return complexity_degree;
+}
+
+int check_structure(quantum_assignment* qa, bool *bool_sol, bool to_print, bool *line_filter)
+{
+    quantum_assignment_compute_negativity(qa);
+
+    invalid_stats stats = invalid_stats_init(qa, bool_sol);
+    int complexity_degree = check_structure_stats(qa, &stats, to_print, line_filter);
+    invalid_stats_free(&stats);
+
     return complexity_degree;
 }
\ No newline at end of file
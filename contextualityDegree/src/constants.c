@@ -32,12 +32,17 @@ void implement_sigint(){
 
 void** init_matrix(size_t dim1,size_t dim2,size_t size){
     if(dim1 == 0 || dim2 == 0 || size == 0)return NULL;
-    void** res = dim1>0?calloc(dim1,sizeof(void*)):NULL;
-    void* sub_array = calloc(dim1*dim2,size);
+    void** res = calloc(dim1,sizeof(void*));
+    void* sub_array = (dim2 > SIZE_MAX / dim1) ? NULL : calloc(dim1*dim2,size);
+    if(res == NULL || sub_array == NULL){
+        print("matrix allocation error : %ld %ld\n",dim1,dim2);
+        free(res);
+        free(sub_array);
+        return NULL;
+    }
     for (size_t i = 0; i < dim1; i++){
         res[i] = (sub_array+(i*dim2*size));/**size since it cannot know the type*/
     }
-    if(res == NULL || sub_array == NULL)print("matrix allocation error : %ld %ld\n",dim1,dim2);
     return res;
 }
 
@@ -18,6 +18,8 @@
 #include "bv.h"
 #include "quantum_assignment.h"
 #include "config_checker.h"
+#include "gf2.h"
+#include "results_cache.h"
 
 #define HEURISTIC_NUM_THREADS (MULTI_THREAD ? (9) : (1)) // number of threads to use for the heuristic method
 
@@ -25,6 +27,8 @@ solver_mode global_solver_mode = SAT_SOLVER;
 size_t global_heuristic_iterations = 10000; //maximum number of iterations for the heuristic method
 float global_heuristic_flip_probability = 0.95;   //probability of choosing a random assignment in the heuristic method
 float global_heuristic_threshold = DISABLED_PARAMETER;          // threshold for the heuristic method
+int global_heuristic_stop_regular = DISABLED_INT_PARAMETER;         // degree of the regular invalid configurations stopping the heuristic method
+const char* global_cache_directory = NULL;                      // directory of the results cache, NULL if disabled
 
 
 bool rand_float(float p) {
@@ -34,13 +38,12 @@ bool rand_float(float p) {
 
 
 void print_bool(bool* arr,size_t size){
-    for (size_t i = 0; i < size/4; i++)
+    for (size_t i = 0; i < (size + 3)/4; i++)/*the last character holds the remaining bits*/
     {
         char c = 'a';
-        for (size_t j = 0; j < 4; j++)
+        for (size_t j = 0; j < 4 && i*4+j < size; j++)
         {
             size_t index = i*4+j;
-            if(index >= size)return;
             c += (arr[index])<<j;
             //print("%d %d,",j,arr[index]);
         }
@@ -49,23 +52,35 @@ void print_bool(bool* arr,size_t size){
     print("\n");
 }
 
-void parse_bool(bool* arr,size_t size){
-    print("enter a solution : ");
-    char str[/* (size/4)+1+1 */10000];
-    int ret = scanf("%s",str);
-    if(ret == 0)return;
-    for (size_t i = 0; i < size/4; i++)
+bool parse_solution_code(const char* code,bool* arr,size_t size){
+    for (size_t i = 0; i < (size + 3)/4 && code[i] != '\0'; i++)/*shorter codes leave the last bits unchanged*/
     {
-        char c = str[i];
-        if(c < 'a' || c > 'z')return;
+        char c = code[i];
+        if(c < 'a' || c > 'p')return false;
         c -= 'a';
-        for (size_t j = 0; j < 4; j++)
-        {
-            size_t index = i*4+j;
-            if(index >= size)return;
-            arr[index] = BGET(c,j);
-        }
+        for (size_t j = 0; j < 4 && i*4+j < size; j++)
+            arr[i*4+j] = BGET(c,j);
+    }
+    return true;
+}
+
+size_t solution_code_to_chars(const bool* arr,size_t size,char* buffer){
+    size_t length = (size + 3)/4;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = 'a';
+        for (size_t j = 0; j < 4 && i*4+j < size; j++)c += (arr[i*4+j])<<j;
+        buffer[i] = c;
     }
+    return length;
+}
+
+void parse_bool(bool* arr,size_t size){
+    print("enter a solution : ");
+    char str[/* (size/4)+1+1 */10000];
+    int ret = scanf("%9999s",str);
+    if(ret != 1)return;
+    parse_solution_code(str,arr,size);
 }
 
 
@@ -87,7 +102,7 @@ int check_contextuality_solution(quantum_assignment* qa,bool* bool_sol,FILE* out
             for (size_t j = 0; j < qa->points_per_geometry; j++){
                 bv bv1 = qa->geometries[qa->geometry_indices[i]][j];
                 if (bv1 == I)break;
-                print_BV_to_file(bv1, qa->n_qubits, output);
+                quantum_assignment_print_point(qa, bv1, output);
                 fprintf(output, "(%s)", bool_sol[bv1] ? "-1" : "+1");
             }
         if(to_print)fprintf(output,"  =>  ");
@@ -167,7 +182,7 @@ int compute_contextuality_solution(quantum_assignment* qa,char* bc2cnf_file,char
 
     fclose(fp);
 
-    bool *bool_sol = calloc(BV_LIMIT_CUSTOM(qa->n_qubits), sizeof(bool));
+    bool *bool_sol = calloc(quantum_assignment_n_points(qa), sizeof(bool));
 
     regfree(&sat_re);
     regex_t re;
@@ -208,7 +223,7 @@ int compute_contextuality_solution(quantum_assignment* qa,char* bc2cnf_file,char
     int res = check_contextuality_solution(qa,bool_sol,output);
 
     if(ret_sol != NULL)
-        for (size_t i = 0; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)ret_sol[i] = bool_sol[i];
+        for (size_t i = 0; i < quantum_assignment_n_points(qa); i++)ret_sol[i] = bool_sol[i];
 
     free(sat_neg);
     free(bool_sol);
@@ -242,9 +257,8 @@ void write_line(FILE *f,bv* geometry,bool negative,int points_per_geometry){
 
 int max_line_per_point(quantum_assignment* qa){
 
-    int cpt[BV_LIMIT_CUSTOM(qa->n_qubits)];
+    int *cpt = calloc(quantum_assignment_n_points(qa),sizeof(int));
     int max = 0;
-    for (size_t i = 0; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)cpt[i] = 0;
     
     for (size_t i = 0; i < qa->cpt_geometries; i++){
         for (size_t j = 0; j < qa->points_per_geometry; j++){
@@ -258,6 +272,7 @@ int max_line_per_point(quantum_assignment* qa){
             }
         }
     }
+    free(cpt);
     return max;
 }
 
@@ -269,10 +284,10 @@ int **compute_contexts_per_obs(quantum_assignment *qa, bool print_solution){
     
 
     /*stores for every observable the contexts it is present in*/
-    int **line_per_obs = (int **)init_matrix(BV_LIMIT_CUSTOM(qa->n_qubits), max_line_per_obs, sizeof(int));
+    int **line_per_obs = (int **)init_matrix(quantum_assignment_n_points(qa), max_line_per_obs, sizeof(int));
     if (print_solution)print(".");
     /*initializes the matrix with empty lines*/
-    for (size_t i = 0; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)
+    for (size_t i = 0; i < quantum_assignment_n_points(qa); i++)
         for (size_t j = 0; j < max_line_per_obs; j++)
             line_per_obs[i][j] = -1;
 
@@ -300,7 +315,33 @@ int **compute_contexts_per_obs(quantum_assignment *qa, bool print_solution){
     return line_per_obs;
 }
 
+solver_options solver_options_global(void){
+    return (solver_options){
+        .mode = global_solver_mode,
+        .heuristic_iterations = global_heuristic_iterations,
+        .heuristic_flip_probability = global_heuristic_flip_probability,
+        .heuristic_threshold = global_heuristic_threshold,
+        .heuristic_stop_regular = global_heuristic_stop_regular,
+        .cache_directory = global_cache_directory,
+        .time_limit = DISABLED_PARAMETER
+    };
+}
+
+const char* solver_mode_name(solver_mode mode){
+    switch (mode){
+    case SAT_SOLVER:return "sat";
+    case RETRIEVE_SOLUTION:return "retrieve";
+    case INVALID_LINES_HEURISTIC_SOLVER:return "heuristic";
+    }
+    return "none";
+}
+
 int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,bool print_solution,bool* ret_sol){
+    solver_options options = solver_options_global();
+    return geometry_contextuality_degree_heuristics_options(qa, print_solution, &options, ret_sol);
+}
+
+int geometry_contextuality_degree_heuristics_options(quantum_assignment* qa,bool print_solution,const solver_options* options,bool* ret_sol){
 
     //initializes timer
     struct timespec start, end;
@@ -309,8 +350,9 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
     if(print_solution)print("\n.");
     
 
-    bool min_sol[BV_LIMIT_CUSTOM(qa->n_qubits)];
-    for (size_t i = 0; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)min_sol[i] = false;
+    /*the arrays are indexed by the points of the assignment*/
+    const size_t n_points = quantum_assignment_n_points(qa);
+    bool *min_sol = calloc(n_points,sizeof(bool));
 
     
 
@@ -320,54 +362,51 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
     if (print_solution)print(".\n");
 
     int global_min = qa->cpt_geometries;//negative_lines_count(qa);
+
+    /*a warm start (typically a cached solution) is the first best solution of every thread*/
+    if(options->initial_solution != NULL){
+        memcpy(min_sol,options->initial_solution,n_points*sizeof(bool));
+        global_min = check_contextuality_solution(qa,min_sol,NULL);
+    }
     int test_th_global_min = global_min;
 
     int nth_sol_global = 0;
     
 
-    bool auto_threshold = global_heuristic_threshold == DISABLED_PARAMETER;
+    bool auto_threshold = options->heuristic_threshold == DISABLED_PARAMETER;
 
     float max_threshold = 1.0f;
-    float optimal_threshold = auto_threshold?0.85f:global_heuristic_threshold;
+    float optimal_threshold = auto_threshold?0.85f:options->heuristic_threshold;
     float min_threshold = 0.0f;
     float range_radius = 1.0f;
 
+    /*set by the thread finding a regular invalid configuration, the other searches going on*/
+    volatile bool stop = false;
+
 
     #pragma omp parallel num_threads(HEURISTIC_NUM_THREADS)
     {
-        int n_invalid[BV_LIMIT_CUSTOM(qa->n_qubits)];
-        bool bool_sol[BV_LIMIT_CUSTOM(qa->n_qubits)];
-        
-
-        for (size_t j = 0; j < BV_LIMIT_CUSTOM(qa->n_qubits); j++){
-            n_invalid[j] = 0;
-            bool_sol[j] = false;//fast_random() % 2;
-        }
+        bool *bool_sol = calloc(n_points,sizeof(bool));//fast_random() % 2;
+        if(options->initial_solution != NULL)memcpy(bool_sol,options->initial_solution,n_points*sizeof(bool));
 
         int hamming_test = check_contextuality_solution(qa,bool_sol,NULL);
 
-        for (size_t i = 0; i < qa->cpt_geometries; i++){/*At the beginning, the number of invalid contexts for each observable is the number of negative contexts*/
-            bool sign = false;
-            for (size_t j = 0; j < qa->points_per_geometry; j++){
-                sign ^= bool_sol[qa->geometries[qa->geometry_indices[i]][j]];
-            }
-            
-            if(qa->lines_negativity[i] != sign){  
-            
-                for (size_t j = 0; j < qa->points_per_geometry; j++){
-                    bv bv1 = qa->geometries[qa->geometry_indices[i]][j];
-                    if(bv1 == I)break;
-                    n_invalid[bv1]++;
-                }
-            }
-        }
+        /*At the beginning, the number of invalid contexts for each observable is the number of negative contexts.
+        The statistics of the invalid configuration are then updated with each flip*/
+        invalid_stats stats = invalid_stats_init(qa, bool_sol);
+        int *n_invalid = stats.degrees;
         int current_max = 0;
 
         int n_neg = 0;
 
-        for (size_t cpt = 0; cpt < global_heuristic_iterations && !is_done; cpt++){
-            
+        for (size_t cpt = 0; cpt < options->heuristic_iterations && !is_done && !stop; cpt++){
             
+            /*the time budget is shared by the threads, the first one exceeding it stopping them all*/
+            if(options->time_limit != DISABLED_PARAMETER){
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                if((now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9 > options->time_limit)stop = true;
+            }
             
             int old_current_max = current_max;
             current_max = 0;/*maximum number of invalid contexts found for a single observable*/
@@ -390,7 +429,7 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
                 }
             }
             float threshold_select;
-            float rand_select = global_heuristic_flip_probability;
+            float rand_select = options->heuristic_flip_probability;
             
             if (auto_threshold){/*every thread gets its different threshold*/
                 float th_ratio = (float)omp_get_thread_num() / omp_get_num_threads();
@@ -399,9 +438,11 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
                 if (omp_get_num_threads() == 1) threshold_select = optimal_threshold;
             }
             else{
-                threshold_select = global_heuristic_threshold;
+                threshold_select = options->heuristic_threshold;
             }
             
+            int new_bound = -1;
+            double bound_time = 0;
             #pragma omp critical
             {
                 //print("%d,",hamming_test);
@@ -412,19 +453,28 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
                 }
                 if(hamming_test <= global_min){/*if a thread found a lower bound that the current best one*/
                     
-                    if (hamming_test < global_min && print_solution){
+                    if (hamming_test < global_min && (print_solution || options->on_bound != NULL)){
                         clock_gettime(CLOCK_MONOTONIC, &end);
                         double time_taken = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec)) * 1e-9;
-                        print("current Hamming distance : %d, %.2fs\n", hamming_test, time_taken);
-                        //print("(%.02f,%d[%ld]) ", time_taken, hamming_test,cpt);   
-                        
-                        check_structure(qa, bool_sol, false, NULL);
+                        new_bound = hamming_test;
+                        bound_time = time_taken;
+                        if (print_solution){
+                            print("current Hamming distance : %d, %.2fs\n", hamming_test, time_taken);
+                            //print("(%.02f,%d[%ld]) ", time_taken, hamming_test,cpt);   
+                        }
                     }    
+                    if (options->heuristic_stop_regular != DISABLED_INT_PARAMETER){/*the thread stops the search on a regular invalid configuration*/
+                        invalid_stats_refresh(&stats);
+                        if (invalid_stats_is_regular(&stats, options->heuristic_stop_regular)){
+                            if (print_solution)print("regular invalid configuration of degree %d found\n", options->heuristic_stop_regular);
+                            stop = true;
+                        }
+                    }
                     global_min = hamming_test;
                     //print("(%.2f)",optimal_threshold);
                     
                     
-                    for (size_t i = 0; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++){
+                    for (size_t i = 0; i < n_points; i++){
                         
                         min_sol[i] = bool_sol[i];
                         
@@ -433,10 +483,13 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
                     
                 }
             }
+            /*the callback may block (e.g. writing to a client), so that it is called outside of the
+            critical section, its bounds possibly arriving out of order*/
+            if (new_bound >= 0 && options->on_bound != NULL)options->on_bound(new_bound, bound_time, options->on_bound_data);
             //if (hamming_test <= global_min && hamming_test < 100000 /* 134700 */)check_structure(qa, bool_sol, false, NULL);
             if(global_min == 0)break;/*if a fully valid solution has been found*/
 
-            for (size_t i = I + 1; i < BV_LIMIT_CUSTOM(qa->n_qubits); i++)
+            for (size_t i = I + 1; i < n_points; i++)
             { /*for each observable*/
                 /*selects the assignments that won't be flipped*/
                 if (!(n_invalid[i] > old_current_max * threshold_select && rand_float(rand_select) /* && n_I_custom(i, qa->n_qubits) %2 == 0 */))
@@ -457,14 +510,14 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
                     }
                     /*we add -1 if the line is negative and +1 if it is positive*/
                     int adder = 1 - 2 * (test == qa->lines_negativity[line_index]); 
+                    invalid_stats_set_line(&stats, line_index, adder > 0);
 
                     for (size_t k = 0; k < qa->points_per_geometry; k++) /*We update the number of invalid contexts for each observable*/
                     {
                         if ((line[k] == I))break;
-                        int *inv = &(n_invalid[line[k]]);
-                        *inv += adder;
+                        int inv = invalid_stats_add_degree(&stats, line[k], adder);
                         
-                        if (*inv > current_max)current_max = *inv;
+                        if (inv > current_max)current_max = inv;
                     }
                     hamming_test += adder; /*We update the hamming distance dynamically*/
                     
@@ -472,19 +525,27 @@ int geometry_contextuality_degree_max_invalid_heuristics(quantum_assignment* qa,
             }
         }
         if (print_solution)print(".");
+        invalid_stats_free(&stats);
+        free(bool_sol);
     }
-    if(is_done)is_done = false;
     free_matrix(line_per_obs);
     /*if wanted, the solution is copied to the given array*/
-    if(ret_sol != NULL)for(size_t i = 0; i < (size_t)BV_LIMIT_CUSTOM(qa->n_qubits); i++)ret_sol[i] = min_sol[i];
+    if(ret_sol != NULL)for(size_t i = 0; i < n_points; i++)ret_sol[i] = min_sol[i];
 
-    if (print_solution)print("\nHamming distance found: %d\nepsilon (if minimal): %.3f\n", global_min, 2.0f * (float)global_min / (float)qa->cpt_geometries);
+    if (print_solution){
+        print("\nHamming distance found: %d\nepsilon (if minimal): %.3f\n", global_min, 2.0f * (float)global_min / (float)qa->cpt_geometries);
+        /*the structure is only checked for the best solution, once the threads are done*/
+        if (global_min > 0)print("line types of the invalid configuration: %d\n", check_structure(qa, min_sol, false, NULL));
+    }
+    free(min_sol);
 
     return global_min;
 }
 
 
-int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,bool* ret_sol){
+/*proved is set to true if the search ended on an unsatisfiable degree (not interrupted nor failed)*/
+static int sat_contextuality_degree(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,bool* ret_sol,bool* proved){
+    *proved = false;
 
     if(qa->cpt_geometries == 0)return -1;
 
@@ -522,7 +583,7 @@ int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_
         if(print_solution)printf("positive config. ");
         return 0;
     }
-    if (no_ret_sol)ret_sol = calloc(BV_LIMIT_CUSTOM(qa->n_qubits), sizeof(bool));
+    if (no_ret_sol)ret_sol = calloc(quantum_assignment_n_points(qa), sizeof(bool));
 
     int start_degree = contextuality_only?0:/* cpt_geometries - 1 ;*/neg_lines;
     
@@ -562,11 +623,12 @@ int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_
         
         if (!expected_output){
             print("status error: {%d}", status);
-            
-            return hamming_distance;
+            hamming_distance = -1;
+            break;
         }
         if (expected_output  && !is_sat_test){
             if(print_solution)print("\nContextuality degree found: %d\nepsilon: %.3f", hamming_distance, 2.0f * (float)hamming_distance / (float)qa->cpt_geometries);
+            *proved = true;
             break;
         }
         if(system(cp_command) != EXIT_SUCCESS)print("copy error!");
@@ -589,10 +651,12 @@ int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_
     /*if the tested degree fails, then we go back to the one above*/
 
     /*if a solution is found*/
-    #pragma omp critical
-    {
-        //compute_contextuality_solution(qa,bc2cnf_cp,sat_cp,print_solution?stdout:NULL,ret_sol);
-        check_contextuality_solution(qa,ret_sol,NULL);
+    if(hamming_distance >= 0){
+        #pragma omp critical
+        {
+            //compute_contextuality_solution(qa,bc2cnf_cp,sat_cp,print_solution?stdout:NULL,ret_sol);
+            check_contextuality_solution(qa,ret_sol,NULL);
+        }
     }
 
     remove(bc2cnf_file);
@@ -604,7 +668,83 @@ int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_
     return hamming_distance;
 }
 
+int geometry_SAT_contextuality_degree(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,bool* ret_sol){
+    bool proved;
+    return sat_contextuality_degree(qa,contextuality_only,print_solution,optimistic,ret_sol,&proved);
+}
+
+static int point_cmp(const void* a,const void* b){
+    bv x = *(const bv*)a, y = *(const bv*)b;
+    return (x > y) - (x < y);
+}
+
+bool noncontextual_solution(quantum_assignment* qa,bool* bool_sol){
+
+    quantum_assignment_autofill_indices(qa);
+    quantum_assignment_compute_negativity(qa);
+
+    /*the columns of the incidence matrix are the points present in a context, sorted (the
+    points of a non-compact assignment being observables among 4^n)*/
+    bv *points = malloc((qa->cpt_geometries*qa->points_per_geometry+1)*sizeof(bv));
+    size_t n_columns = 0;
+    for (size_t i = 0; i < qa->cpt_geometries; i++){
+        for (size_t j = 0; j < qa->points_per_geometry; j++){
+            bv point = qa->geometries[qa->geometry_indices[i]][j];
+            if(point == I)break;
+            points[n_columns++] = point;
+        }
+    }
+    qsort(points,n_columns,sizeof(bv),point_cmp);
+    size_t n_unique = 0;
+    for (size_t c = 0; c < n_columns; c++)if(n_unique == 0 || points[c] != points[n_unique-1])points[n_unique++] = points[c];
+    n_columns = n_unique;
+    if(qa->cpt_geometries == 0 || (double)qa->cpt_geometries*n_columns > NONCONTEXTUAL_CHECK_MAX_BITS){
+        free(points);
+        return qa->cpt_geometries == 0;
+    }
+
+    bit_matrix incidence = gf2_matrix_create(qa->cpt_geometries, n_columns);
+    if(incidence.bits == NULL){
+        free(points);
+        return false;
+    }
+    bit_set_type *negativity = calloc(BIT_SIZE(qa->cpt_geometries),sizeof(bit_set_type));
+    bit_set_type *solution = calloc(BIT_SIZE(n_columns),sizeof(bit_set_type));
+    for (size_t i = 0; i < qa->cpt_geometries; i++){
+        for (size_t j = 0; j < qa->points_per_geometry; j++){
+            bv point = qa->geometries[qa->geometry_indices[i]][j];
+            if(point == I)break;
+            size_t column = (bv*)bsearch(&point,points,n_columns,sizeof(bv),point_cmp) - points;
+            incidence.bits[i][column/64] ^= 1ULL << (column%64);
+        }
+        if(qa->lines_negativity[i])negativity[i/64] |= 1ULL << (i%64);
+    }
+
+    bool solvable = gf2_solve(incidence, negativity, solution);
+    if(solvable && bool_sol != NULL){
+        memset(bool_sol,0,quantum_assignment_n_points(qa)*sizeof(bool));
+        for (size_t c = 0; c < n_columns; c++)bool_sol[points[c]] = (solution[c/64] >> (c%64)) & 1;
+    }
+
+    free(solution);
+    free(negativity);
+    bit_matrix_free(incidence);
+    free(points);
+    return solvable;
+}
+
 int geometry_contextuality_degree_custom(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,solver_mode mode,bool* bool_sol){
+    solver_options options = solver_options_global();
+    options.mode = mode;
+    return geometry_contextuality_degree_options(qa, contextuality_only, print_solution, optimistic, &options, bool_sol);
+}
+
+int geometry_contextuality_degree_options(quantum_assignment* qa,bool contextuality_only,bool print_solution,bool optimistic,const solver_options* options,bool* bool_sol){
+    solver_mode mode = options->mode;
+
+    /*the cache holds degrees, not the mere contextuality of a configuration*/
+    if(options->cache_directory != NULL && !contextuality_only && mode != RETRIEVE_SOLUTION)
+        return results_cache_contextuality_degree(qa,print_solution,optimistic,options,bool_sol);
 
     quantum_assignment_autofill_indices(qa);
     quantum_assignment_compute_negativity(qa);
@@ -614,19 +754,29 @@ int geometry_contextuality_degree_custom(quantum_assignment* qa,bool contextuali
     int c_degree = -1;
 
 
-    if(!has_bool_sol)bool_sol = calloc(BV_LIMIT_CUSTOM(qa->n_qubits),sizeof(bool));
+    if(!has_bool_sol)bool_sol = calloc(quantum_assignment_n_points(qa),sizeof(bool));
 
     
     
 
-    switch (mode){
-    case SAT_SOLVER:c_degree = geometry_SAT_contextuality_degree(qa,contextuality_only,print_solution,optimistic,bool_sol);break;
+    /*a degree 0 is found by linear algebra, without solver*/
+    bool solver_needed = mode == RETRIEVE_SOLUTION || !noncontextual_solution(qa,bool_sol);
+    if(!solver_needed){
+        if(print_solution)print("\nnon contextual configuration (the contexts form a solvable linear system)\n");
+        c_degree = 0;
+    }
+
+    bool proved = !solver_needed;
+    if(solver_needed)switch (mode){
+    case SAT_SOLVER:c_degree = sat_contextuality_degree(qa,contextuality_only,print_solution,optimistic,bool_sol,&proved);break;
     case RETRIEVE_SOLUTION:
-        parse_bool(bool_sol,BV_LIMIT_CUSTOM(qa->n_qubits));
+        parse_bool(bool_sol,quantum_assignment_n_points(qa));
         c_degree = check_contextuality_solution(qa,bool_sol,NULL);break;
-    case INVALID_LINES_HEURISTIC_SOLVER:c_degree = geometry_contextuality_degree_max_invalid_heuristics(qa, print_solution, bool_sol);break;
+    case INVALID_LINES_HEURISTIC_SOLVER:c_degree = geometry_contextuality_degree_heuristics_options(qa, print_solution, options, bool_sol);break;
     default:break;
     }
+    /*a valid classical assignment proves a degree 0 whatever the solver*/
+    if(options->proved != NULL)*options->proved = proved || c_degree == 0;
 
 
 
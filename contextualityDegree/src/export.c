@@ -0,0 +1,436 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file export.c
+ * @brief exporters of the contexts of a quantum assignment (CSV, readable form, binary, solver instances)
+ */
+#include "constants.h"
+#include "export.h"
+#include "binary_format.h"
+
+/*variables of a solver instance, numbered from 1: the points 1..points-1 (I being left out), the
+indicators of invalid contexts points..points+cpt_geometries-1, then the auxiliary variables*/
+typedef struct {
+    size_t points;
+    size_t *aux_offsets; /*first auxiliary variable of each context (WCNF, OPB), or NULL*/
+    size_t bound;        /*XCNF: maximum number of invalid contexts (0: no indicators)*/
+    size_t counter;      /*XCNF: first variable of the sequential counter*/
+} export_plan;
+
+/*formats the context i of an assignment into a buffer, returns the number of characters written*/
+typedef size_t (*export_context_writer)(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer);
+
+/*row of the geometry array of the context i (the assignment may have no indices yet)*/
+static inline const bv *export_context(const quantum_assignment *qa, size_t i){
+    return qa->geometries[qa->geometry_indices != NULL ? qa->geometry_indices[i] : i];
+}
+
+/*decimal digits of an unsigned integer, returns their number*/
+static size_t export_uint(size_t value, char *buffer){
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    for (size_t k = 0; k < n; k++)buffer[k] = digits[n - 1 - k];
+    return n;
+}
+
+/*a DIMACS literal (a sign and the digits of the variable) followed by a space*/
+static size_t export_literal(size_t var, bool positive, char *buffer){
+    size_t length = 0;
+    if (!positive)buffer[length++] = '-';
+    length += export_uint(var, buffer + length);
+    buffer[length++] = ' ';
+    return length;
+}
+
+/*variables of the points of the context i, followed by its indicator if with_indicator, returns their number*/
+static size_t export_context_variables(const quantum_assignment *qa, const export_plan *plan, size_t i, bool with_indicator, size_t *vars){
+    const bv *line = export_context(qa, i);
+    size_t m = 0;
+    for (size_t j = 0; j < qa->points_per_geometry && line[j] != I; j++)vars[m++] = line[j];
+    if (with_indicator)vars[m++] = plan->points + i;
+    return m;
+}
+
+/*formats the blocks of contexts in parallel and writes them in order, context_size bounding
+the number of characters of a context (the blocks are shortened to fit EXPORT_BUFFER_SIZE)*/
+static void export_contexts(const quantum_assignment *qa, const export_plan *plan, export_context_writer writer, size_t context_size, FILE *output){
+    size_t block_size = MAX(1, MIN(EXPORT_BLOCK_CONTEXTS, EXPORT_BUFFER_SIZE / context_size));
+    size_t blocks = (qa->cpt_geometries + block_size - 1) / block_size;
+
+    #pragma omp parallel if (blocks > 1)
+    {
+        char *buffer = malloc(block_size * context_size);
+
+        #pragma omp for ordered schedule(static, 1)
+        for (size_t b = 0; b < blocks; b++){
+            size_t length = 0;
+            for (size_t i = b * block_size; i < MIN((b + 1) * block_size, qa->cpt_geometries); i++)
+                length += writer(qa, plan, i, buffer + length);
+            #pragma omp ordered
+            fwrite(buffer, 1, length, output);
+        }
+        free(buffer);
+    }
+}
+
+bool export_format_parse(const char *name, export_format *format){
+    if (strcmp(name, "csv") == 0)*format = EXPORT_FORMAT_CSV;
+    else if (strcmp(name, "binary") == 0)*format = EXPORT_FORMAT_BINARY;
+    else if (strcmp(name, "xcnf") == 0)*format = EXPORT_FORMAT_XCNF;
+    else if (strcmp(name, "wcnf") == 0)*format = EXPORT_FORMAT_WCNF;
+    else if (strcmp(name, "opb") == 0)*format = EXPORT_FORMAT_OPB;
+    else if (strcmp(name, "cpsat") == 0)*format = EXPORT_FORMAT_CPSAT;
+    else return false;
+    return true;
+}
+
+/////////////////////////////////////////// CSV
+
+/*a context shorter than points_per_geometry ends with a comma (read back as I)*/
+static size_t export_csv_context(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    (void)plan;
+    const bv *line = export_context(qa, i);
+    size_t length = 0;
+    for (size_t j = 0; j < qa->points_per_geometry; j++){
+        if (j != 0)buffer[length++] = ',';
+        if (line[j] == I)break;
+        length += quantum_assignment_point_to_chars(qa, line[j], buffer + length);
+    }
+    buffer[length++] = '\n';
+    return length;
+}
+
+void export_csv(quantum_assignment *qa, FILE *output){
+    export_contexts(qa, NULL, export_csv_context, qa->points_per_geometry * (qa->n_qubits + 1) + 1, output);
+}
+
+/////////////////////////////////////////// readable form
+
+static size_t export_readable_context(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    (void)plan;
+    const bv *line = export_context(qa, i);
+    size_t length = 0;
+    for (size_t j = 0; j < qa->points_per_geometry && line[j] != I; j++){
+        buffer[length++] = '[';
+        length += quantum_assignment_point_to_chars(qa, line[j], buffer + length);
+        buffer[length++] = ']';
+    }
+    buffer[length++] = qa->lines_negativity[i] ? '-' : '+';
+    buffer[length++] = '\n';
+    return length;
+}
+
+void export_readable(quantum_assignment *qa, FILE *output){
+    quantum_assignment_compute_negativity(qa);
+    export_contexts(qa, NULL, export_readable_context, qa->points_per_geometry * (qa->n_qubits + 2) + 2, output);
+}
+
+/////////////////////////////////////////// XCNF
+
+/*sequential counter of Sinz (2005) for "at most bound indicators are true": the variable s(i,j)
+of the context i (from 1 to n-1) means that at least j of its first i indicators are true*/
+static inline size_t export_counter_var(const export_plan *plan, size_t i, size_t j){
+    return plan->counter + (i - 1) * plan->bound + (j - 1);
+}
+
+static size_t export_counter_clauses(size_t n, size_t bound){
+    if (bound == 0 || bound >= n)return 0;
+    return bound + (n - 2) * (2 * bound + 1) + 1;
+}
+
+/*clauses of the counter involving the indicator of the context i (from 0)*/
+static size_t export_counter_context(const export_plan *plan, size_t n, size_t i, char *buffer){
+    size_t k = plan->bound, c = i + 1, v = plan->points + i, length = 0;
+    if (k == 0 || k >= n)return 0;
+    if (c == 1){
+        length += export_literal(v, false, buffer + length);
+        length += export_literal(export_counter_var(plan, 1, 1), true, buffer + length);
+        buffer[length++] = '0';
+        buffer[length++] = '\n';
+        for (size_t j = 2; j <= k; j++){
+            length += export_literal(export_counter_var(plan, 1, j), false, buffer + length);
+            buffer[length++] = '0';
+            buffer[length++] = '\n';
+        }
+        return length;
+    }
+    if (c < n){
+        length += export_literal(v, false, buffer + length);
+        length += export_literal(export_counter_var(plan, c, 1), true, buffer + length);
+        buffer[length++] = '0';
+        buffer[length++] = '\n';
+        length += export_literal(export_counter_var(plan, c - 1, 1), false, buffer + length);
+        length += export_literal(export_counter_var(plan, c, 1), true, buffer + length);
+        buffer[length++] = '0';
+        buffer[length++] = '\n';
+        for (size_t j = 2; j <= k; j++){
+            length += export_literal(v, false, buffer + length);
+            length += export_literal(export_counter_var(plan, c - 1, j - 1), false, buffer + length);
+            length += export_literal(export_counter_var(plan, c, j), true, buffer + length);
+            buffer[length++] = '0';
+            buffer[length++] = '\n';
+            length += export_literal(export_counter_var(plan, c - 1, j), false, buffer + length);
+            length += export_literal(export_counter_var(plan, c, j), true, buffer + length);
+            buffer[length++] = '0';
+            buffer[length++] = '\n';
+        }
+    }
+    length += export_literal(v, false, buffer + length);
+    length += export_literal(export_counter_var(plan, c - 1, k), false, buffer + length);
+    buffer[length++] = '0';
+    buffer[length++] = '\n';
+    return length;
+}
+
+/*x-clause of the parity of a context: the XOR of its points (and of its indicator) is true iff it
+is negative, so the first literal is negated for a positive context*/
+static size_t export_xcnf_context(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    size_t vars[qa->points_per_geometry + 1];
+    size_t m = export_context_variables(qa, plan, i, plan->bound != 0, vars);
+    size_t length = 0;
+    buffer[length++] = 'x';
+    for (size_t j = 0; j < m; j++)length += export_literal(vars[j], j != 0 || qa->lines_negativity[i], buffer + length);
+    buffer[length++] = '0';
+    buffer[length++] = '\n';
+    return length + export_counter_context(plan, qa->cpt_geometries, i, buffer + length);
+}
+
+void export_xcnf(quantum_assignment *qa, size_t bound, FILE *output){
+    quantum_assignment_compute_negativity(qa);
+    size_t n = qa->cpt_geometries, points = quantum_assignment_n_points(qa);
+    /*with no bound, the instance has no indicators and asks for a degree 0*/
+    export_plan plan = {.points = points, .bound = MIN(bound, n), .counter = points + n};
+    size_t counter_vars = (plan.bound == 0 || plan.bound >= n) ? 0 : (n - 1) * plan.bound;
+    size_t vars = (plan.bound == 0) ? points - 1 : points - 1 + n + counter_vars;
+
+    fprintf(output, "c %ld contexts, %d negative", n, negative_lines_count(qa));
+    if (plan.bound != 0)fprintf(output, ", at most %ld invalid", plan.bound);
+    fprintf(output, "\np cnf %ld %ld\n", vars, n + export_counter_clauses(n, plan.bound));
+    /*a literal is a sign, at most 20 digits and a space; a context has at most 2 bound + 1 counter clauses*/
+    size_t counter_clauses = (counter_vars == 0) ? 0 : 2 * plan.bound + 1;
+    export_contexts(qa, &plan, export_xcnf_context, (qa->points_per_geometry + 1) * 22 + 4 + counter_clauses * (3 * 22 + 2), output);
+}
+
+/////////////////////////////////////////// WCNF
+
+/*a parity constraint over more than EXPORT_XOR_DIRECT literals is split by auxiliary variables*/
+#define EXPORT_XOR_DIRECT 4
+
+static size_t export_xor_aux(size_t m){
+    return m <= EXPORT_XOR_DIRECT ? 0 : 1 + export_xor_aux(m - 2);
+}
+
+static size_t export_xor_clauses(size_t m){
+    return m <= EXPORT_XOR_DIRECT ? ((size_t)1 << (m - 1)) : (1 << (EXPORT_XOR_DIRECT - 1)) + export_xor_clauses(m - 2);
+}
+
+/*clauses of XOR(vars) = parity: one clause forbids each assignment of the wrong parity*/
+static size_t export_xor_direct(const size_t *vars, size_t m, bool parity, const char *prefix, size_t prefix_length, char *buffer){
+    size_t length = 0;
+    for (size_t a = 0; a < ((size_t)1 << m); a++){
+        if ((bool)(__builtin_popcountll(a) & 1) == parity)continue;
+        memcpy(buffer + length, prefix, prefix_length);
+        length += prefix_length;
+        for (size_t j = 0; j < m; j++)length += export_literal(vars[j], !((a >> j) & 1), buffer + length);
+        buffer[length++] = '0';
+        buffer[length++] = '\n';
+    }
+    return length;
+}
+
+/*clauses of XOR(vars) = parity, the first literals being replaced three by three by the auxiliary
+variables t = XOR(vars[0..2]) from aux on*/
+static size_t export_xor_cnf(size_t *vars, size_t m, bool parity, size_t aux, const char *prefix, char *buffer){
+    size_t length = 0, prefix_length = strlen(prefix);
+    while (m > EXPORT_XOR_DIRECT){
+        size_t chunk[4] = {vars[0], vars[1], vars[2], aux};
+        length += export_xor_direct(chunk, 4, false, prefix, prefix_length, buffer + length);
+        vars += 2;
+        vars[0] = aux++;
+        m -= 2;
+    }
+    return length + export_xor_direct(vars, m, parity, prefix, prefix_length, buffer + length);
+}
+
+/*hard parity clauses of the context, and the soft clause asking for its indicator to be false*/
+static size_t export_wcnf_context(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    size_t vars[qa->points_per_geometry + 1];
+    size_t m = export_context_variables(qa, plan, i, true, vars);
+    char top[24];
+    snprintf(top, sizeof(top), "%ld ", qa->cpt_geometries + 1);
+
+    size_t length = export_xor_cnf(vars, m, qa->lines_negativity[i], plan->aux_offsets[i], top, buffer);
+    buffer[length++] = '1';
+    buffer[length++] = ' ';
+    length += export_literal(plan->points + i, false, buffer + length);
+    buffer[length++] = '0';
+    buffer[length++] = '\n';
+    return length;
+}
+
+/*first auxiliary variable of each context, from first on, aux giving the number of a context of m
+variables; returns the number of auxiliary variables*/
+static size_t export_aux_offsets(quantum_assignment *qa, const export_plan *plan, size_t (*aux)(size_t), size_t first, size_t *offsets){
+    size_t next = first, vars[qa->points_per_geometry + 1];
+    for (size_t i = 0; i < qa->cpt_geometries; i++){
+        offsets[i] = next;
+        next += aux(export_context_variables(qa, plan, i, true, vars));
+    }
+    return next - first;
+}
+
+void export_wcnf(quantum_assignment *qa, FILE *output){
+    quantum_assignment_compute_negativity(qa);
+    size_t n = qa->cpt_geometries, points = quantum_assignment_n_points(qa);
+    export_plan plan = {.points = points, .aux_offsets = malloc(MAX(n, 1) * sizeof(size_t))};
+    size_t aux = export_aux_offsets(qa, &plan, export_xor_aux, points + n, plan.aux_offsets);
+
+    size_t clauses = n, vars[qa->points_per_geometry + 1];
+    for (size_t i = 0; i < n; i++)clauses += export_xor_clauses(export_context_variables(qa, &plan, i, true, vars));
+    fprintf(output, "c %ld contexts, %d negative: the soft clauses are the valid contexts\np wcnf %ld %ld %ld\n",
+            n, negative_lines_count(qa), points - 1 + n + aux, clauses, n + 1);
+    /*a hard clause has its weight, at most EXPORT_XOR_DIRECT literals and its end*/
+    size_t m = qa->points_per_geometry + 1;
+    export_contexts(qa, &plan, export_wcnf_context, export_xor_clauses(m) * (EXPORT_XOR_DIRECT + 2) * 22 + 48, output);
+    free(plan.aux_offsets);
+}
+
+/////////////////////////////////////////// OPB
+
+/*bits of the number of pairs removed from the sum of a context of m variables*/
+static size_t export_opb_aux(size_t m){
+    size_t pairs = m / 2, bits = 0;
+    while (pairs >> bits)bits++;
+    return bits;
+}
+
+/*linearised parity: the sum of the points and of the indicator, minus twice the number of pairs
+written in binary with auxiliary variables, is the parity of the context*/
+static size_t export_opb_context(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    size_t vars[qa->points_per_geometry + 1];
+    size_t m = export_context_variables(qa, plan, i, true, vars), length = 0;
+    for (size_t j = 0; j < m; j++){
+        memcpy(buffer + length, "+1 x", 4);
+        length += 4;
+        length += export_uint(vars[j], buffer + length);
+        buffer[length++] = ' ';
+    }
+    for (size_t b = 0; b < export_opb_aux(m); b++){
+        buffer[length++] = '-';
+        length += export_uint((size_t)2 << b, buffer + length);
+        memcpy(buffer + length, " x", 2);
+        length += 2;
+        length += export_uint(plan->aux_offsets[i] + b, buffer + length);
+        buffer[length++] = ' ';
+    }
+    length += sprintf(buffer + length, "= %d ;\n", qa->lines_negativity[i]);
+    return length;
+}
+
+static size_t export_opb_objective(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    (void)qa;
+    memcpy(buffer, " +1 x", 5);
+    return 5 + export_uint(plan->points + i, buffer + 5);
+}
+
+void export_opb(quantum_assignment *qa, FILE *output){
+    quantum_assignment_compute_negativity(qa);
+    size_t n = qa->cpt_geometries, points = quantum_assignment_n_points(qa);
+    export_plan plan = {.points = points, .aux_offsets = malloc(MAX(n, 1) * sizeof(size_t))};
+    size_t aux = export_aux_offsets(qa, &plan, export_opb_aux, points + n, plan.aux_offsets);
+
+    fprintf(output, "* #variable= %ld #constraint= %ld\n* %ld contexts, %d negative\nmin:",
+            points - 1 + n + aux, n, n, negative_lines_count(qa));
+    export_contexts(qa, &plan, export_opb_objective, 32, output);
+    fprintf(output, " ;\n");
+    /*a term is a coefficient of at most 21 characters and a variable*/
+    export_contexts(qa, &plan, export_opb_context, (qa->points_per_geometry + 1 + 64) * 48 + 16, output);
+    free(plan.aux_offsets);
+}
+
+/////////////////////////////////////////// CP-SAT
+
+/*CP-SAT variables are indexed from 0, and the negation of the variable v is -v-1*/
+static size_t export_cpsat_context(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    size_t vars[qa->points_per_geometry + 1];
+    size_t m = export_context_variables(qa, plan, i, true, vars), length = 0;
+    memcpy(buffer, "constraints { bool_xor { literals: [", 36);
+    length += 36;
+    for (size_t j = 0; j < m; j++){
+        if (j != 0){
+            buffer[length++] = ',';
+            buffer[length++] = ' ';
+        }
+        /*the XOR is true: the first literal is negated for a positive context*/
+        if (j == 0 && !qa->lines_negativity[i]){
+            buffer[length++] = '-';
+            length += export_uint(vars[j], buffer + length);
+        }else length += export_uint(vars[j] - 1, buffer + length);
+    }
+    memcpy(buffer + length, "] } }\n", 6);
+    return length + 6;
+}
+
+static size_t export_cpsat_objective_var(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    size_t length = 0;
+    if (i != 0){
+        buffer[length++] = ',';
+        buffer[length++] = ' ';
+    }
+    (void)qa;
+    return length + export_uint(plan->points + i - 1, buffer + length);
+}
+
+static size_t export_cpsat_objective_coeff(const quantum_assignment *qa, const export_plan *plan, size_t i, char *buffer){
+    (void)qa;
+    (void)plan;
+    memcpy(buffer, i != 0 ? ", 1" : "1", i != 0 ? 3 : 1);
+    return i != 0 ? 3 : 1;
+}
+
+void export_cpsat(quantum_assignment *qa, FILE *output){
+    quantum_assignment_compute_negativity(qa);
+    size_t n = qa->cpt_geometries, points = quantum_assignment_n_points(qa);
+    export_plan plan = {.points = points};
+
+    fprintf(output, "# %ld contexts, %d negative: the variables are the points, then the invalid contexts\n", n, negative_lines_count(qa));
+    for (size_t v = 1; v < points + n; v++)fputs("variables { domain: [0, 1] }\n", output);
+    export_contexts(qa, &plan, export_cpsat_context, (qa->points_per_geometry + 1) * 23 + 48, output);
+    fprintf(output, "objective { vars: [");
+    export_contexts(qa, &plan, export_cpsat_objective_var, 24, output);
+    fprintf(output, "] coeffs: [");
+    export_contexts(qa, &plan, export_cpsat_objective_coeff, 4, output);
+    fprintf(output, "] }\n");
+}
+
+bool export_quantum_assignment(quantum_assignment *qa, export_format format, size_t bound, FILE *output){
+    switch (format){
+    case EXPORT_FORMAT_CSV:
+        export_csv(qa, output);
+        return true;
+    case EXPORT_FORMAT_BINARY:
+        return binary_assignment_save(qa, NULL, output);
+    case EXPORT_FORMAT_XCNF:
+        export_xcnf(qa, bound, output);
+        return true;
+    case EXPORT_FORMAT_WCNF:
+        export_wcnf(qa, output);
+        return true;
+    case EXPORT_FORMAT_OPB:
+        export_opb(qa, output);
+        return true;
+    case EXPORT_FORMAT_CPSAT:
+        export_cpsat(qa, output);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file family.c
+ * @brief non-interactive computation of the contextuality degrees of a whole family of
+ * configurations, spread over all the cores
+ */
+#include "family.h"
+
+#include "symplectic.h"
+
+#include <omp.h>
+#include <string.h>
+
+void family_add(configuration_family* family,size_t id,quantum_assignment qa){
+    if(family->cpt_configurations == family->capacity){
+        family->capacity = MAX(2*family->capacity,16);
+        family->configurations = realloc(family->configurations,family->capacity*sizeof(quantum_assignment));
+        family->ids = realloc(family->ids,family->capacity*sizeof(size_t));
+        if(family->multiplicities != NULL)family->multiplicities = realloc(family->multiplicities,family->capacity*sizeof(size_t));
+    }
+    if(family->multiplicities != NULL)family->multiplicities[family->cpt_configurations] = 1;
+    family->configurations[family->cpt_configurations] = qa;
+    family->ids[family->cpt_configurations] = id;
+    family->cpt_configurations++;
+}
+
+void family_add_copy(configuration_family* family,size_t id,quantum_assignment* qa){
+    quantum_assignment copy = *qa;
+    copy.geometry_indices = malloc(MAX(qa->cpt_geometries,1)*sizeof(size_t));
+    memcpy(copy.geometry_indices,qa->geometry_indices,qa->cpt_geometries*sizeof(size_t));
+    copy.lines_negativity = NULL;
+    quantum_assignment_compute_negativity(&copy);
+    family_add(family,id,copy);
+}
+
+/*solves one configuration and fills its row of the table*/
+static void family_solve(configuration_family* family,size_t index,solver_mode mode,family_result* result){
+    quantum_assignment* qa = &family->configurations[index];
+    double start = omp_get_wtime();
+    int degree = geometry_contextuality_degree_custom(qa,false,false,false,mode,NULL);
+    *result = (family_result){
+        .id = family->ids[index],
+        .multiplicity = (family->multiplicities == NULL) ? 1 : family->multiplicities[index],
+        .contexts = qa->cpt_geometries,
+        .negative_contexts = negative_lines_count(qa),
+        .degree = degree,
+        .time = omp_get_wtime() - start
+    };
+}
+
+size_t family_reduce_to_orbits(configuration_family* family,quantum_assignment lines_qa){
+    size_t cpt = family->cpt_configurations;
+    size_t n_lines = NB_LINES_CUSTOM(lines_qa.n_qubits) + 1;
+
+    bit_vector* line_sets = malloc(MAX(cpt,1)*sizeof(bit_vector));
+    for (size_t i = 0; i < cpt; i++){
+        line_sets[i] = bit_set_create(n_lines,NULL);
+        quantum_assignment* qa = &family->configurations[i];
+        for (size_t j = 0; j < qa->cpt_geometries; j++)bit_set_set_bit(line_sets[i],qa->geometry_indices[j],true);
+    }
+    size_t* orbit_of = malloc(MAX(cpt,1)*sizeof(size_t));
+    size_t n_orbits = symplectic_orbits(line_sets,cpt,lines_qa,orbit_of);
+
+    size_t* multiplicities = calloc(MAX(cpt,1),sizeof(size_t));
+    for (size_t i = 0; i < cpt; i++)
+        multiplicities[orbit_of[i]] += (family->multiplicities == NULL) ? 1 : family->multiplicities[i];
+
+    /*the representatives keep their order*/
+    size_t kept = 0;
+    for (size_t i = 0; i < cpt; i++){
+        if(orbit_of[i] != i){
+            free_quantum_assignment(&family->configurations[i]);
+            continue;
+        }
+        family->configurations[kept] = family->configurations[i];
+        family->ids[kept] = family->ids[i];
+        multiplicities[kept] = multiplicities[i];
+        kept++;
+    }
+    family->cpt_configurations = kept;
+    free(family->multiplicities);
+    family->multiplicities = multiplicities;
+
+    for (size_t i = 0; i < cpt; i++)bit_set_free(line_sets[i]);
+    free(line_sets);
+    free(orbit_of);
+    return n_orbits;
+}
+
+family_result* family_contextuality_degrees(configuration_family* family,solver_mode mode){
+    if(mode == RETRIEVE_SOLUTION){
+        print("the retrieve solver cannot be used on a family of configurations\n");
+        return NULL;
+    }
+    family_result* results = calloc(MAX(family->cpt_configurations,1),sizeof(family_result));
+    for (size_t i = 0; i < family->cpt_configurations; i++)results[i].degree = -1;
+
+    /*the solvers' own parallel regions only get one thread inside the loop below*/
+    int max_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+
+    #pragma omp parallel for schedule(dynamic,1)
+    for (size_t i = 0; i < family->cpt_configurations; i++){
+        if(is_done || family->configurations[i].cpt_geometries >= FAMILY_NESTED_MIN_CONTEXTS)continue;
+        family_solve(family,i,mode,&results[i]);
+    }
+
+    for (size_t i = 0; i < family->cpt_configurations && !is_done; i++){
+        if(family->configurations[i].cpt_geometries < FAMILY_NESTED_MIN_CONTEXTS)continue;
+        family_solve(family,i,mode,&results[i]);
+    }
+
+    omp_set_max_active_levels(max_levels);
+    return results;
+}
+
+void family_results_to_csv(family_result* results,size_t cpt_results,FILE* output){
+    fprintf(output,"id,multiplicity,contexts,negative contexts,degree,time\n");
+    for (size_t i = 0; i < cpt_results; i++){
+        fprintf(output,"%ld,%ld,%ld,%d,%d,%.3f\n",
+            results[i].id,results[i].multiplicity,results[i].contexts,results[i].negative_contexts,results[i].degree,results[i].time);
+    }
+}
+
+void family_free(configuration_family* family){
+    for (size_t i = 0; i < family->cpt_configurations; i++)free_quantum_assignment(&family->configurations[i]);
+    free(family->configurations);
+    free(family->ids);
+    free(family->multiplicities);
+    *family = (configuration_family){0};
+}
@@ -0,0 +1,242 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file gf2.c
+ * @brief linear algebra over GF(2) on bit matrices
+ */
+#include "constants.h"
+#include "gf2.h"
+#include "bit_kernels.h"
+
+/*below this number of rows, the updates are not worth a parallel region*/
+#define GF2_PARALLEL_ROWS 512
+
+/*words of a row, padded to a cache line of 64 bytes*/
+#define GF2_ROW_STRIDE(words) (((words) + 7) & ~(size_t)7)
+
+static inline bool row_bit(const bit_set_type *row, size_t col){
+    return (row[col / 64] >> (col % 64)) & 1;
+}
+
+bit_matrix gf2_matrix_create(size_t rows, size_t cols){
+    size_t words = BIT_SIZE(cols), stride = GF2_ROW_STRIDE(words);
+    /*one row is always allocated so that bit_sets[0] gives the number of columns*/
+    size_t allocated = MAX(rows, 1);
+    void *data = NULL;
+    if (posix_memalign(&data, 64, allocated * stride * sizeof(bit_set_type)) != 0){
+        print("matrix allocation error : %ld %ld\n", rows, cols);
+        return (bit_matrix){0};
+    }
+    memset(data, 0, allocated * stride * sizeof(bit_set_type));
+
+    bit_matrix m = {
+        .size = rows,
+        .bit_sets = (bit_vector *)calloc(allocated, sizeof(bit_vector)),
+        .bits = (bit_set_type **)calloc(allocated, sizeof(bit_set_type *))
+    };
+    if (m.bit_sets == NULL || m.bits == NULL){
+        print("matrix allocation error : %ld %ld\n", rows, cols);
+        free(m.bit_sets);
+        free(m.bits);
+        free(data);
+        return (bit_matrix){0};
+    }
+    for (size_t i = 0; i < allocated; i++){
+        m.bits[i] = (bit_set_type *)data + i * stride;
+        m.bit_sets[i] = bit_set_create(cols, m.bits[i]);
+    }
+    return m;
+}
+
+/*copy of a matrix with at least cols columns (the extra columns being 0)*/
+static bit_matrix gf2_copy(bit_matrix m, size_t cols){
+    bit_matrix copy = gf2_matrix_create(m.size, cols);
+    size_t words = MIN(BIT_SET_ARR_SIZE(m.bit_sets[0]), BIT_SIZE(cols));
+    for (size_t i = 0; i < m.size; i++)memcpy(copy.bits[i], m.bits[i], words * sizeof(bit_set_type));
+    return copy;
+}
+
+/*transposes a 64x64 block in place: the top right and bottom left quarters are swapped,
+then recursively inside each quarter (all the quarters of a level at once)*/
+static void transpose64(uint64_t block[64]){
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j){
+        for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j){
+            uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+            block[k] ^= t << j;
+            block[k | j] ^= t;
+        }
+    }
+}
+
+bit_matrix gf2_transpose(bit_matrix m){
+    size_t rows = m.size, cols = m.bit_sets[0].size;
+    bit_matrix res = gf2_matrix_create(cols, rows);
+    size_t row_blocks = BIT_SIZE(rows), col_blocks = BIT_SIZE(cols);
+
+    #pragma omp parallel for schedule(static) if (cols >= GF2_PARALLEL_ROWS)
+    for (size_t J = 0; J < col_blocks; J++){
+        uint64_t block[64];
+        for (size_t I = 0; I < row_blocks; I++){
+            for (size_t r = 0; r < 64; r++)block[r] = (I * 64 + r < rows) ? m.bits[I * 64 + r][J] : 0;
+            transpose64(block);
+            for (size_t c = 0; c < 64 && J * 64 + c < cols; c++)res.bits[J * 64 + c][I] = block[c];
+        }
+    }
+    return res;
+}
+
+bit_matrix gf2_multiply(bit_matrix a, bit_matrix b){
+    size_t n = a.bit_sets[0].size;
+    if (n != b.size){
+        print("BitMatrix column size must match row size of second matrix: %ld != %ld\n", n, b.size);
+        return (bit_matrix){0};
+    }
+    size_t cols = b.bit_sets[0].size, words = BIT_SIZE(cols), stride = GF2_ROW_STRIDE(words);
+    bit_matrix c = gf2_matrix_create(a.size, cols);
+    if (c.bits == NULL)return (bit_matrix){0};
+    bit_set_type *table = NULL;
+    if (posix_memalign((void **)&table, 64, ((size_t)1 << GF2_M4R_BITS) * stride * sizeof(bit_set_type)) != 0){
+        print("matrix allocation error : %d %ld\n", 1 << GF2_M4R_BITS, cols);
+        bit_matrix_free(c);
+        return (bit_matrix){0};
+    }
+    memset(table, 0, stride * sizeof(bit_set_type));
+
+    #pragma omp parallel if (a.size >= GF2_PARALLEL_ROWS)
+    for (size_t k0 = 0; k0 < n; k0 += GF2_M4R_BITS){
+        size_t kk = MIN(GF2_M4R_BITS, n - k0);
+
+        /*table[s] is the sum of the rows k0+t of b for the bits t of s*/
+        #pragma omp single
+        for (size_t s = 1; s < ((size_t)1 << kk); s++)
+            bit_kernel_xor(table + s * stride, table + (s & (s - 1)) * stride, b.bits[k0 + __builtin_ctzll(s)], words);
+
+        /*the GF2_M4R_BITS bits of a group never straddle two words*/
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < a.size; i++){
+            size_t s = (a.bits[i][k0 / 64] >> (k0 % 64)) & (((size_t)1 << kk) - 1);
+            if (s != 0)bit_kernel_xor(c.bits[i], c.bits[i], table + s * stride, words);
+        }
+    }
+    free(table);
+    return c;
+}
+
+size_t gf2_echelon(bit_matrix m, bool reduced, size_t *pivots){
+    size_t rows = m.size, cols = m.bit_sets[0].size, words = BIT_SET_ARR_SIZE(m.bit_sets[0]);
+    bit_set_type *table = malloc(((size_t)1 << GF2_M4R_BITS) * words * sizeof(bit_set_type));
+    size_t rank = 0;
+
+    /*the rows from rank on are zero before the current group of columns, so the updates start at its word*/
+    for (size_t c0 = 0; c0 < cols && rank < rows; c0 += GF2_M4R_BITS){
+        size_t kk = MIN(GF2_M4R_BITS, cols - c0), w0 = c0 / 64, len = words - w0;
+        size_t found = 0, block_pivots[GF2_M4R_BITS];
+
+        /*pivots of the group by plain elimination, each pivot row being cleared in the other pivot columns*/
+        for (size_t c = c0; c < c0 + kk && rank + found < rows; c++){
+            size_t p = rank + found;
+            for (; p < rows; p++){
+                bit_set_type *row = m.bits[p];
+                for (size_t t = 0; t < found; t++)
+                    if (row_bit(row, block_pivots[t]))bit_kernel_xor(row + w0, row + w0, m.bits[rank + t] + w0, len);
+                if (row_bit(row, c))break;
+            }
+            if (p == rows)continue;
+
+            bit_set_type *pivot_row = m.bits[rank + found];
+            if (p != rank + found){/*the contents are swapped, the row storage being owned by bits[0]*/
+                for (size_t w = w0; w < words; w++){
+                    bit_set_type tmp = m.bits[p][w];
+                    m.bits[p][w] = pivot_row[w];
+                    pivot_row[w] = tmp;
+                }
+            }
+            for (size_t t = 0; t < found; t++)
+                if (row_bit(m.bits[rank + t], c))bit_kernel_xor(m.bits[rank + t] + w0, m.bits[rank + t] + w0, pivot_row + w0, len);
+            block_pivots[found++] = c;
+        }
+        if (found == 0)continue;
+
+        /*table[s] is the sum of the pivot rows t for the bits t of s*/
+        memset(table, 0, len * sizeof(bit_set_type));
+        for (size_t s = 1; s < ((size_t)1 << found); s++)
+            bit_kernel_xor(table + s * len, table + (s & (s - 1)) * len, m.bits[rank + __builtin_ctzll(s)] + w0, len);
+
+        /*one lookup clears the pivot columns of a row*/
+        #pragma omp parallel for schedule(static) if (rows >= GF2_PARALLEL_ROWS)
+        for (size_t i = reduced ? 0 : rank + found; i < rows; i++){
+            if (i >= rank && i < rank + found)continue;
+            bit_set_type *row = m.bits[i];
+            size_t s = 0;
+            for (size_t t = 0; t < found; t++)s |= (size_t)row_bit(row, block_pivots[t]) << t;
+            if (s != 0)bit_kernel_xor(row + w0, row + w0, table + s * len, len);
+        }
+
+        if (pivots != NULL)memcpy(pivots + rank, block_pivots, found * sizeof(size_t));
+        rank += found;
+    }
+    free(table);
+    return rank;
+}
+
+size_t gf2_rank(bit_matrix m){
+    bit_matrix copy = gf2_copy(m, m.bit_sets[0].size);
+    size_t rank = gf2_echelon(copy, false, NULL);
+    bit_matrix_free(copy);
+    return rank;
+}
+
+bit_matrix gf2_nullspace(bit_matrix m){
+    size_t cols = m.bit_sets[0].size;
+    bit_matrix reduced = gf2_copy(m, cols);
+    size_t *pivots = malloc(MAX(MIN(m.size, cols), 1) * sizeof(size_t));
+    size_t rank = gf2_echelon(reduced, true, pivots);
+
+    bool *is_pivot = calloc(MAX(cols, 1), sizeof(bool));
+    for (size_t t = 0; t < rank; t++)is_pivot[pivots[t]] = true;
+
+    /*one vector per free column f: x_f = 1, and each pivot variable equal to the entry f of its row*/
+    bit_matrix kernel = gf2_matrix_create(cols - rank, cols);
+    size_t cpt = 0;
+    for (size_t f = 0; f < cols; f++){
+        if (is_pivot[f])continue;
+        bit_set_type *v = kernel.bits[cpt++];
+        v[f / 64] |= (bit_set_type)1 << (f % 64);
+        for (size_t t = 0; t < rank; t++)
+            if (row_bit(reduced.bits[t], f))v[pivots[t] / 64] |= (bit_set_type)1 << (pivots[t] % 64);
+    }
+
+    free(is_pivot);
+    free(pivots);
+    bit_matrix_free(reduced);
+    return kernel;
+}
+
+bool gf2_solve(bit_matrix m, const bit_set_type *b, bit_set_type *x){
+    size_t rows = m.size, cols = m.bit_sets[0].size;
+    /*augmented matrix (m|b)*/
+    bit_matrix augmented = gf2_copy(m, cols + 1);
+    for (size_t i = 0; i < rows; i++)
+        if (row_bit(b, i))augmented.bits[i][cols / 64] |= (bit_set_type)1 << (cols % 64);
+
+    size_t *pivots = malloc(MAX(MIN(rows, cols + 1), 1) * sizeof(size_t));
+    size_t rank = gf2_echelon(augmented, true, pivots);
+
+    /*a pivot in the last column means 0 = 1*/
+    bool solvable = rank == 0 || pivots[rank - 1] != cols;
+    memset(x, 0, BIT_SIZE(cols) * sizeof(bit_set_type));
+    if (solvable){
+        for (size_t t = 0; t < rank; t++)
+            if (row_bit(augmented.bits[t], cols))x[pivots[t] / 64] |= (bit_set_type)1 << (pivots[t] % 64);
+    }
+
+    free(pivots);
+    bit_matrix_free(augmented);
+    return solvable;
+}
@@ -17,21 +17,89 @@
 
 #include "constants.h"
 
-#define BUCKET_SIZE 9973//2339/*prime number, good ratio size/speed*/
-//#define LIST_SIZE 1//1000
 #define N_BIT_INT 64
-#define PERMUT_N_BITS ELT_SIZE*N_BIT_INT
-//16*64 = 4^5
-//16*4  = 4^4
+#define HASH_SET_MIN_SLOTS 64
+
+uint64_t hash_words(const hash_set_store_type* key,size_t key_words){
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ key_words;
+    for (size_t i = 0; i < key_words; i++){
+        uint64_t k = key[i];
+        k ^= k >> 33;k *= 0xFF51AFD7ED558CCDULL;
+        k ^= k >> 33;k *= 0xC4CEB9FE1A85EC53ULL;
+        k ^= k >> 33;
+        h = (h ^ k) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
 
-//size_t max = 0;/*unused, maximum size of a list*/
+hash_set hash_set_init_custom(size_t key_words){
+    hash_set set = {
+        .key_words = key_words,
+        .capacity_keys = HASH_SET_MIN_SLOTS/2,
+        .n_slots = HASH_SET_MIN_SLOTS
+    };
+    set.keys = malloc(set.capacity_keys*key_words*sizeof(hash_set_store_type));
+    set.slots = calloc(set.n_slots,sizeof(size_t));
+    return set;
+}
 
 hash_set hash_set_init(){
-    hash_set list;
-    list.size = 1000;
-    list.max = 0;
-    list.list = calloc(BUCKET_SIZE*list.size,sizeof(hash_set_bitset));
-    return list;
+    return hash_set_init_custom(ELT_SIZE);
+}
+
+static bool key_equals(const hash_set_store_type* k1,const hash_set_store_type* k2,size_t key_words){
+    for (size_t i = 0; i < key_words; i++)if(k1[i] != k2[i])return false;
+    return true;
+}
+
+/*slot of the key, or the empty slot where it would be inserted*/
+static size_t hash_set_probe(const hash_set* set,const hash_set_store_type* key,uint64_t hash){
+    size_t slot = hash & (set->n_slots - 1);
+    while (set->slots[slot] != 0){
+        size_t id = set->slots[slot] - 1;
+        if(key_equals(set->keys + id*set->key_words,key,set->key_words))return slot;
+        slot = (slot + 1) & (set->n_slots - 1);
+    }
+    return slot;
+}
+
+size_t hash_set_find(const hash_set* set,const hash_set_store_type* key){
+    size_t slot = hash_set_probe(set,key,hash_words(key,set->key_words));
+    return set->slots[slot] - 1;/*HASH_SET_NOT_FOUND when the slot is empty*/
+}
+
+static void hash_set_grow(hash_set* set){
+    free(set->slots);
+    set->n_slots *= 2;
+    set->slots = calloc(set->n_slots,sizeof(size_t));
+    for (size_t id = 0; id < set->cpt_keys; id++){
+        size_t slot = hash_words(set->keys + id*set->key_words,set->key_words) & (set->n_slots - 1);
+        while (set->slots[slot] != 0)slot = (slot + 1) & (set->n_slots - 1);
+        set->slots[slot] = id + 1;
+    }
+}
+
+size_t hash_set_find_or_add(hash_set* set,const hash_set_store_type* key,bool* added){
+    size_t slot = hash_set_probe(set,key,hash_words(key,set->key_words));
+    if(added != NULL)*added = (set->slots[slot] == 0);
+    if(set->slots[slot] != 0)return set->slots[slot] - 1;
+
+    if(set->cpt_keys == set->capacity_keys){
+        set->capacity_keys *= 2;
+        set->keys = realloc(set->keys,set->capacity_keys*set->key_words*sizeof(hash_set_store_type));
+    }
+    size_t id = set->cpt_keys++;
+    for (size_t i = 0; i < set->key_words; i++)set->keys[id*set->key_words + i] = key[i];
+    set->slots[slot] = id + 1;
+
+    /*the table is kept at most half full*/
+    if(2*set->cpt_keys > set->n_slots)hash_set_grow(set);
+    return id;
+}
+
+const hash_set_store_type* hash_set_key(const hash_set* set,size_t id){
+    return set->keys + id*set->key_words;
 }
 
 bool hash_set_bitset_is_null(hash_set_bitset permut)
@@ -70,31 +138,14 @@ bool hash_set_bitset_get(hash_set_bitset permut,int number){
 }
 
 bool hash_set_exists(hash_set* list,hash_set_bitset permut){
-
-    hash_set_store_type hash = 1;/*the hash of the permutation*/
-    for (size_t i = 0; i < ELT_SIZE; i++){
-        hash = (hash*((permut.v[i]%BUCKET_SIZE)+1))%BUCKET_SIZE;/*+1 because we dont want to multiply by 0*/
-    }
-    size_t size = list->size;
-    int index = size*hash;/*each hash has a list of 2000 capacity*/
-
-    for (size_t i = 0; i < size; i++)
-    {
-        hash_set_bitset test_permut = list->list[index+i];
-
-        if(hash_set_bitset_is_null(test_permut)){/*if there is place, we store it*/
-            list->list[index+i] = permut;
-            return false;/*it was not found, we had to store it*/
-        }
-        if (hash_set_bitset_equals(permut, test_permut))
-            return true;                  /*we found it*/
-        if(i > list->max){list->max = i;} /*checks the max size of a list*/
-    }
-    print(" couac:%ld ",hash);/* if we exceed the capacity of a bucket list*/
-    return false;
+    bool added;
+    hash_set_find_or_add(list,permut.v,&added);
+    return !added;
 }
 
 void hash_set_free(hash_set* list){
-    if(list->max >= 2)print("\nmaximum bucket list size:%lu; ",list->max);/*prints the max size of a bucket list*/
-    free(list->list);
+    free(list->keys);
+    free(list->slots);
+    list->keys = NULL;
+    list->slots = NULL;
 }
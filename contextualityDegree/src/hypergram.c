@@ -20,6 +20,9 @@
 #include "constants.h"
 #include "complex_int.h"
 #include "quadrics.h"
+#include "binary_format.h"
+#include "bit_kernels.h"
+#include "gf2.h"
 
 bool is_gram_matrix_valid(bit_matrix bm)
 {
@@ -34,17 +37,28 @@ bool is_gram_matrix_valid(bit_matrix bm)
             print("error : the matrix is not valid : %ldx%ld\n",i,i);
             return false;
         }
+    }
+
+    /*the matrix is compared with its transpose row by row*/
+    bit_matrix transpose = gf2_transpose(bm);
+    size_t words = BIT_SET_ARR_SIZE(bm.bit_sets[0]);
+    bool symmetric = true;
+    for (size_t i = 0; i < bm.size && symmetric; i++)
+    {
+        if (bit_kernel_xor_popcount(bm.bits[i], transpose.bits[i], words) == 0)continue;
         for (size_t j = 0; j < bm.size; j++)
         {
             if (bit_matrix_get_bit(bm,i, j) != bit_matrix_get_bit(bm,j, i))
             {
                 print("error : the matrix is not symmetric : %ldx%ld\n", i, j);
-                return false;
+                break;
             }
         }
+        symmetric = false;
     }
+    bit_matrix_free(transpose);
     
-    return true;
+    return symmetric;
 }
 
 bit_matrix incidence_matrix(hypergram ccs)
@@ -78,11 +92,18 @@ bool is_hypergram_valid(hypergram ccs)
 
     bit_matrix incidence = incidence_matrix(ccs);
 
-    bit_matrix product = bit_matrix_product(incidence,ccs.commutation_matrix);
+    bit_matrix product = gf2_multiply(incidence,ccs.commutation_matrix);
+    bit_matrix_free(incidence);
+    if (product.bits == NULL){
+        print("error : the product of the incidence and gram matrices cannot be computed\n");
+        return false;
+    }
 
     //The hypergram is valid iff H.G = 0
 
-    if(!bit_matrix_is_empty(product)){
+    bool assignable = bit_matrix_is_empty(product);
+    bit_matrix_free(product);
+    if(!assignable){
         print("error : the hypergram is not asssignable\n");
         return false;
     }
@@ -91,6 +112,8 @@ bool is_hypergram_valid(hypergram ccs)
 }
 
 bit_matrix parse_gram_matrix(FILE* f){
+    if (binary_file_is(f, BINARY_GRAM))return binary_gram_load(f);
+
     char* line = NULL;
     size_t len = 0;
     ssize_t read;
@@ -106,13 +129,15 @@ bit_matrix parse_gram_matrix(FILE* f){
             bm = bit_matrix_create(size+1,size+1);
             print("matrix size : %ldx%ld\n",bm.size,bm.bit_sets[0].size);
         }
-        //now read every number between commas (either 0 or 1)
-        size_t index = 0;
-        for (ssize_t i = 0; i < read; i++)
+        if(cpt+1 >= bm.size)break;
+        //now read every number between commas (either 0 or 1), the row being filled word by word
+        bit_set_type *row = bm.bits[cpt+1];
+        size_t index = 1;
+        for (ssize_t i = 0; i < read && index < bm.size; i++)
         {
             char c = line[i];
             if(c != '0' && c != '1')continue;
-            bit_matrix_set_bit(bm,cpt+1,index+1,(c-'0'));
+            row[index / 64] |= (bit_set_type)(c - '0') << (index % 64);
             index++;
         }
         cpt++;
@@ -123,6 +148,8 @@ bit_matrix parse_gram_matrix(FILE* f){
 }
 
 size_t** parse_geometries(FILE* f,size_t* cpt_geometries,size_t* points_per_geometry,size_t* cpt_points){
+    if (binary_file_is(f, BINARY_HYPERGRAPH))return binary_hypergraph_load(f, cpt_geometries, points_per_geometry, cpt_points);
+
     char* line = NULL;
     size_t len = 0;
     ssize_t read;
@@ -168,6 +195,7 @@ void hypergram_free(hypergram ccs)
     free_matrix(ccs.geometries);
     bit_matrix_free(ccs.commutation_matrix);
     free(ccs.assignment);
+    free(ccs.wide_assignment);
 }
 
 hypergram hypergram_create_from_file(FILE *geometries_file, FILE *gram_file){
@@ -227,13 +255,25 @@ void hypergram_print(hypergram ccs) {
     }
     print("commutation matrix : \n");
     bit_matrix_print(ccs.commutation_matrix);
-    if(ccs.assignment == NULL)return;
+    if(ccs.assignment == NULL && ccs.wide_assignment == NULL)return;
     print("assignment : \n");
-    for (bv i = I; i <= ccs.cpt_points; i++)print_BV_custom(ccs.assignment[i],ccs.n_qubits);
+    for (bv i = I; i <= ccs.cpt_points; i++)hypergram_print_point(ccs,i);
 }
 
 size_t quantum_assignment_compute_assignment(quantum_assignment qa,bv** res)
 {
+    /*wide observables do not fit in the bv assignment of a hypergram (see quantum_assignment_to_hypergram)*/
+    if (qa.wide_observables != NULL){
+        (*res) = NULL;
+        return qa.n_observables;
+    }
+    /*a compact assignment already lists its observables*/
+    if (qa.observables != NULL){
+        (*res) = calloc(qa.n_observables+1,sizeof(bv));/*the points are printed up to cpt_points included*/
+        for (size_t i = 0; i < qa.n_observables; i++)(*res)[i] = qa.observables[i];
+        return qa.n_observables;
+    }
+
     (*res) = calloc(BV_LIMIT_CUSTOM(qa.n_qubits),sizeof(bv));
 
     //we will use this bit_vector to keep track of the observables we have already seen
@@ -266,12 +306,22 @@ hypergram quantum_assignment_to_hypergram(quantum_assignment qa) {
 
     
     res.cpt_points = quantum_assignment_compute_assignment(qa, &res.assignment);
-    size_t* reversed_assignment = calloc(BV_LIMIT_CUSTOM(qa.n_qubits),sizeof(size_t));
-    for (size_t i = 0; i < res.cpt_points; i++)reversed_assignment[res.assignment[i]] = i;
+    if (qa.wide_observables != NULL){
+        size_t point_words = WIDE_BV_WORDS(qa.n_qubits);
+        res.wide_assignment = calloc((res.cpt_points + 1) * point_words, sizeof(wide_word));
+        memcpy(res.wide_assignment, qa.wide_observables, res.cpt_points * point_words * sizeof(wide_word));
+    }
+    /*the points of a compact assignment are already the indices of the hypergram*/
+    size_t* reversed_assignment = NULL;
+    if (qa.observables == NULL && qa.wide_observables == NULL){
+        reversed_assignment = calloc(BV_LIMIT_CUSTOM(qa.n_qubits),sizeof(size_t));
+        for (size_t i = 0; i < res.cpt_points; i++)reversed_assignment[res.assignment[i]] = i;
+    }
 
     for (size_t i = 0; i < qa.cpt_geometries; i++){
         for (size_t j = 0; j < qa.points_per_geometry; j++){
-            res.geometries[i][j] = reversed_assignment[qa.geometries[qa.geometry_indices[i]][j]];
+            bv point = qa.geometries[qa.geometry_indices[i]][j];
+            res.geometries[i][j] = (reversed_assignment != NULL) ? reversed_assignment[point] : point;
         }
     }
 
@@ -281,9 +331,12 @@ hypergram quantum_assignment_to_hypergram(quantum_assignment qa) {
     print("number of points = %ld\n",res.cpt_points);
     print("matrix size : %ldx%ld\n",res.commutation_matrix.size,res.commutation_matrix.bit_sets[0].size);
 
+    size_t words = WIDE_BV_WORDS(qa.n_qubits);
     for (bv i = 0; i < res.cpt_points; i++){
         for (bv j = 0; j < res.cpt_points; j++){
-            bit_matrix_set_bit(res.commutation_matrix, i, j, innerProduct_custom(res.assignment[i], res.assignment[j], qa.n_qubits));
+            bool anticommute = (qa.wide_observables != NULL) ? wide_bv_inner_product(qa.wide_observables + i*words, qa.wide_observables + j*words, qa.n_qubits)
+                                                             : innerProduct_custom(res.assignment[i], res.assignment[j], qa.n_qubits);
+            bit_matrix_set_bit(res.commutation_matrix, i, j, anticommute);
         }
     }
 
@@ -293,68 +346,126 @@ hypergram quantum_assignment_to_hypergram(quantum_assignment qa) {
 
 
 
-bool gram_matrix_find_set_bit(bit_matrix bm,bv* assignment, int n_qubits, size_t *pivot_i, size_t *pivot_j){
-    for (size_t i = 0; i < bm.size; i++){
-        for (size_t j = 0; j < i; j++){
-            if (bit_matrix_get_bit(bm, i, j) ^ innerProduct_custom(assignment[i], assignment[j], n_qubits)){
-                *pivot_i = i;
-                *pivot_j = j;
-                return true;
-            }
+/*first row i > first_row of the residual with a set bit in a column j < i, j being the first one
+(the rows before first_row are zero, and so are the columns by symmetry)*/
+static bool residual_find_pivot(bit_matrix residual, size_t *first_row, size_t *pivot_i, size_t *pivot_j){
+    size_t words = BIT_SET_ARR_SIZE(residual.bit_sets[0]);
+    while (*first_row < residual.size && bit_kernel_none(residual.bit_sets[*first_row].bits, words))(*first_row)++;
+    for (size_t i = *first_row + 1; i < residual.size; i++){
+        const bit_set_type *row = residual.bit_sets[i].bits;
+        for (size_t w = *first_row / 64; w <= i / 64; w++){
+            bit_set_type bits = row[w];
+            if (w == i / 64)bits &= ((bit_set_type)1 << (i % 64)) - 1;/*columns before i*/
+            if (bits == 0)continue;
+            *pivot_i = i;
+            *pivot_j = w * 64 + __builtin_ctzll(bits);
+            return true;
         }
     }
     return false;
 }
 
-
-int pauli_assignment_from_anticommutations(bit_matrix gram_matrix, bv *assignment)
-{
-    //clean the assignment
-    for (size_t i = 0; i < gram_matrix.size; i++)assignment[i] = I;
-    size_t n_qubits_max = MIN((gram_matrix.size / 2) + 1,15);
-
-    size_t ith_qubit=0;
-    size_t pivot_i = 0, pivot_j = 0;
-    while (gram_matrix_find_set_bit(gram_matrix, assignment, n_qubits_max, &pivot_i, &pivot_j))
-    {
-        
-        for (size_t j = 0; j < gram_matrix.size; j++)
-        { /* pivot_i = Z,pivot_j = X*/
-            bv qubit = I;
-
-            bv bv_pivot_i = assignment[pivot_i];
-            bv bv_pivot_j = assignment[pivot_j];
-            bv bv_j = assignment[j];
-
-            if (bit_matrix_get_bit(gram_matrix, j, pivot_i) ^ innerProduct_custom(bv_j, bv_pivot_i, n_qubits_max)){
-                qubit = qubit Qplus X;
+wide_word *symplectic_gram_schmidt(bit_matrix gram_matrix, size_t *n_qubits){
+    size_t size = gram_matrix.size;
+    size_t words = BIT_SET_ARR_SIZE(gram_matrix.bit_sets[0]);
+    size_t max_qubits = size / 2 + 1;
+
+    /*residual anticommutations, not yet explained by the qubits already built*/
+    bit_matrix residual = copy_bit_matrix(gram_matrix);
+    /*points with a X (resp. Z) part on each qubit*/
+    bit_set_type *x_sets = calloc(max_qubits * words, sizeof(bit_set_type));
+    bit_set_type *z_sets = calloc(max_qubits * words, sizeof(bit_set_type));
+
+    size_t qubit = 0, first_row = 0, pivot_i = 0, pivot_j = 0;
+    while (residual_find_pivot(residual, &first_row, &pivot_i, &pivot_j))
+    {/* pivot_i = Z,pivot_j = X: the points anticommuting with pivot_i get a X, those anticommuting with pivot_j a Z*/
+        bit_set_type *x_set = x_sets + qubit * words, *z_set = z_sets + qubit * words;
+        memcpy(x_set, residual.bit_sets[pivot_i].bits, words * sizeof(bit_set_type));
+        memcpy(z_set, residual.bit_sets[pivot_j].bits, words * sizeof(bit_set_type));
+
+        /*the new qubit adds x_k.z_l + z_k.x_l to the anticommutation of k and l*/
+        for (size_t w = 0; w < words; w++){
+            for (bit_set_type bits = x_set[w] | z_set[w]; bits != 0; bits &= bits - 1){
+                size_t k = w * 64 + __builtin_ctzll(bits);
+                bit_set_type *row = residual.bit_sets[k].bits;
+                if ((x_set[w] >> (k % 64)) & 1)bit_kernel_xor(row, row, z_set, words);
+                if ((z_set[w] >> (k % 64)) & 1)bit_kernel_xor(row, row, x_set, words);
             }
-            if (bit_matrix_get_bit(gram_matrix, j, pivot_j) ^ innerProduct_custom(bv_j, bv_pivot_j, n_qubits_max)){
-                qubit = qubit Qplus Z;
-            }
-            
-            
-            assignment[j] = set_gate_custom(assignment[j], qubit, n_qubits_max - ith_qubit - 1, n_qubits_max);
-            
         }
-        
-        ith_qubit++;
-        if(ith_qubit >= n_qubits_max){
-            print("Error: too many qubits needed for the assignment\n");exit(0);
+        qubit++;
+    }
+    bit_matrix_free(residual);
+
+    /*transposition of the qubit sets into one observable per point (qubit t on the bit t)*/
+    size_t half = WIDE_BV_HALF_WORDS(qubit), point_words = WIDE_BV_WORDS(qubit);
+    wide_word *assignment = calloc(MAX(size * point_words, 1), sizeof(wide_word));
+    for (size_t t = 0; t < qubit; t++){
+        for (size_t w = 0; w < words; w++){
+            for (bit_set_type bits = x_sets[t * words + w]; bits != 0; bits &= bits - 1)
+                assignment[(w * 64 + __builtin_ctzll(bits)) * point_words + half + t / 64] |= (wide_word)1 << (t % 64);
+            for (bit_set_type bits = z_sets[t * words + w]; bits != 0; bits &= bits - 1)
+                assignment[(w * 64 + __builtin_ctzll(bits)) * point_words + t / 64] |= (wide_word)1 << (t % 64);
         }
     }
+    free(x_sets);
+    free(z_sets);
+
+    *n_qubits = qubit;
+    return assignment;
+}
 
+int pauli_assignment_from_anticommutations(bit_matrix gram_matrix, bv *assignment)
+{
+    size_t n_qubits;
+    wide_word *wide_assignment = symplectic_gram_schmidt(gram_matrix, &n_qubits);
+    if (n_qubits > BV_MAX_QUBITS){
+        print("Error: %ld qubits needed for the assignment (at most %d for a bv)\n", n_qubits, BV_MAX_QUBITS);
+        free(wide_assignment);
+        return -1;
+    }
+
+    size_t point_words = WIDE_BV_WORDS(n_qubits);
     for (size_t i = 0; i < gram_matrix.size; i++){
-        assignment[i] = extend_bv(assignment[i], n_qubits_max, ith_qubit);
-        
+        assignment[i] = (n_qubits == 0) ? I : to_index_custom(wide_assignment[i * point_words], wide_assignment[i * point_words + 1], n_qubits);
     }
-    
-    return ith_qubit;
+    free(wide_assignment);
+
+    return n_qubits;
+}
+
+/*assigns the rows of the commutation matrix to the points offset.., as bv or wide observables*/
+static void hypergram_assign(hypergram *ccs, size_t offset){
+    size_t n_qubits;
+    wide_word *wide_assignment = symplectic_gram_schmidt(ccs->commutation_matrix, &n_qubits);
+    size_t point_words = WIDE_BV_WORDS(n_qubits);
+    size_t n_points = MAX(ccs->cpt_points + 1, ccs->commutation_matrix.size + offset);
+    ccs->n_qubits = n_qubits;
+
+    free(ccs->assignment);
+    free(ccs->wide_assignment);
+    ccs->assignment = NULL;
+    ccs->wide_assignment = NULL;
+
+    if (n_qubits > BV_MAX_QUBITS){
+        ccs->wide_assignment = calloc(n_points * point_words, sizeof(wide_word));
+        memcpy(ccs->wide_assignment + offset * point_words, wide_assignment, ccs->commutation_matrix.size * point_words * sizeof(wide_word));
+    }else{
+        ccs->assignment = calloc(n_points, sizeof(bv));
+        for (size_t i = 0; i < ccs->commutation_matrix.size && n_qubits > 0; i++)
+            ccs->assignment[offset + i] = to_index_custom(wide_assignment[i * point_words], wide_assignment[i * point_words + 1], n_qubits);
+    }
+    free(wide_assignment);
 }
 
 void hypergram_compute_assignment(hypergram *ccs){
-    ccs->assignment = calloc(ccs->cpt_points+1,sizeof(bv));
-    ccs->n_qubits = pauli_assignment_from_anticommutations(ccs->commutation_matrix, ccs->assignment);
+    hypergram_assign(ccs, 0);
+}
+
+void hypergram_print_point(hypergram ccs, size_t point){
+    print("[");
+    if (ccs.wide_assignment != NULL)wide_bv_print_to_file(ccs.wide_assignment + point * WIDE_BV_WORDS(ccs.n_qubits), ccs.n_qubits, stderr);
+    else print_BV_to_file(ccs.assignment[point], ccs.n_qubits, stderr);
+    print("]");
 }
 
 quantum_assignment hypergram_to_quantum_assignment(hypergram ccs)
@@ -364,106 +475,151 @@ quantum_assignment hypergram_to_quantum_assignment(hypergram ccs)
         .geometries = (bv **)init_matrix(ccs.cpt_geometries, ccs.max_points_per_geometry, sizeof(bv)),
         .cpt_geometries = ccs.cpt_geometries,
         .points_per_geometry = ccs.max_points_per_geometry};
-    if (ccs.assignment == NULL)hypergram_compute_assignment(&ccs);
+    if (ccs.assignment == NULL && ccs.wide_assignment == NULL)hypergram_compute_assignment(&ccs);
     res.n_qubits = ccs.n_qubits;
-    
+
+    if (ccs.wide_assignment != NULL){/*the points of the hypergram are the ids of a compact assignment*/
+        size_t point_words = WIDE_BV_WORDS(ccs.n_qubits);
+        res.n_observables = ccs.cpt_points + 1;
+        res.wide_observables = calloc(res.n_observables * point_words, sizeof(wide_word));
+        memcpy(res.wide_observables + point_words, ccs.wide_assignment + point_words, ccs.cpt_points * point_words * sizeof(wide_word));
+    }
+
     for (size_t i = 0; i < ccs.cpt_geometries; i++){
         for (size_t j = 0; j < ccs.max_points_per_geometry && ccs.geometries[i][j] != 0; j++){
-            res.geometries[i][j] = ccs.assignment[ccs.geometries[i][j]];
+            res.geometries[i][j] = (ccs.wide_assignment != NULL) ? ccs.geometries[i][j] : ccs.assignment[ccs.geometries[i][j]];
         }
     }
 
     quantum_assignment_autofill_indices(&res);
     quantum_assignment_compute_negativity(&res);
+    quantum_assignment_compact(&res);
     
     return res;
 }
 
 
-void iterate_contexts_rec(hypergram* ccs, size_t ctx_size, size_t point_index, size_t* capacity)
-{
-    if (point_index >= ccs->cpt_points || is_done)return; // no more points to consider
+/*contexts found from one starting point, stored one after the other, each ended by a 0*/
+typedef struct {
+    size_t* points;
+    size_t cpt_points;
+    size_t capacity;
+    size_t cpt_contexts;
+    size_t max_points_per_context;
+} context_buffer;
 
-    // Include the current point in the context iff it does commute with all points in the current context
-    for (size_t i = 0; i < ctx_size; i++)
-    {
-        size_t point = ccs->geometries[ccs->cpt_geometries][i];
-        //print("checking point %ld with index %ld\n", point, point_index);
-        if (bit_matrix_get_bit(ccs->commutation_matrix, point, point_index))return; // if the point does not commute with the current context, we cannot include it
+static void context_buffer_push(context_buffer* buffer,const size_t* context,size_t ctx_size){
+    if(buffer->cpt_points + ctx_size + 1 > buffer->capacity){
+        buffer->capacity = 2*(buffer->cpt_points + ctx_size + 1);
+        buffer->points = realloc(buffer->points,buffer->capacity*sizeof(size_t));
     }
+    for (size_t i = 0; i < ctx_size; i++)buffer->points[buffer->cpt_points++] = context[i];
+    buffer->points[buffer->cpt_points++] = 0;
+    buffer->cpt_contexts++;
+    if(ctx_size > buffer->max_points_per_context)buffer->max_points_per_context = ctx_size;
+}
 
-    // Include the current point in the context
-    ccs->geometries[ccs->cpt_geometries][ctx_size] = point_index; // store the point index (1-based)
-    ctx_size++;
-
-
-    // print ("context found: ");
-    //for (size_t i = 0; i < ctx_size; i++)print("%ld ", ccs->geometries[ccs->cpt_geometries][i]);
-    //print("\n");
-
-    // check that the vector sum of the context is 0
-    bit_vector context_sum = bit_set_create(ccs->cpt_points, NULL);
-    for (size_t i = 0; i < ctx_size; i++)
-    {
-        size_t point = ccs->geometries[ccs->cpt_geometries][i];
-
-        bit_set_apply_op(&context_sum, ccs->commutation_matrix.bit_sets[point], '^');
-    }
-    if (bit_set_is_empty(context_sum) && ctx_size > 0)
-    {
-        ccs->geometries[ccs->cpt_geometries][ctx_size] = 0; // terminate the context
-        //copy into the next context in case another greater context is found
-        for (size_t i = 0; i < ctx_size + 1; i++)
-        {
-            ccs->geometries[ccs->cpt_geometries + 1][i] = ccs->geometries[ccs->cpt_geometries][i];
+/**
+ * @brief depth-first enumeration of the cliques of the commutation graph extending a context
+ * 
+ * candidates[depth] holds the points greater than the last one of the context which commute with
+ * all of it, sums[depth] the XOR of the commutation rows of the context (0 iff the product of the
+ * observables commutes with everything, i.e. is the identity up to a phase)
+ */
+static void iterate_contexts(const bit_matrix* commutation_matrix, size_t words, size_t* context, size_t depth,
+                             bit_set_type* candidates, bit_set_type* sums, context_buffer* buffer)
+{
+    const bit_set_type* cand = candidates + depth*words;
+    const bit_set_type* sum = sums + depth*words;
+    bit_set_type* next_cand = candidates + (depth+1)*words;
+    bit_set_type* next_sum = sums + (depth+1)*words;
+
+    for (size_t w = 0; w < words && !is_done; w++){
+        for (bit_set_type bits = cand[w]; bits != 0 && !is_done; bits &= bits - 1){
+            size_t point = w*64 + __builtin_ctzll(bits);
+            const bit_set_type* row = commutation_matrix->bit_sets[point].bits;
+            context[depth] = point;
+
+            bit_kernel_xor(next_sum, sum, row, words);
+            if(bit_kernel_none(next_sum, words))context_buffer_push(buffer,context,depth+1);
+
+            /*only the points after this one, which commute with it, can extend the context*/
+            memset(next_cand, 0, w*sizeof(bit_set_type));
+            next_cand[w] = bits & (bits - 1) & ~row[w];
+            bit_kernel_andnot(next_cand + w + 1, cand + w + 1, row + w + 1, words - w - 1);
+            if(bit_kernel_any(next_cand + w, words - w))iterate_contexts(commutation_matrix,words,context,depth+1,candidates,sums,buffer);
         }
-        ccs->cpt_geometries++;
-        if (ccs->cpt_geometries+1 >= *capacity)print("capacity reached !\n");
-        
-        if (ctx_size > ccs->max_points_per_geometry)ccs->max_points_per_geometry = ctx_size;
-    }
-    bit_set_free(context_sum);
-
-    for (size_t i = point_index + 1; i < ccs->cpt_points; i++)
-    {
-        // Recur with the next point
-        iterate_contexts_rec(ccs, ctx_size, i, capacity);
     }
 }
 
-//same as old one but recursive
+/**
+ * @brief builds the hypergram whose contexts are all the sets of pairwise commuting points whose product
+ * is the identity, in lexicographic order (point 0, the identity, being excluded)
+ * 
+ * The starting points are explored in parallel and their contexts concatenated in order
+ */
 hypergram build_full_CCS_fast(bit_matrix bm)
 {
-
-    size_t capacity = bm.size * 10000; // initial capacity for geometries, can be adjusted
+    size_t n = bm.size;
+    size_t words = BIT_SIZE(n);
 
     hypergram ccs = {
-        .geometries = (size_t **)init_matrix(capacity, bm.size + 1, sizeof(size_t)),
         .cpt_geometries = 0,
-        .cpt_points = bm.size,
-        .n_qubits = bm.size,//just in case
+        .cpt_points = n,
+        .n_qubits = n,//just in case
         .max_points_per_geometry = 0,
         .commutation_matrix = copy_bit_matrix(bm),
-        .assignment = calloc(bm.size + 1, sizeof(bv)),
-
+        .assignment = calloc(n + 1, sizeof(bv)),
     };
 
-    bit_matrix_print(bm);
+    context_buffer* buffers = calloc(n, sizeof(context_buffer));
 
-    
-    for (size_t i = 1; i <= bm.size; i++)
+    #pragma omp parallel
     {
-        iterate_contexts_rec(&ccs, 0, i,&capacity);
+        size_t* context = malloc((n + 1)*sizeof(size_t));
+        bit_set_type* candidates = calloc((n + 1)*words, sizeof(bit_set_type));
+        bit_set_type* sums = calloc((n + 1)*words, sizeof(bit_set_type));
+
+        #pragma omp for schedule(dynamic,1)
+        for (size_t first = 1; first < n; first++){
+            const bit_set_type* row = ccs.commutation_matrix.bit_sets[first].bits;
+            context[0] = first;
+            memcpy(sums + words, row, words*sizeof(bit_set_type));
+            memset(candidates + words, 0, words*sizeof(bit_set_type));
+            if(bit_kernel_none(row, words))context_buffer_push(&buffers[first],context,1);
+
+            /*points after the first one commuting with it*/
+            for (size_t point = first + 1; point < n; point++){
+                if(!bit_matrix_get_bit(ccs.commutation_matrix, first, point))candidates[words + point/64] |= (bit_set_type)1 << (point%64);
+            }
+            iterate_contexts(&ccs.commutation_matrix,words,context,1,candidates,sums,&buffers[first]);
+        }
+        free(context);
+        free(candidates);
+        free(sums);
     }
 
-    // increment the every non-empty context by 1 to make it 1-based
-    for (size_t i = 0; i < ccs.cpt_geometries; i++)
-    {
-        for (size_t j = 0; j < ccs.max_points_per_geometry && ccs.geometries[i][j] != 0; j++)
-        {
-            ccs.geometries[i][j]++;
+    for (size_t first = 1; first < n; first++){
+        ccs.cpt_geometries += buffers[first].cpt_contexts;
+        if(buffers[first].max_points_per_context > ccs.max_points_per_geometry)ccs.max_points_per_geometry = buffers[first].max_points_per_context;
+    }
+
+    // every context is made 1-based and ended by a 0, the zeroed matrix having one more column than the largest context
+    ccs.geometries = (size_t **)init_matrix(ccs.cpt_geometries + 1, ccs.max_points_per_geometry + 1, sizeof(size_t));
+    size_t geometry = 0;
+    for (size_t first = 1; first < n; first++){
+        size_t j = 0;
+        for (size_t k = 0; k < buffers[first].cpt_points; k++){
+            if(buffers[first].points[k] == 0){
+                geometry++;
+                j = 0;
+                continue;
+            }
+            ccs.geometries[geometry][j++] = buffers[first].points[k] + 1;
         }
+        free(buffers[first].points);
     }
+    free(buffers);
 
     return ccs;
 }
@@ -480,7 +636,7 @@ quantum_assignment gram_matrix_to_quantum_assignment(bit_matrix gram){
         //print("\n");
     }
 
-    ccs.n_qubits = pauli_assignment_from_anticommutations(ccs.commutation_matrix, &(ccs.assignment[1]));
+    hypergram_assign(&ccs, 1);
     
     
     
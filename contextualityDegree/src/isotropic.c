@@ -0,0 +1,259 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file isotropic.c
+ * @brief ranking and unranking of the totally isotropic subspaces
+ */
+#include "isotropic.h"
+
+#include "quadrics.h"
+
+#include <string.h>
+
+uint64_t isotropic_count(int n_qubits,int dim){
+    if(dim < 0 || dim > n_qubits)return 0;
+    /*N(n,j) = N(n,j-1) (4^(n-j+1)-1) / (2^j-1)*/
+    uint64_t count = 1;
+    for (int j = 1; j <= dim; j++)count = count * (uint64_t)(pow4(n_qubits-j+1)-1) / (uint64_t)(pow2(j)-1);
+    return count;
+}
+
+/*projection of an observable of n qubits onto the n-1 first qubits*/
+static bv drop_last_qubit(bv x,int n_qubits){
+    return ((x >> 1) & mask(n_qubits-1)) | (((x >> (n_qubits+1)) & mask(n_qubits-1)) << (n_qubits-1));
+}
+
+/*inverse of drop_last_qubit, the last qubit being I*/
+static bv lift_last_qubit(bv y,int n_qubits){
+    return ((y & mask(n_qubits-1)) << 1) | (((y >> (n_qubits-1)) & mask(n_qubits-1)) << (n_qubits+1));
+}
+
+/*bits of the n-1 first qubits*/
+static bv first_qubits_mask(int n_qubits){
+    return mask(2*n_qubits) & ~(bv)1 & ~((bv)1 << n_qubits);
+}
+
+/**
+ * @brief reduced row echelon form of vectors, pivots taken on the bits of pivot_mask
+ * (from the highest one), rows sorted by decreasing pivot and null rows at the end
+ * 
+ * @return int rank
+ */
+static int echelon(bv* rows,int size,bv pivot_mask){
+    int rank = 0;
+    for (int bit = 8*sizeof(bv)-1; bit >= 0 && rank < size; bit--){
+        if(!BGET(pivot_mask,bit))continue;
+        int selected = -1;
+        for (int i = rank; i < size && selected == -1; i++)if(BGET(rows[i],bit))selected = i;
+        if(selected == -1)continue;
+        bv tmp = rows[rank];rows[rank] = rows[selected];rows[selected] = tmp;
+        for (int i = 0; i < size; i++)if(i != rank && BGET(rows[i],bit))rows[i] ^= rows[rank];
+        rank++;
+    }
+    return rank;
+}
+
+static int highest_bit(bv x){
+    return 8*sizeof(bv) - 1 - __builtin_clz(x);
+}
+
+void isotropic_unrank(int n_qubits,int dim,uint64_t rank,bv* basis){
+    if(dim == 0)return;
+
+    bv p = (bv)1 << n_qubits,f = 1;
+    int n = n_qubits - 1;
+    uint64_t count_a = isotropic_count(n,dim-1);
+    uint64_t count_b = isotropic_count(n,dim) << dim;
+
+    if(rank < count_a){/*(a) p in S*/
+        isotropic_unrank(n,dim-1,rank,basis);
+        for (int i = 0; i < dim-1; i++)basis[i] = lift_last_qubit(basis[i],n_qubits);
+        basis[dim-1] = p;
+        return;
+    }
+    rank -= count_a;
+
+    if(rank < count_b){/*(b) S in p^perp, graph of a linear form*/
+        uint64_t form = rank & mask(dim);
+        isotropic_unrank(n,dim,rank >> dim,basis);
+        echelon(basis,dim,mask(2*n));
+        for (int i = 0; i < dim; i++)basis[i] = lift_last_qubit(basis[i],n_qubits) | (BGET(form,i) ? p : 0);
+        return;
+    }
+    rank -= count_b;
+
+    /*(c) S = S0 + <v>, v = f + a.p + w*/
+    int coset_bits = 2*n_qubits - dim;
+    uint64_t coset = rank & mask(coset_bits);
+    isotropic_unrank(n,dim-1,rank >> coset_bits,basis);
+    echelon(basis,dim-1,mask(2*n));
+
+    bv pivots = 0;
+    for (int i = 0; i < dim-1; i++)pivots |= (bv)1 << highest_bit(basis[i]);
+    bv w = 0;
+    int j = 0;
+    for (int pos = 0; pos < 2*n; pos++){
+        if(BGET(pivots,pos))continue;
+        if(BGET(coset,j))w |= (bv)1 << pos;
+        j++;
+    }
+    bool alpha = BGET(coset,coset_bits-1);
+
+    for (int i = 0; i < dim-1; i++){
+        bool form = innerProduct_custom(w,basis[i],n);
+        basis[i] = lift_last_qubit(basis[i],n_qubits) | (form ? p : 0);
+    }
+    basis[dim-1] = f | (alpha ? p : 0) | lift_last_qubit(w,n_qubits);
+}
+
+uint64_t isotropic_rank(int n_qubits,int dim,const bv* basis){
+    if(dim == 0)return 0;
+
+    bv p = (bv)1 << n_qubits,f = 1;
+    int n = n_qubits - 1;
+    uint64_t count_a = isotropic_count(n,dim-1);
+    uint64_t count_b = isotropic_count(n,dim) << dim;
+    bv w_mask = first_qubits_mask(n_qubits);
+
+    bv rows[dim],projection[dim];
+    memcpy(rows,basis,dim*sizeof(bv));
+
+    int with_f = -1;
+    for (int i = 0; i < dim && with_f == -1; i++)if(rows[i] & f)with_f = i;
+
+    if(with_f == -1){
+        int rank_w = echelon(rows,dim,w_mask);
+        for (int i = 0; i < dim; i++)projection[i] = drop_last_qubit(rows[i],n_qubits);
+
+        if(rank_w == dim-1)/*(a) p in S*/
+            return isotropic_rank(n,dim-1,projection);
+
+        /*(b) the reduced rows carry the linear form on their p coordinate*/
+        uint64_t form = 0;
+        for (int i = 0; i < dim; i++)if(rows[i] & p)form |= 1ULL << i;
+        return count_a + (isotropic_rank(n,dim,projection) << dim) + form;
+    }
+
+    /*(c) S0 = S inter p^perp is spanned by the other rows once v is added to them*/
+    bv v = rows[with_f];
+    rows[with_f] = rows[dim-1];
+    for (int i = 0; i < dim-1; i++)if(rows[i] & f)rows[i] ^= v;
+    echelon(rows,dim-1,w_mask);
+
+    bv pivots = 0;
+    for (int i = 0; i < dim-1; i++){
+        int pivot = highest_bit(rows[i] & w_mask);
+        if(BGET(v,pivot))v ^= rows[i];
+        projection[i] = drop_last_qubit(rows[i],n_qubits);
+        pivots |= (bv)1 << highest_bit(projection[i]);
+    }
+
+    int coset_bits = 2*n_qubits - dim;
+    bv w = drop_last_qubit(v,n_qubits);
+    uint64_t coset = 0;
+    int j = 0;
+    for (int pos = 0; pos < 2*n; pos++){
+        if(BGET(pivots,pos))continue;
+        if(BGET(w,pos))coset |= 1ULL << j;
+        j++;
+    }
+    if(v & p)coset |= 1ULL << (coset_bits-1);
+
+    return count_a + count_b + (isotropic_rank(n,dim-1,projection) << coset_bits) + coset;
+}
+
+static int bv_cmp(const void* a,const void* b){
+    bv x = *(const bv*)a,y = *(const bv*)b;
+    return (x > y) - (x < y);
+}
+
+void isotropic_points(int dim,const bv* basis,bv* row){
+    size_t n_points = NB_OBS_PER_GENERATOR(dim);
+    bv sorted[n_points];
+    for (size_t i = 1; i <= n_points; i++){
+        bv sum = I;
+        for (int j = 0; j < dim; j++)if(BGET(i,j))sum ^= basis[j];
+        sorted[i-1] = sum;
+    }
+    qsort(sorted,n_points,sizeof(bv),bv_cmp);
+
+    /*the l-th generator is the smallest point outside the span of the previous ones*/
+    size_t span_size = 0;
+    size_t next = 0;
+    for (int l = 0; l < dim; l++){
+        bv generator = I;
+        for (; next < n_points && generator == I; next++){
+            bool in_span = false;
+            for (size_t i = 0; i < span_size && !in_span; i++)in_span = (row[i] == sorted[next]);
+            if(!in_span)generator = sorted[next];
+        }
+        row[span_size] = generator;
+        for (size_t i = 0; i < span_size; i++)row[span_size + 1 + i] = row[i] ^ generator;
+        span_size = 2*span_size + 1;
+    }
+}
+
+quantum_assignment isotropic_subspaces_range(int n_qubits,int k,uint64_t first,uint64_t count){
+    int dim = k + 1;
+    uint64_t total = isotropic_count(n_qubits,dim);
+    if(first >= total)count = 0;
+    else count = MIN(count,total - first);
+
+    int size = NB_OBS_PER_GENERATOR(dim);
+    quantum_assignment qa = {
+        .geometries = (bv**)init_matrix(MAX(count,1),size,sizeof(bv)),
+        .cpt_geometries = count,
+        .points_per_geometry = size,
+        .n_qubits = n_qubits
+    };
+    quantum_assignment_autofill_indices(&qa);
+
+    /*every rank is unranked independently: equal contiguous chunks and no lock*/
+    #pragma omp parallel for schedule(static)
+    for (uint64_t i = 0; i < count; i++){
+        bv basis[dim];
+        memset(basis,0,sizeof(basis));
+        isotropic_unrank(n_qubits,dim,first + i,basis);
+        isotropic_points(dim,basis,qa.geometries[i]);
+        if(CHECK_SUBSPACES_LINES_EVEN){
+            bv bv1[size + 1];
+            bv1[0] = I;
+            memcpy(bv1 + 1,qa.geometries[i],size*sizeof(bv));
+            subspace_neg_lines_count(n_qubits,k,bv1);
+        }
+    }
+    return qa;
+}
+
+quantum_assignment isotropic_subspaces_sample(int n_qubits,int k,size_t count){
+    int dim = k + 1;
+    uint64_t total = isotropic_count(n_qubits,dim);
+    int size = NB_OBS_PER_GENERATOR(dim);
+    quantum_assignment qa = {
+        .geometries = (bv**)init_matrix(MAX(count,1),size,sizeof(bv)),
+        .cpt_geometries = (total == 0) ? 0 : count,
+        .points_per_geometry = size,
+        .n_qubits = n_qubits
+    };
+    quantum_assignment_autofill_indices(&qa);
+
+    /*rejection sampling below the largest multiple of total to avoid the modulo bias*/
+    uint64_t limit = (total == 0) ? 0 : UINT64_MAX - (UINT64_MAX % total);
+    #pragma omp parallel for
+    for (size_t i = 0; i < qa.cpt_geometries; i++){
+        uint64_t r;
+        do{
+            r = ((uint64_t)fast_random() << 32) | fast_random();
+        }while(r >= limit);
+        bv basis[dim];
+        memset(basis,0,sizeof(basis));
+        isotropic_unrank(n_qubits,dim,r % total,basis);
+        isotropic_points(dim,basis,qa.geometries[i]);
+    }
+    return qa;
+}
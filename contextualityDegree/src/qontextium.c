@@ -16,7 +16,14 @@
 #include "complex_int.h"
 #include "quadrics.h"
 #include "hypergram.h"
+#include "binary_format.h"
+#include "export.h"
 #include "cayley_hexagon.h"
+#include "family.h"
+#include "isotropic.h"
+#include "analysis.h"
+#include "batch.h"
+#include "server.h"
 
 #include <sys/wait.h>
 #include <stdio.h>
@@ -44,9 +51,33 @@ bool
     SET_IMPORT_ASSIGNMENT = false,
     SET_IMPORT_HYPERGRAM = false,
     SET_IMPORT_GRAM = false,
-    SET_EXPORT = false;
+    SET_EXPORT = false,
+    SET_FAMILY = false,
+    SET_ORBITS = false;
 
 EXPORT_TYPE export_type = EXPORT_ALL;
+export_format export_file_format = EXPORT_FORMAT_CSV;
+size_t export_xcnf_bound = 0;
+
+/*file receiving the results table of the family mode*/
+char* family_csv_path = NULL;
+
+/*solution codes analysed by --analyze, and the file receiving their records*/
+char* analysis_input_path = NULL;
+char* analysis_output_path = NULL;
+
+/*binary file receiving the imported configuration and its best solution (--save-binary)*/
+char* binary_output_path = NULL;
+
+/*manifest of the batch mode, and the file its results are appended to (standard output if NULL)*/
+char* batch_manifest_path = NULL;
+char* batch_output_path = NULL;
+
+/*Unix domain socket of the server mode (--serve)*/
+char* server_socket_path = NULL;
+
+/*if not 0, number of subspaces drawn uniformly instead of generating all of them*/
+size_t subspaces_sample_size = 0;
 
 
 
@@ -66,8 +97,10 @@ int geometry_contextuality_degree_and_print(quantum_assignment* qa,bool contextu
     
     
     
-    if(bool_sol == NULL)bool_sol = calloc(BV_LIMIT_CUSTOM(qa->n_qubits),sizeof(bool));
+    if(bool_sol == NULL)bool_sol = calloc(quantum_assignment_n_points(qa),sizeof(bool));
     int deg = geometry_contextuality_degree(qa, contextuality_only, print_solution, optimistic, bool_sol);
+    /*CTRL+C only stops the heuristic search, whose best solution is then printed*/
+    if (global_solver_mode == INVALID_LINES_HEURISTIC_SOLVER)is_done = false;
 
     check_contextuality_solution(qa, bool_sol, /* print_solution ? stderr :  */ NULL);
 
@@ -95,11 +128,19 @@ int geometry_contextuality_degree_and_print(quantum_assignment* qa,bool contextu
     if (print_solution)
     {
         print("\nsolution code: ");
-        print_bool(bool_sol, BV_LIMIT_CUSTOM(qa->n_qubits));
+        print_bool(bool_sol, quantum_assignment_n_points(qa));
         print("\n");
     }
 
     print_quantum_assignment(qa);
+    if (SET_EXPORT)
+    {
+        /*the requested contexts are written to the standard output*/
+        quantum_assignment exported = (export_type == EXPORT_ALL) ? *qa : quantum_assignment_from_invalid_contexts(*qa, bool_sol, export_type == EXPORT_VALID);
+        if (!export_quantum_assignment(&exported, export_file_format, export_xcnf_bound, stdout))print("export error\n");
+        fflush(stdout);
+        if (export_type != EXPORT_ALL)free_quantum_assignment(&exported);
+    }
     print("number of contexts:%ld\n", qa->cpt_geometries);
     print("number of negative contexts:%d\n", negative_lines_count(qa));
     print("best Hamming distance found: %d\n", deg);
@@ -274,6 +315,34 @@ int main(int argc, char **argv)
                     }else{
                         print("no file specified\n");
                     }
+                }else if(strcmp(argv[i],"binary") == 0){
+                    i++;
+                    if (i < argc)
+                    {
+                        FILE *f = fopen(argv[i], "rb");
+                        if (f == NULL)
+                        {
+                            print("file not found\n");
+                            return 0;
+                        }
+                        bool *stored_sol = NULL;
+                        binary_assignment_stats stats;
+                        import_qa = binary_assignment_load(f, &stored_sol, &stats);
+                        fclose(f);
+                        if (import_qa.geometries == NULL)
+                        {
+                            print("error while importing binary assignment\n");
+                            return 0;
+                        }
+                        if (stored_sol != NULL)
+                            print("stored solution: %ld invalid lines, %ld vertices, maximum degree %ld\n",
+                                  (long)stats.invalid_lines, (long)stats.vertices, (long)stats.max_degree);
+                        free(stored_sol);
+                        SET_IMPORT_ASSIGNMENT = true;
+                        VARQ = import_qa.n_qubits;
+                    }else{
+                        print("no file specified\n");
+                    }
                 }else if(strcmp(argv[i],"hypergram") == 0){
                     //two files needed
                     if (i + 2 < argc)
@@ -300,7 +369,7 @@ int main(int argc, char **argv)
                         for (size_t i = 1; i <= import_hg.cpt_points; i++)
                         {
                             print(", %ld: ", i);
-                            print_BV_custom(import_hg.assignment[i], import_hg.n_qubits);
+                            hypergram_print_point(import_hg, i);
                         }
 
                         print("\nnumber of qubits:%ld\n",import_hg.n_qubits);
@@ -338,7 +407,7 @@ int main(int argc, char **argv)
                         for (size_t i = 1; i <= import_hg.cpt_points; i++)
                         {
                             print(", %ld: ", i);
-                            print_BV_custom(import_hg.assignment[i], import_hg.n_qubits);
+                            hypergram_print_point(import_hg, i);
                         }
                         print("\nnumber of qubits:%ld\n",import_hg.n_qubits);
                         import_qa = hypergram_to_quantum_assignment(import_hg);
@@ -359,6 +428,131 @@ int main(int argc, char **argv)
         {
             SET_ALL_QUADRICS = true;
         }
+        else if (strcmp(argv[i], "--sample") == 0)
+        {
+            i++;
+            if (i < argc)
+            {
+                subspaces_sample_size = strtoul(argv[i], NULL, 10);
+                print("sampled subspaces: %ld\n", subspaces_sample_size);
+            }
+        }
+        else if (strcmp(argv[i], "--orbits") == 0)
+        {
+            SET_ORBITS = true;
+        }
+        else if (strcmp(argv[i], "--csv") == 0)
+        {
+            i++;
+            if (i < argc)
+            {
+                /*the whole family is solved without interaction*/
+                SET_FAMILY = true;
+                SET_ALL_QUADRICS = true;
+                global_interact_with_user = false;
+                family_csv_path = argv[i];
+                print("results table: %s\n", family_csv_path);
+            }else{
+                print("no file specified\n");
+            }
+        }
+        else if (strcmp(argv[i], "--analyze") == 0)
+        {
+            if (i + 2 < argc)
+            {
+                /*the solutions of the imported configuration are analysed without interaction*/
+                analysis_input_path = argv[i + 1];
+                analysis_output_path = argv[i + 2];
+                global_interact_with_user = false;
+                i += 2;
+            }else{
+                print("usage: --analyze SOLUTIONS OUTPUT\n");
+            }
+        }
+        else if (strcmp(argv[i], "--batch") == 0)
+        {
+            i++;
+            if (i < argc)
+            {
+                /*the jobs of the manifest are solved without interaction*/
+                batch_manifest_path = argv[i];
+                global_interact_with_user = false;
+                if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)batch_output_path = argv[++i];
+            }else{
+                print("usage: --batch MANIFEST [OUTPUT]\n");
+            }
+        }
+        else if (strcmp(argv[i], "--serve") == 0)
+        {
+            i++;
+            if (i < argc)
+            {
+                /*the requests of the clients are solved without interaction*/
+                server_socket_path = argv[i];
+                global_interact_with_user = false;
+            }else{
+                print("usage: --serve SOCKET\n");
+            }
+        }
+        else if (strcmp(argv[i], "--cache") == 0)
+        {
+            i++;
+            if (i < argc)
+            {
+                global_cache_directory = argv[i];
+                print("results cache: %s\n", global_cache_directory);
+            }else{
+                print("no directory specified\n");
+            }
+        }
+        else if (strcmp(argv[i], "--save-binary") == 0)
+        {
+            i++;
+            if (i < argc)
+            {
+                binary_output_path = argv[i];
+                print("binary assignment: %s\n", binary_output_path);
+            }else{
+                print("no file specified\n");
+            }
+        }
+        else if (strcmp(argv[i], "--convert") == 0)
+        {
+            /*converts a text file into a binary one and stops*/
+            if (i + 3 >= argc)
+            {
+                print("usage: --convert [gram|hypergraph|assignment] INPUT OUTPUT\n");
+                return 0;
+            }
+            binary_kind kind;
+            if (strcmp(argv[i + 1], "gram") == 0){
+                kind = BINARY_GRAM;
+            }else if (strcmp(argv[i + 1], "hypergraph") == 0){
+                kind = BINARY_HYPERGRAPH;
+            }else if (strcmp(argv[i + 1], "assignment") == 0){
+                kind = BINARY_ASSIGNMENT;
+            }else{
+                print("unknown file kind: %s\n", argv[i + 1]);
+                return 0;
+            }
+            FILE *input = fopen(argv[i + 2], "r");
+            if (input == NULL)
+            {
+                print("file not found\n");
+                return 0;
+            }
+            FILE *output = fopen(argv[i + 3], "wb");
+            if (output == NULL)
+            {
+                print("cannot write %s\n", argv[i + 3]);
+                fclose(input);
+                return 0;
+            }
+            if (binary_convert(kind, input, output))print("binary file written: %s\n", argv[i + 3]);
+            fclose(input);
+            fclose(output);
+            return 0;
+        }
         else if (strcmp(argv[i], "--export") == 0)
         {
             SET_EXPORT = true;
@@ -376,8 +570,14 @@ int main(int argc, char **argv)
                 {
                     export_type = EXPORT_INVALID;
                 }
+                /*optional format, CSV by default*/
+                if (i + 1 < argc && export_format_parse(argv[i + 1], &export_file_format))i++;
             }
         }
+        else if (strcmp(argv[i], "--xcnf-bound") == 0){
+            i++;
+            if (i < argc)export_xcnf_bound = strtoul(argv[i], NULL, 10);
+        }
         else if (strcmp(argv[i], "--no-interaction") == 0){
             global_interact_with_user = false;
         }
@@ -395,6 +595,13 @@ int main(int argc, char **argv)
                 print("heuristic threshold:%f\n",global_heuristic_threshold);
             }
         }
+        else if (strcmp(argv[i], "--heuristic-stop-regular") == 0){
+            i++;
+            if (i < argc){
+                global_heuristic_stop_regular = atoi(argv[i]);
+                print("heuristic stop on regular invalid configurations of degree %d\n", global_heuristic_stop_regular);
+            }
+        }
         else if (strcmp(argv[i], "--heuristic-flip-prob") == 0){
             i++;
             if (i < argc){
@@ -407,41 +614,63 @@ int main(int argc, char **argv)
     print(" number of qubits: %d\n", VARQ);
 
 
-    bool *my_bool_sol = calloc(BV_LIMIT_CUSTOM(VARQ), sizeof(bool));
+    /*imported configurations are compact and get their own solution array*/
+    bool *my_bool_sol = (SET_IMPORT_ASSIGNMENT || SET_IMPORT_HYPERGRAM || SET_IMPORT_GRAM) ? NULL : calloc(BV_LIMIT_CUSTOM(VARQ), sizeof(bool));
+
+    /*configurations collected in family mode (--csv), solved all together at the end*/
+    configuration_family family = {0};
 
     // #pragma omp parallel for shared(is_done)
     if(SET_PERPSETS || SET_HYPERBOLICS || SET_ELLIPTICS){
-        for (bv i = I; i < (bv)BV_LIMIT_CUSTOM(VARQ); i++)
+        /*the geometries are generated by blocks of ZERO_LOCUS_BLOCK_SIZE base observables*/
+        bit_matrix perpset_block = bit_matrix_create(ZERO_LOCUS_BLOCK_SIZE, NB_LINES_CUSTOM(VARQ) + 1);
+        bit_matrix quadric_block = bit_matrix_create(ZERO_LOCUS_BLOCK_SIZE, NB_LINES_CUSTOM(VARQ) + 1);
+        bool elliptic[ZERO_LOCUS_BLOCK_SIZE];
+        bool stop = false;
+        for (bv first = I; first < (bv)BV_LIMIT_CUSTOM(VARQ) && !stop && !is_done; first += ZERO_LOCUS_BLOCK_SIZE)
         {
-            if (is_done)continue;
-
-            bool *bool_sol = calloc(BV_LIMIT_CUSTOM(VARQ), sizeof(bool));
-
-            quantum_assignment qa = (quantum_assignment){0};
-
-            if (SET_PERPSETS && i != I)
-            {
-                qa = perpset(i, lines_indices, VARQ, lines_qa.geometries, complement);
-                geometry_contextuality_degree_and_print(&qa, false, true, false, NULL);
-                print_quantum_assignment(&qa);
-                if (!SET_ALL_QUADRICS)
-                    break;
-            }
+            int count = 0;
+            if (SET_PERPSETS)
+                count = zero_locus_block(ZERO_LOCUS_PERPSET, first, complement, lines_qa, lines_indices, perpset_block, NULL);
             if (SET_HYPERBOLICS || SET_ELLIPTICS)
+                count = zero_locus_block(ZERO_LOCUS_QUADRIC, first, complement, lines_qa, lines_indices, quadric_block, elliptic);
+
+            for (int t = 0; t < count && !stop && !is_done; t++)
             {
-                qa = quadric(i, lines_indices, VARQ, lines_qa.geometries, complement);
-                size_t expected_size = complement ? lines_qa.cpt_geometries - qa.cpt_geometries : qa.cpt_geometries;
-                if ((expected_size == (size_t)NB_LINES_PER_HYPERBOLIC(qa.n_qubits) && SET_HYPERBOLICS) ||
-                    (expected_size == (size_t)NB_LINES_PER_ELLIPTIC(qa.n_qubits) && SET_ELLIPTICS))
+                bv i = first + t;
+                if (SET_PERPSETS && i != I)
+                {
+                    quantum_assignment qa = lines_subset(lines_qa, perpset_block.bit_sets[t]);
+                    if (SET_FAMILY)
+                    {
+                        family_add(&family, i, qa);
+                    }
+                    else
+                    {
+                        geometry_contextuality_degree_and_print(&qa, false, true, false, NULL);
+                        print_quantum_assignment(&qa);
+                        free_quantum_assignment(&qa);
+                        if (!SET_ALL_QUADRICS)
+                            stop = true;
+                    }
+                }
+                if (!stop && (SET_HYPERBOLICS || SET_ELLIPTICS) && ((elliptic[t] && SET_ELLIPTICS) || (!elliptic[t] && SET_HYPERBOLICS)))
                 {
+                    quantum_assignment qa = lines_subset(lines_qa, quadric_block.bit_sets[t]);
+                    if (SET_FAMILY)
+                    {
+                        family_add(&family, i, qa);
+                        continue;
+                    }
                     geometry_contextuality_degree_and_print(&qa, false, true, false, my_bool_sol);
-                    if (!SET_ALL_QUADRICS)break;
+                    free_quantum_assignment(&qa);
+                    if (!SET_ALL_QUADRICS)
+                        stop = true;
                 }
-                
             }
-            free_quantum_assignment(&qa);
-            free(bool_sol);
         }
+        bit_matrix_free(perpset_block);
+        bit_matrix_free(quadric_block);
     }
     
 
@@ -456,7 +685,8 @@ int main(int argc, char **argv)
         }else{
             print("\nGenerating subspaces...(expected: at most %ld * %ld)\n\n", NB_SUBSPACES(VARQ, k_subspaces), NB_OBS_PER_GENERATOR(k_subspaces + 1));
 
-            quantum_assignment qa = subspaces(VARQ, k_subspaces);
+            quantum_assignment qa = (subspaces_sample_size > 0) ? isotropic_subspaces_sample(VARQ, k_subspaces, subspaces_sample_size)
+                                                                : subspaces(VARQ, k_subspaces);
             print("\n\nGeometries generated((%ld obs. per cont.,%d qubits))\n\nnow checking contextuality...\n\n", NB_OBS_PER_GENERATOR(k_subspaces + 1), VARQ);
             
             geometry_contextuality_degree_and_print(&qa, false, true, true, bool_sol);
@@ -480,13 +710,21 @@ int main(int argc, char **argv)
 
         if(!SET_SKEW_HEXAGONS){
             while (next_classical_cayley_hexagon(lines_qa, lines_indices, &qa, &complement_qa) && !is_done){
-
+                if (SET_FAMILY)
+                {
+                    family_add_copy(&family, family.cpt_configurations, complement ? (&complement_qa) : (&qa));
+                    continue;
+                }
                 geometry_contextuality_degree_and_print(complement ? (&complement_qa) : (&qa), false, true, false, my_bool_sol);
                 if(!SET_ALL_QUADRICS)break;
             }
         }else{
             while (next_skew_cayley_hexagon(lines_qa, lines_indices, &qa, &complement_qa) && !is_done){
-
+                if (SET_FAMILY)
+                {
+                    family_add_copy(&family, family.cpt_configurations, complement ? (&complement_qa) : (&qa));
+                    continue;
+                }
                 geometry_contextuality_degree_and_print(complement ? (&complement_qa) : (&qa), false, true, false, my_bool_sol);
                 if (!SET_ALL_QUADRICS)break;
             }
@@ -496,18 +734,109 @@ int main(int argc, char **argv)
         free_cayley_hexagons();
     }
 
+    if (SET_FAMILY)
+    {
+        if (SET_ORBITS)
+        {
+            size_t cpt_configurations = family.cpt_configurations;
+            size_t n_orbits = family_reduce_to_orbits(&family, lines_qa);
+            print("\n%ld configurations in %ld orbits under the symplectic group\n", cpt_configurations, n_orbits);
+        }
+        print("\nsolving %ld configurations on %d threads...\n", family.cpt_configurations, omp_get_max_threads());
+        family_result *results = family_contextuality_degrees(&family, global_solver_mode);
+        FILE *csv = (results == NULL) ? NULL : fopen(family_csv_path, "w");
+        if (csv != NULL)
+        {
+            family_results_to_csv(results, family.cpt_configurations, csv);
+            fclose(csv);
+            print("results written to %s\n", family_csv_path);
+        }
+        else if (results != NULL)
+        {
+            print("could not open %s\n", family_csv_path);
+        }
+        free(results);
+        family_free(&family);
+    }
+
+    if (batch_manifest_path != NULL)
+    {
+        FILE *manifest_file = fopen(batch_manifest_path, "r");
+        FILE *output = (manifest_file == NULL) ? NULL : (batch_output_path == NULL) ? stdout : fopen(batch_output_path, "a");
+        if (output != NULL)
+        {
+            /*the solver settings of the command line are the default ones of the jobs*/
+            solver_options defaults = solver_options_global();
+            batch_manifest manifest = batch_manifest_parse(manifest_file, &defaults);
+
+            /*CSV results for a .csv output, JSON Lines otherwise, appended to the previous ones*/
+            size_t length = (batch_output_path == NULL) ? 0 : strlen(batch_output_path);
+            batch_format format = (length >= 4 && strcmp(batch_output_path + length - 4, ".csv") == 0) ? BATCH_CSV : BATCH_JSON;
+            if (format == BATCH_CSV && fseek(output, 0, SEEK_END) == 0 && ftell(output) == 0)batch_csv_header(output);
+
+            print("solving %ld jobs on %d threads...\n", manifest.cpt_jobs, omp_get_max_threads());
+            size_t cpt = batch_run(&manifest, output, format);
+            print("%ld results written to %s\n", cpt, batch_output_path == NULL ? "the standard output" : batch_output_path);
+            batch_manifest_free(&manifest);
+            if (output != stdout)fclose(output);
+        }
+        else
+        {
+            print("could not open %s\n", manifest_file == NULL ? batch_manifest_path : batch_output_path);
+        }
+        if (manifest_file != NULL)fclose(manifest_file);
+    }
+
+    if (server_socket_path != NULL)
+    {
+        /*the solver settings of the command line are the default ones of the requests*/
+        solver_options defaults = solver_options_global();
+        long cpt = server_run(server_socket_path, &defaults);
+        if (cpt >= 0)print("server stopped after %ld requests\n", cpt);
+    }
+
     if (SET_IMPORT_ASSIGNMENT || SET_IMPORT_HYPERGRAM || SET_IMPORT_GRAM){
         print("imported configuration:\n");
         //print_quantum_assignment(&import_qa);
-        print("checking contextuality...\n");
-        
-        geometry_contextuality_degree_and_print(&import_qa, false, true, false, NULL);
+        if (analysis_input_path != NULL)
+        {
+            FILE *solutions = fopen(analysis_input_path, "r");
+            FILE *output = (solutions == NULL) ? NULL : fopen(analysis_output_path, "w");
+            if (output != NULL)
+            {
+                /*CSV records for a .csv output, JSON Lines otherwise*/
+                size_t length = strlen(analysis_output_path);
+                analysis_format format = (length >= 4 && strcmp(analysis_output_path + length - 4, ".csv") == 0) ? ANALYSIS_CSV : ANALYSIS_JSON;
+                size_t cpt = analysis_run(&import_qa, solutions, output, format);
+                print("%ld solutions analysed, records written to %s\n", cpt, analysis_output_path);
+                fclose(output);
+            }
+            else
+            {
+                print("could not open %s\n", solutions == NULL ? analysis_input_path : analysis_output_path);
+            }
+            if (solutions != NULL)fclose(solutions);
+        }
+        else
+        {
+            print("checking contextuality...\n");
+            bool *import_sol = calloc(quantum_assignment_n_points(&import_qa), sizeof(bool));
+            geometry_contextuality_degree_and_print(&import_qa, false, true, false, import_sol);
+            if (binary_output_path != NULL)
+            {
+                FILE *output = fopen(binary_output_path, "wb");
+                if (output != NULL && binary_assignment_save(&import_qa, import_sol, output))print("binary assignment written: %s\n", binary_output_path);
+                else print("could not write %s\n", binary_output_path);
+                if (output != NULL)fclose(output);
+            }
+            free(import_sol);
+        }
         free_quantum_assignment(&import_qa);
-        free_matrix(import_qa.geometries);
+        quantum_assignment_free_geometries(&import_qa);
     }
     free_quantum_assignment(&lines_qa);
     free_matrix(lines_indices);
-    free_matrix(lines_qa.geometries);
+    quantum_assignment_free_geometries(&lines_qa);
     free(my_bool_sol);
 
     return 0;
@@ -13,6 +13,8 @@
 
 #include "bv.h"
 #include "contextuality_degree.h"
+#include "isotropic.h"
+#include "gf2.h"
 
 
 
@@ -87,11 +89,58 @@ quantum_assignment generate_total_lines(size_t*** lines_indices,int n_qubits) {
         .n_qubits = n_qubits
     };
     for (size_t i = 0; i < (size_t)NB_LINES_CUSTOM(n_qubits); i++) qa.geometry_indices[i] = i+1;
+    /*every configuration made of lines inherits this negativity instead of recomputing it*/
+    quantum_assignment_compute_geometries_negativity(&qa,NB_LINES_CUSTOM(n_qubits) + 1);
     quantum_assignment_compute_negativity(&qa);
 
     return qa;
 }
 
+static size_t line_pair_index(bv a,bv b){
+    if(a > b){bv tmp = a;a = b;b = tmp;}
+    return (size_t)b*(b-1)/2 + a;
+}
+
+line_table line_table_create(quantum_assignment lines_qa){
+    line_table table = {.lines_qa = lines_qa,.pairs = NULL};
+    int n_qubits = lines_qa.n_qubits;
+    if(n_qubits > LINE_TABLE_DENSE_MAX_QUBITS)return table;
+
+    table.pairs = calloc(line_pair_index(BV_LIMIT_CUSTOM(n_qubits)-2,BV_LIMIT_CUSTOM(n_qubits)-1)+1,sizeof(uint32_t));
+    for (size_t l = 1; l <= (size_t)NB_LINES_CUSTOM(n_qubits); l++){
+        bv* line = lines_qa.geometries[l];
+        table.pairs[line_pair_index(line[0],line[1])] = l;
+        table.pairs[line_pair_index(line[0],line[2])] = l;
+        table.pairs[line_pair_index(line[1],line[2])] = l;
+    }
+    return table;
+}
+
+size_t line_table_find(const line_table* table,bv a,bv b){
+    if(a == b || a == I || b == I)return NO_LINE;
+    if(table->pairs != NULL)return table->pairs[line_pair_index(a,b)];
+
+    if(innerProduct_custom(a,b,table->lines_qa.n_qubits) != 0)return NO_LINE;
+    /*the line is identified by its two smallest points*/
+    bv c = a Qplus b;
+    bv first = MIN(a,MIN(b,c));
+    bv second = (first == a) ? MIN(b,c) : ((first == b) ? MIN(a,c) : MIN(a,b));
+    size_t low = 1,high = NB_LINES_CUSTOM(table->lines_qa.n_qubits);
+    while (low <= high){
+        size_t middle = low + (high - low)/2;
+        bv* line = table->lines_qa.geometries[middle];
+        if(line[0] == first && line[1] == second)return middle;
+        if(line[0] < first || (line[0] == first && line[1] < second))low = middle + 1;
+        else high = middle - 1;
+    }
+    return NO_LINE;
+}
+
+void line_table_free(line_table* table){
+    free(table->pairs);
+    table->pairs = NULL;
+}
+
 int bv_left_most(bv obs){
     if(obs == 0)return -1;
     for (size_t i = 0; i < 8*sizeof(bv); i++){
@@ -107,33 +156,21 @@ int bv_anti_cmp(const void * first, const void * second ) {
 
 int find_basis(bv *obss,int size,bv** basis){
 
-    bv copy[size];
-    for (int i = 0; i < size; i++)copy[i] = obss[i];
-    
-    qsort(copy,size,sizeof(bv),bv_anti_cmp);
+    /*the column c holds the bit 31-c, so that the echelon rows have distinct leftmost bits in descending order*/
+    const size_t width = 8*sizeof(bv);
+    bit_matrix m = gf2_matrix_create(size, width);
+    for (int i = 0; i < size; i++)
+        for (size_t c = 0; c < width; c++)if(BGET(obss[i],width-1-c))m.bits[i][0] |= 1ULL << c;
 
-    int current_basis_index = 0;
-    /*for each ith element of each vector*/
-    while (copy[current_basis_index] != 0)
-    {
-        bv b = copy[current_basis_index];
-        int index = bv_left_most(b);
-        
-        current_basis_index++;
-        for (int j = current_basis_index; j < size; j++)/*we then unset this bit on all other vectors below by adding it*/
-        {
-            if(BGET(copy[j],index))copy[j] = copy[j] Qplus b;
-        }
-        int remaining_size = size-current_basis_index-2;
-        if(remaining_size>0)qsort(&(copy[current_basis_index]),remaining_size,sizeof(bv),bv_anti_cmp);
-    }
+    int rank = gf2_echelon(m, false, NULL);
 
     if(basis != NULL){//we copy each non-null vector into the basis list
-        *basis = calloc(current_basis_index,sizeof(bv));
-        int cpt = 0;
-        for (int i = 0; i < size; i++)if(copy[i] != I)(*basis)[cpt++] = copy[i];
+        *basis = calloc(MAX(rank,1),sizeof(bv));
+        for (int i = 0; i < rank; i++)
+            for (size_t c = 0; c < width; c++)if((m.bits[i][0] >> c) & 1)(*basis)[i] |= (bv)1 << (width-1-c);
     }
-    return current_basis_index;
+    bit_matrix_free(m);
+    return rank;
 }
 
 uint64_t get_basis_combination(bv obs,bv *basis,int size){
@@ -151,10 +188,8 @@ uint64_t get_basis_combination(bv obs,bv *basis,int size){
 }
 
 
-bv**    _subspaces_tab;
 size_t  _subspaces_current_index;
 size_t  _subspaces_limit;
-size_t _subspaces_n_negative = 0;
 
 bool generate_subspace(bv bv1[],int size){
     
@@ -172,14 +207,8 @@ bool generate_subspace(bv bv1[],int size){
         tab[i] = sum;
     }
 
-    bool is_neg = is_negative(&(tab[1]),NB_OBS_PER_GENERATOR(size),N_QUBITS);
-    
-    #pragma omp critical
-    {
-        
-        _subspaces_current_index++;
-        if(is_neg)_subspaces_n_negative ++;
-    }
+    #pragma omp atomic
+    _subspaces_current_index++;
 
     if(_subspaces_current_index % 2000000 == 1)print("%ld,",_subspaces_current_index);
     if(_subspaces_current_index > _subspaces_limit)print("error subspaces");
@@ -270,94 +299,9 @@ void subspace_neg_lines_count(int n_qubits,int k,bv bv1[]){
 
 
 
-void subspaces_rec(int n_qubits,int k,int l,bv bv1[]){
-    if(l == k+1){
-        bool is_neg = is_negative(&(bv1[1]),NB_OBS_PER_GENERATOR(k+1),n_qubits);
-        if(CHECK_SUBSPACES_LINES_EVEN)subspace_neg_lines_count(n_qubits,k,bv1);
-        #pragma omp critical
-        {
-            for (size_t i = 0; i < (size_t)NB_OBS_PER_GENERATOR(k+1); i++)_subspaces_tab[_subspaces_current_index][i] = bv1[i+1];
-            _subspaces_current_index++;
-            if(is_neg)_subspaces_n_negative++;
-            int last_right_most = -1;
-            for (int i = 0; i < k+1; i++){
-                //print_BV_custom(bv1[pow2(i)],n_qubits);
-                int right_most = 2*n_qubits;
-                while(!BGET(bv1[pow2(i)],right_most))right_most--;
-                //print("%d",right_most);
-                if(right_most <= last_right_most)print("CONJECTURE WRONG");
-                last_right_most = right_most;
-            }
-            
-            
-            
-            
-
-            
-            
-            
-            
-        
-        }
-        if(_subspaces_current_index % 200000 == 1 && PRINT_PROGRESSION)print("%ld,",_subspaces_current_index);
-        return;
-    }
-    for (bv i = bv1[pow2(l)-1]+1; i < BV_LIMIT_CUSTOM(n_qubits); i++){
-        bv1[pow2(l)] = i;
-
-        bool valid = true;
-        for (int j = pow2(l)+1; j < pow2(l+1); j++)
-        {
-            bv1[j] = bv1[j&mask(l)] Qplus i;
-            
-            /*no need to check commutativity for the previous ones, they form a line with them*/
-            if(bv1[j] < bv1[pow2(l)] || innerProduct_custom(i,bv1[j],n_qubits) != 0){
-                valid = false;
-                break;
-            }
-        }
-        if(!valid)continue;
-        
-        subspaces_rec(n_qubits,k,l+1,bv1);
-    }
-}
-
 quantum_assignment subspaces(int n_qubits, int k)
 {
-
-    int size = NB_OBS_PER_GENERATOR(k+1);
-
-    //print("s:%ld %d %ld\n",NB_SUBSPACES(n_qubits,k),size,NB_SUBSPACES(n_qubits,k)*size);
-    /*instanciate the global variables accessible in the callback function (+1 for the callback function)*/
-    /*                                   nb lines is an upper bound because we don't know the real number*/
-    _subspaces_tab = (bv**)init_matrix(NB_SUBSPACES(n_qubits,k)+1,size,sizeof(bv));
-    _subspaces_current_index = 0;
-    _subspaces_limit = NB_SUBSPACES(n_qubits,k);
-
-    quantum_assignment qa = (quantum_assignment){0};
-    qa.geometry_indices = calloc(NB_SUBSPACES(n_qubits,k), sizeof(size_t));
-    qa.geometries = _subspaces_tab;
-    qa.points_per_geometry = NB_OBS_PER_GENERATOR(k+1);
-    qa.cpt_geometries = _subspaces_limit;
-    qa.n_qubits = n_qubits;
-
-    /*Splitting the first for loop between every thread*/
-    int num_done = 0;
-    bool stop_iters = false;
-    #pragma omp parallel for schedule(dynamic,1)
-    for (size_t i = I+1; i < BV_LIMIT_CUSTOM(n_qubits); i++){
-        if(stop_iters)continue;
-        bv bv1[NB_OBS_PER_GENERATOR(k+1)];
-        bv1[0] = I;bv1[1] = i;
-        subspaces_rec(n_qubits,k,1,bv1);
-        #pragma omp critical
-        {num_done++;
-        if(PRINT_PROGRESSION)print(" %.2f%% ", 100*((float)num_done/(float)BV_LIMIT));
-        }
-    }
-    for (size_t i = 0; i < NB_SUBSPACES(n_qubits,k); i++) qa.geometry_indices[i] = i;
-
-    return qa;
+    return isotropic_subspaces_range(n_qubits, k, 0, isotropic_count(n_qubits, k + 1));
 }
 
 quantum_assignment affine_planes(quantum_assignment planes){
@@ -401,8 +345,10 @@ quantum_assignment affine_planes(quantum_assignment planes){
     return ap;
 }
 
-quantum_assignment zero_locus(bv obs, unsigned int (*form)(bv, bv, int),size_t** lines_indices,int n_qubits,bv** lines,size_t* lines_res,bool complement) {
+quantum_assignment zero_locus(bv obs, unsigned int (*form)(bv, bv, int),size_t** lines_indices,int n_qubits,quantum_assignment lines_qa,size_t* lines_res,bool complement) {
     
+    bv** lines = lines_qa.geometries;
+
     quantum_assignment qa = {
         .geometry_indices = lines_res,
         .geometries = lines,
@@ -451,16 +397,100 @@ quantum_assignment zero_locus(bv obs, unsigned int (*form)(bv, bv, int),size_t**
     /*we check that the number of observables and lines are the ones expected for quadrics and perpsets*/
     free(line_tab);
 
+    quantum_assignment_inherit_negativity(&qa,lines_qa);
+    quantum_assignment_compute_negativity(&qa);
+
     return qa;
 }
 
-quantum_assignment perpset(bv obs,size_t** lines_indices,int n_qubits,bv** lines,bool complement) {
+quantum_assignment perpset(bv obs,size_t** lines_indices,int n_qubits,quantum_assignment lines_qa,bool complement) {
     size_t *perp_res = calloc(complement?(NB_LINES_CUSTOM(n_qubits)-NB_LINES_PER_PERPSET(n_qubits)):NB_LINES_PER_PERPSET(n_qubits),sizeof(size_t));
-    return zero_locus(obs, &innerProduct_custom,lines_indices,n_qubits,lines,perp_res,complement);
+    return zero_locus(obs, &innerProduct_custom,lines_indices,n_qubits,lines_qa,perp_res,complement);
 }
-quantum_assignment quadric(bv obs,size_t** lines_indices,int n_qubits,bv** lines,bool complement) {
+quantum_assignment quadric(bv obs,size_t** lines_indices,int n_qubits,quantum_assignment lines_qa,bool complement) {
     size_t *quad_res = calloc(complement?(NB_LINES_CUSTOM(n_qubits)-NB_LINES_PER_ELLIPTIC(n_qubits)):NB_LINES_PER_QUADRIC(n_qubits),sizeof(size_t));
-    return zero_locus(obs, &quadraticForm_custom,lines_indices,n_qubits,lines,quad_res,complement);
+    return zero_locus(obs, &quadraticForm_custom,lines_indices,n_qubits,lines_qa,quad_res,complement);
+}
+
+int zero_locus_block(zero_locus_type type,bv first_base,bool complement,quantum_assignment lines_qa,size_t** lines_indices,bit_matrix block,bool* elliptic){
+
+    int n_qubits = lines_qa.n_qubits;
+    bv limit = BV_LIMIT_CUSTOM(n_qubits);
+    if(first_base >= limit)return 0;
+
+    int count = MIN(ZERO_LOCUS_BLOCK_SIZE,(int)(limit - first_base));
+    uint64_t valid = (count == 64) ? ~0ULL : ((1ULL << count) - 1);
+
+    for (size_t t = 0; t < block.size; t++)memset(block.bits[t],0,BIT_SET_ARR_SIZE(block.bit_sets[t])*sizeof(bit_set_type));
+
+    /*masks[p] has its t-th bit set iff the point coordinate p pairs with a set coordinate of the t-th base*/
+    uint64_t masks[2*n_qubits];
+    for (int p = 0; p < 2*n_qubits; p++){
+        int partner = (p < n_qubits) ? (p + n_qubits) : (p - n_qubits);
+        masks[p] = 0;
+        for (int t = 0; t < count; t++)if(BGET(first_base+t,partner))masks[p] |= 1ULL << t;
+    }
+    for (int t = 0; t < count; t++){
+        if(elliptic != NULL)elliptic[t] = bit_parity(baseQuadraticFormVector(first_base+t,n_qubits),n_qubits);
+    }
+
+    /*for each point, bit t is set iff the point is in the zero locus of the form of the t-th base*/
+    uint64_t* zero_words = calloc(limit,sizeof(uint64_t));
+    uint64_t inner_products = 0;
+    for (bv g = 0; g < limit; g++){
+        bv i = g ^ (g >> 1);/*Gray code: one coordinate changes at each step*/
+        if(g != 0)inner_products ^= masks[__builtin_ctz(g)];
+        uint64_t value = inner_products;
+        if(type == ZERO_LOCUS_QUADRIC && bit_parity(baseQuadraticFormVector(i,n_qubits),n_qubits))value = ~value;
+        zero_words[i] = ~value & valid;
+    }
+
+    if(type == ZERO_LOCUS_PERPSET && !complement){
+        /*the perpset of a base is made of the lines passing through it*/
+        for (int t = 0; t < count; t++){
+            bv base = first_base + t;
+            for (int j = 0; j < NB_LINES_PER_POINT_CUSTOM(n_qubits); j++){
+                size_t line = lines_indices[base][j];
+                if(line != NO_LINE)block.bits[t][line/64] |= 1ULL << (line%64);
+            }
+        }
+        free(zero_words);
+        return count;
+    }
+
+    for (size_t l = 1; l <= (size_t)NB_LINES_CUSTOM(n_qubits); l++){
+        bv* line = lines_qa.geometries[l];
+        uint64_t in_locus = zero_words[line[0]] & zero_words[line[1]] & zero_words[line[2]];
+        if(complement)in_locus = ~in_locus & valid;
+        while(in_locus){
+            int t = __builtin_ctzll(in_locus);
+            in_locus &= in_locus - 1;
+            block.bits[t][l/64] |= 1ULL << (l%64);
+        }
+    }
+
+    free(zero_words);
+    return count;
+}
+
+quantum_assignment lines_subset(quantum_assignment lines_qa,bit_vector line_set){
+    quantum_assignment qa = {
+        .geometry_indices = calloc(MAX(bit_set_cardinality(line_set),1),sizeof(size_t)),
+        .geometries = lines_qa.geometries,
+        .cpt_geometries = 0,
+        .points_per_geometry = lines_qa.points_per_geometry,
+        .n_qubits = lines_qa.n_qubits
+    };
+    for (size_t w = 0; w < BIT_SET_ARR_SIZE(line_set); w++){
+        bit_set_type word = line_set.bits[w];
+        while(word){
+            qa.geometry_indices[qa.cpt_geometries++] = w*64 + __builtin_ctzll(word);
+            word &= word - 1;
+        }
+    }
+    quantum_assignment_inherit_negativity(&qa,lines_qa);
+    quantum_assignment_compute_negativity(&qa);
+    return qa;
 }
 
 size_t current_two_spread = 0;
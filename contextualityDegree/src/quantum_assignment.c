@@ -10,10 +10,14 @@
  * @brief Data structure and functions to handle quantum assignments
  * 
  */
+#include "constants.h"
 #include "quantum_assignment.h"
 #include "complex_int.h"
+#include "hashset.h"
+#include "export.h"
 
-#define STR_BUFFER_SIZE 4096
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 bool quantum_assignment_autofill_indices(quantum_assignment* qa){
     bool has_no_indices = qa->geometry_indices == NULL;
@@ -24,12 +28,160 @@ bool quantum_assignment_autofill_indices(quantum_assignment* qa){
     return has_no_indices;
 }
 
+static bool quantum_assignment_is_compact(const quantum_assignment* qa){
+    return qa->observables != NULL || qa->wide_observables != NULL;
+}
+
+size_t quantum_assignment_n_points(const quantum_assignment* qa){
+    return quantum_assignment_is_compact(qa) ? qa->n_observables : BV_LIMIT_CUSTOM(qa->n_qubits);
+}
+
+bv quantum_assignment_observable(const quantum_assignment* qa,bv point){
+    return (qa->observables != NULL) ? qa->observables[point] : point;
+}
+
+size_t quantum_assignment_point_to_chars(const quantum_assignment* qa,bv point,char* buffer){
+    if(qa->wide_observables != NULL)return wide_bv_to_chars(qa->wide_observables + point*WIDE_BV_WORDS(qa->n_qubits),qa->n_qubits,buffer);
+    return bv_to_chars(quantum_assignment_observable(qa,point),qa->n_qubits,buffer);
+}
+
+void quantum_assignment_print_point(const quantum_assignment* qa,bv point,FILE* output){
+    char buffer[qa->n_qubits];
+    fwrite(buffer,1,quantum_assignment_point_to_chars(qa,point,buffer),output);
+}
+
+bool quantum_assignment_point_is_symmetric(const quantum_assignment* qa,bv point){
+    if(qa->wide_observables != NULL)return wide_bv_is_symmetric(qa->wide_observables + point*WIDE_BV_WORDS(qa->n_qubits),qa->n_qubits);
+    return is_symmetric(quantum_assignment_observable(qa,point),qa->n_qubits);
+}
+
+/*up to this number of qubits, the points are relabeled with a table indexed by observable (4^n labels)*/
+#define COMPACT_TABLE_MAX_QUBITS 12
+
+static int bv_cmp(const void* a,const void* b){
+    bv x = *(const bv*)a,y = *(const bv*)b;
+    return (x > y) - (x < y);
+}
+
+void quantum_assignment_compact(quantum_assignment* qa){
+    if(quantum_assignment_is_compact(qa))return;
+
+    quantum_assignment_autofill_indices(qa);
+    quantum_assignment_compute_negativity(qa);
+
+    /*the rows of the geometry array used by the assignment (each one is relabeled once)*/
+    size_t cpt_rows = 0;
+    for (size_t i = 0; i < qa->cpt_geometries; i++)cpt_rows = MAX(cpt_rows,qa->geometry_indices[i]+1);
+    bit_vector used_rows = bit_set_create(cpt_rows,NULL);
+    for (size_t i = 0; i < qa->cpt_geometries; i++)bit_set_set_bit(used_rows,qa->geometry_indices[i],true);
+
+    if(qa->n_qubits <= COMPACT_TABLE_MAX_QUBITS){
+        /*label table over all the observables: the points are numbered in increasing order of observable*/
+        bv limit = BV_LIMIT_CUSTOM(qa->n_qubits);
+        bv* labels = calloc(limit,sizeof(bv));
+        labels[I] = 1;
+        for (size_t row = 0; row < cpt_rows; row++){
+            if(!bit_set_get_bit(used_rows,row))continue;
+            for (size_t j = 0; j < qa->points_per_geometry; j++)labels[qa->geometries[row][j]] = 1;
+        }
+        size_t n_observables = 0;
+        for (bv o = 0; o < limit; o++)n_observables += labels[o];
+        qa->observables = malloc(n_observables*sizeof(bv));
+        qa->n_observables = 0;
+        for (bv o = 0; o < limit; o++)if(labels[o] != 0){
+            labels[o] = qa->n_observables;
+            qa->observables[qa->n_observables++] = o;
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (size_t row = 0; row < cpt_rows; row++){
+            if(!bit_set_get_bit(used_rows,row))continue;
+            for (size_t j = 0; j < qa->points_per_geometry; j++)qa->geometries[row][j] = labels[qa->geometries[row][j]];
+        }
+        free(labels);
+        bit_set_free(used_rows);
+        return;
+    }
+
+    bv* observables = malloc((qa->cpt_geometries*qa->points_per_geometry+1)*sizeof(bv));
+    size_t cpt = 0;
+    observables[cpt++] = I;
+    for (size_t row = 0; row < cpt_rows; row++){
+        if(!bit_set_get_bit(used_rows,row))continue;
+        for (size_t j = 0; j < qa->points_per_geometry; j++)observables[cpt++] = qa->geometries[row][j];
+    }
+
+    qsort(observables,cpt,sizeof(bv),bv_cmp);
+    size_t n_observables = 0;
+    for (size_t i = 0; i < cpt; i++){
+        if(n_observables == 0 || observables[i] != observables[n_observables-1])observables[n_observables++] = observables[i];
+    }
+    qa->observables = realloc(observables,n_observables*sizeof(bv));
+    qa->n_observables = n_observables;
+
+    #pragma omp parallel for schedule(static)
+    for (size_t row = 0; row < cpt_rows; row++){
+        if(!bit_set_get_bit(used_rows,row))continue;
+        for (size_t j = 0; j < qa->points_per_geometry; j++){
+            bv* found = bsearch(&qa->geometries[row][j],qa->observables,n_observables,sizeof(bv),bv_cmp);
+            qa->geometries[row][j] = (bv)(found - qa->observables);
+        }
+    }
+    bit_set_free(used_rows);
+}
+
+/*sign of the product of the observables from their x and z parts (same phase counting as wide_bv_product_sign):
+1 if it is -I, 0 if it is I, -1 if it is not the identity up to a sign*/
+static int symplectic_product_sign(const bv geometry[], int size, int n_qubits){
+    word acc_z = 0,acc_x = 0;
+    long phase = 0;
+    for (int j = size - 1; j >= 0; j--){
+        word z2 = get_Z(geometry[j],n_qubits),x2 = get_X(geometry[j],n_qubits);
+        word y1 = acc_x & acc_z,only_x1 = acc_x & ~acc_z,only_z1 = acc_z & ~acc_x;
+        word plus = (y1 & z2 & ~x2) | (only_x1 & z2 & x2) | (only_z1 & x2 & ~z2);
+        word minus = (y1 & x2 & ~z2) | (only_x1 & z2 & ~x2) | (only_z1 & x2 & z2);
+        phase += __builtin_popcountll(plus) - __builtin_popcountll(minus);
+        acc_x ^= x2;
+        acc_z ^= z2;
+    }
+    phase = ((phase % 4) + 4) % 4;
+    if (acc_x != 0 || acc_z != 0 || phase % 2 != 0)return -1;
+    return phase == 2;
+}
+
+int quantum_assignment_geometry_sign(const quantum_assignment* qa,size_t row){
+    if(qa->wide_observables != NULL)return wide_bv_product_sign(qa->wide_observables,qa->geometries[row],qa->points_per_geometry,qa->n_qubits);
+
+    /*the points are mapped back to observables if needed*/
+    bv geometry[qa->points_per_geometry];
+    int size = 0;
+    while ((size_t)size < qa->points_per_geometry && qa->geometries[row][size] != I){
+        geometry[size] = quantum_assignment_observable(qa,qa->geometries[row][size]);
+        size++;
+    }
+    return symplectic_product_sign(geometry,size,qa->n_qubits);
+}
+
+/*negativity of a row of the geometry array*/
+static bool geometry_is_negative(const quantum_assignment* qa,size_t row){
+    int sign = quantum_assignment_geometry_sign(qa,row);
+    if(sign < 0)print("geometry phase error\n");
+    return sign == 1;
+}
+
 bool is_negative_custom(bv geometry[], int size, int n_qubits, bool verbose, FILE *output)
 {
     for (int i = 0; i < size; i++)if(geometry[i] == I){
         size = i;
         break;
     }
+    /*the matrices are only multiplied to print the phase of each qubit*/
+    if (!verbose){
+        int sign = symplectic_product_sign(geometry, size, n_qubits);
+        if (sign < 0)print("geometry phase error\n");
+        return sign == 1;
+    }
+
     pauli_matrix mat = get_matrix(I);
 
     /*for each qubit*/
@@ -80,38 +232,24 @@ bool is_negative_custom(bv geometry[], int size, int n_qubits, bool verbose, FIL
 bool is_negative(bv geometry[], int size, int n_qubits) { return is_negative_custom(geometry, size, n_qubits, false, stderr); }
 
 void print_quantum_assignment(quantum_assignment* qa){
-    quantum_assignment_autofill_indices(qa);
-    
     print("geometries : \n");
-    for (size_t i = 0; i < qa->cpt_geometries; i++){
-        //print("[");
-        for (size_t j = 0; j < qa->points_per_geometry; j++){
-            if(qa->geometries[qa->geometry_indices[i]][j] == I)break;
-            print_BV_custom(qa->geometries[qa->geometry_indices[i]][j],qa->n_qubits);
-            //print("%d", qa->geometries[qa->geometry_indices[i]][j]);
-            //if (j != qa->points_per_geometry-1)print(",");
-        }
-        print("%c\n",is_negative_custom(qa->geometries[qa->geometry_indices[i]],qa->points_per_geometry,qa->n_qubits,false,NULL)?'-':'+');
-        //print("],\n");
-    }
+    export_readable(qa,stderr);
     print("\n");
-
 }
 
 void quantum_assignment_to_CSV(quantum_assignment qa, FILE *output)
 {
-    for (size_t i = 0; i < qa.cpt_geometries; i++)
-    {
-        for (size_t j = 0; j < qa.points_per_geometry; j++)
-        {
-            if(j != 0)fprintf(output,",");
-            bv bv1 = qa.geometries[qa.geometry_indices[i]][j];
-            if (bv1 == I)
-                break;
-            print_BV_to_file(bv1, qa.n_qubits, output);
-        }
-        fprintf(output, "\n");
-    }
+    export_csv(&qa, output);
+}
+
+void quantum_assignment_to_ortools(quantum_assignment qa, FILE *output)
+{
+    /*qa is a copy: the indices and negativity computed here are not kept by the caller*/
+    bool owns_indices = quantum_assignment_autofill_indices(&qa);
+    bool owns_negativity = quantum_assignment_compute_negativity(&qa);
+    export_cpsat(&qa, output);
+    if (owns_negativity)free(qa.lines_negativity);
+    if (owns_indices)free(qa.geometry_indices);
 }
 
 
@@ -121,23 +259,64 @@ void quantum_assignment_print_to_file(quantum_assignment* qa, FILE *output)
     
     for (size_t i = 0; i < qa->cpt_geometries; i++){
         for (size_t j = 0; j < qa->points_per_geometry; j++){
-            print_BV_to_file(qa->geometries[qa->geometry_indices[i]][j],qa->n_qubits,output);
+            quantum_assignment_print_point(qa,qa->geometries[qa->geometry_indices[i]][j],output);
             if(j != qa->points_per_geometry-1)fprintf(output,",");
         }
         fprintf(output,"\n");
     }
 }
 
-bool quantum_assignment_compute_negativity(quantum_assignment* qa){
+bool quantum_assignment_compute_geometries_negativity(quantum_assignment* qa,size_t cpt_rows){
 
-    if(qa->lines_negativity != NULL)return false;
+    if(qa->geometries_negativity.bits != NULL)return false;
+
+    bit_vector cache = bit_set_create(cpt_rows,NULL);
+    size_t word_size = sizeof(bit_set_type)*8;
+
+    /*each thread fills whole words so that no bit is written concurrently*/
+    #pragma omp parallel for schedule(dynamic,16)
+    for (size_t w = 0; w < BIT_SET_ARR_SIZE(cache); w++){
+        bit_set_type word = 0;
+        for (size_t i = w*word_size; i < MIN((w+1)*word_size,cpt_rows); i++){
+            if(geometry_is_negative(qa,i))word |= 1ULL << (i%word_size);
+        }
+        cache.bits[w] = word;
+    }
+    qa->geometries_negativity = cache;
+
+    return true;
+}
+
+void quantum_assignment_inherit_negativity(quantum_assignment* qa,quantum_assignment parent){
+    if(qa->geometries != parent.geometries){
+        print("the negativity cache can only be shared between assignments with the same geometries\n");
+        return;
+    }
+    qa->geometries_negativity = parent.geometries_negativity;
+}
+
+void quantum_assignment_refresh_negativity(quantum_assignment* qa){
 
     quantum_assignment_autofill_indices(qa);
 
-    qa->lines_negativity = calloc(qa->cpt_geometries,sizeof(bool));
+    if(qa->lines_negativity == NULL)qa->lines_negativity = calloc(qa->cpt_geometries,sizeof(bool));
+
+    if(qa->geometries_negativity.bits != NULL){/*index gather from the parent geometry*/
+        for (size_t i = 0; i < qa->cpt_geometries; i++){
+            qa->lines_negativity[i] = bit_set_get_bit(qa->geometries_negativity,qa->geometry_indices[i]);
+        }
+        return;
+    }
     for (size_t i = 0; i < qa->cpt_geometries; i++){
-        qa->lines_negativity[i] = is_negative_custom(qa->geometries[qa->geometry_indices[i]],qa->points_per_geometry,qa->n_qubits,false,NULL);
+        qa->lines_negativity[i] = geometry_is_negative(qa,qa->geometry_indices[i]);
     }
+}
+
+bool quantum_assignment_compute_negativity(quantum_assignment* qa){
+
+    if(qa->lines_negativity != NULL)return false;
+
+    quantum_assignment_refresh_negativity(qa);
 
     return true;
 }
@@ -158,7 +337,7 @@ quantum_assignment quantum_assignment_from_invalid_contexts(quantum_assignment q
     quantum_assignment res = qa;
     res.geometry_indices = calloc(qa.cpt_geometries,sizeof(size_t));
     res.cpt_geometries = 0;
-    res.lines_negativity = NULL;
+    res.lines_negativity = calloc(qa.cpt_geometries,sizeof(bool));
 
     for (size_t i = 0; i < qa.cpt_geometries; i++)
     {
@@ -166,73 +345,235 @@ quantum_assignment quantum_assignment_from_invalid_contexts(quantum_assignment q
         for (size_t j = 0; j < qa.points_per_geometry && qa.geometries[qa.geometry_indices[i]][j] != I; j++){
             classical_negativity ^= bool_sol[qa.geometries[qa.geometry_indices[i]][j]];
         }
-        
-        if((classical_negativity ^ !(validity)) == is_negative_custom(qa.geometries[qa.geometry_indices[i]],qa.points_per_geometry,qa.n_qubits,false,NULL)){
+
+        /*the sign is taken from the already computed negativity whenever possible*/
+        bool is_neg;
+        if(qa.lines_negativity != NULL)is_neg = qa.lines_negativity[i];
+        else if(qa.geometries_negativity.bits != NULL)is_neg = bit_set_get_bit(qa.geometries_negativity,qa.geometry_indices[i]);
+        else is_neg = geometry_is_negative(&qa,qa.geometry_indices[i]);
+
+        if((classical_negativity ^ !(validity)) == is_neg){
             res.geometry_indices[res.cpt_geometries] = qa.geometry_indices[i];
+            res.lines_negativity[res.cpt_geometries] = is_neg;
             res.cpt_geometries++;
         }
     }
 
-    quantum_assignment_compute_negativity(&res);
-
     return res;
 }
 
 
-// Function to determine the maximum number of columns
-void parse_matrix_dimensions(FILE *file, size_t *rows, size_t *cols)
-{
-    char line[STR_BUFFER_SIZE];
-    *rows = 0;
+/*the contents of an assignment file are split in chunks of at least this size, parsed in parallel*/
+#define PARSE_CHUNK_MIN_SIZE (1 << 20)
 
-    while (fgets(line, sizeof(line), file))
-    {
+/*code of each character in an observable: 1 + its gate, 0 for the other characters (the other
+capital letters being read as I, the remaining characters ending the observable)*/
+static const unsigned char parse_gate_codes[256] = {
+    ['I'] = 1 + I, ['X'] = 1 + X, ['Y'] = 1 + Y, ['Z'] = 1 + Z
+};
+
+/*code of a character of an observable, 0 at its end*/
+static inline unsigned int parse_gate_code(char c,bool* unknown_gates){
+    unsigned int code = parse_gate_codes[(unsigned char)c];
+    if (code == 0 && c >= 'A' && c <= 'Z'){
+        *unknown_gates = true;
+        code = 1 + I;
+    }
+    return code;
+}
+
+/**
+ * @brief rows of a chunk of an assignment file
+ *
+ * @param begin first character of the chunk (at the beginning of a line)
+ * @param end end of the chunk (after a newline or at the end of the file)
+ * @param rows number of contexts (lines of at least two observables)
+ * @param cols maximum number of observables of a line
+ * @param n_qubits length of the first observable of the chunk that gives the number of qubits (0 if none)
+ * @param first_row index of the first context of the chunk in the assignment
+ * @param unknown_gates true if a capital letter other than I, X, Y, Z was read
+ */
+typedef struct {
+    const char* begin;
+    const char* end;
+    size_t rows;
+    size_t cols;
+    size_t n_qubits;
+    size_t first_row;
+    bool unknown_gates;
+} parse_chunk;
+
+/*a line goes up to its newline included, its observables being the non-empty pieces between commas
+(so that the newline after a trailing comma is an observable I, as written for shorter contexts)*/
+static const char* parse_next_piece(const char* s,const char* line_end,const char** piece_end){
+    while (s < line_end && *s == ',')s++;
+    const char* e = s;
+    while (e < line_end && *e != ',')e++;
+    *piece_end = e;
+    return s;
+}
+
+static const char* parse_line_end(const char* s,const char* end){
+    const char* nl = memchr(s,'\n',end - s);
+    return nl == NULL ? end : nl + 1;
+}
+
+/*the number of qubits is given by the first observable without space of more than one character*/
+static size_t parse_piece_qubits(const char* s,const char* e){
+    if (e - s <= 1 || memchr(s,' ',e - s) != NULL)return 0;
+    size_t n = 0;
+    while (s + n < e && s[n] != '\r' && s[n] != '\n')n++;
+    return n;
+}
+
+/*first pass: counts the contexts and the observables of a chunk*/
+static void parse_chunk_dimensions(parse_chunk* chunk){
+    for (const char* line = chunk->begin; line < chunk->end;){
+        const char* line_end = parse_line_end(line,chunk->end);
         size_t count = 0;
-        char *token = strtok(line, ",");
-        while (token){
+        const char* piece_end;
+        for (const char* piece = parse_next_piece(line,line_end,&piece_end); piece < line_end; piece = parse_next_piece(piece_end,line_end,&piece_end)){
+            if (chunk->n_qubits == 0)chunk->n_qubits = parse_piece_qubits(piece,piece_end);
             count++;
-            token = strtok(NULL, ",");
         }
-        if (count > *cols)*cols = count;
-        if (count > 1)(*rows)++;
+        chunk->cols = MAX(chunk->cols,count);
+        if (count > 1)chunk->rows++;
+        line = line_end;
+    }
+}
+
+/*decodes the gates of an observable with the code table (stops at the first other character)*/
+static bv parse_observable(const char* s,const char* e,int n_qubits,bool* unknown_gates){
+    word x = 0,z = 0;
+    int i = 0;
+    for (; s < e && i < n_qubits; s++,i++){
+        unsigned int code = parse_gate_code(*s,unknown_gates);
+        if (code == 0)break;
+        x = (x << 1) | ((code - 1) & 1);
+        z = (z << 1) | ((code - 1) >> 1);
+    }
+    if (i == 0)return I;
+    return to_index_custom(z << (n_qubits - i),x << (n_qubits - i),n_qubits);
+}
+
+/*same as parse_observable for wide observables*/
+static void parse_wide_observable(const char* s,const char* e,int n_qubits,wide_word* res,bool* unknown_gates){
+    memset(res,0,WIDE_BV_WORDS(n_qubits)*sizeof(wide_word));
+    for (int i = 0; s < e && i < n_qubits; s++,i++){
+        unsigned int code = parse_gate_code(*s,unknown_gates);
+        if (code == 0)break;
+        wide_bv_set_gate(res,code - 1,i,n_qubits);
+    }
+}
+
+/*second pass: fills the contexts of a chunk (the wide observables being numbered in the set, in order)*/
+static void parse_chunk_fill(parse_chunk* chunk,quantum_assignment* qa,hash_set* wide_points,wide_word* wide_buffer){
+    size_t row = chunk->first_row;
+    for (const char* line = chunk->begin; line < chunk->end;){
+        const char* line_end = parse_line_end(line,chunk->end);
+        size_t col = 0;
+        bv context[qa->points_per_geometry];
+        const char* piece_end;
+        for (const char* piece = parse_next_piece(line,line_end,&piece_end); piece < line_end; piece = parse_next_piece(piece_end,line_end,&piece_end)){
+            if (wide_points != NULL){
+                parse_wide_observable(piece,piece_end,qa->n_qubits,wide_buffer,&chunk->unknown_gates);
+                context[col++] = hash_set_find_or_add(wide_points,wide_buffer,NULL);
+            }
+            else context[col++] = parse_observable(piece,piece_end,qa->n_qubits,&chunk->unknown_gates);
+        }
+        if (col > 1)memcpy(qa->geometries[row++],context,col*sizeof(bv));/*a single observable is not a context*/
+        line = line_end;
     }
 }
 
+/*contents of a file from its current position: mapped when possible, read otherwise (pipes, memory streams)*/
+static char* parse_file_contents(FILE* file,size_t* size,size_t* mapping_size){
+    struct stat st;
+    long position = ftell(file);
+    *mapping_size = 0;
+    if (fileno(file) != -1 && fstat(fileno(file),&st) == 0 && S_ISREG(st.st_mode) && position >= 0 && st.st_size > position){
+        void* mapping = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fileno(file),0);
+        if (mapping != MAP_FAILED){
+            posix_madvise(mapping,st.st_size,POSIX_MADV_SEQUENTIAL);
+            *mapping_size = st.st_size;
+            *size = st.st_size - position;
+            return (char*)mapping + position;
+        }
+    }
+    size_t capacity = 1 << 16;
+    char* contents = malloc(capacity);
+    *size = 0;
+    for (size_t n; (n = fread(contents + *size,1,capacity - *size,file)) > 0;){
+        *size += n;
+        if (*size == capacity)contents = realloc(contents,capacity *= 2);
+    }
+    return contents;
+}
+
 quantum_assignment quantum_assignment_parse(FILE *file){
 
     quantum_assignment qa = {0};
 
     print("Parsing file\n");
 
-    parse_matrix_dimensions(file,&qa.cpt_geometries,&qa.points_per_geometry);
+    size_t size,mapping_size;
+    char* contents = parse_file_contents(file,&size,&mapping_size);
+
+    /*chunks of similar sizes, whose boundaries are moved after the next newline*/
+    size_t cpt_chunks = MIN((size_t)omp_get_max_threads() * 4,size / PARSE_CHUNK_MIN_SIZE + 1);
+    parse_chunk* chunks = calloc(cpt_chunks,sizeof(parse_chunk));
+    const char* position = contents;
+    for (size_t c = 0; c < cpt_chunks; c++){
+        chunks[c].begin = position;
+        position = (c == cpt_chunks - 1) ? contents + size : parse_line_end(MAX(position,contents + (c + 1) * size / cpt_chunks),contents + size);
+        chunks[c].end = position;
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t c = 0; c < cpt_chunks; c++)parse_chunk_dimensions(&chunks[c]);
 
-    if ((int)qa.points_per_geometry == -1){
-        fclose(file);return qa;
+    for (size_t c = 0; c < cpt_chunks; c++){
+        chunks[c].first_row = qa.cpt_geometries;
+        qa.cpt_geometries += chunks[c].rows;
+        qa.points_per_geometry = MAX(qa.points_per_geometry,chunks[c].cols);
+        if (qa.n_qubits == 0)qa.n_qubits = chunks[c].n_qubits;
     }
     print("size : %ldx%ld\n",qa.cpt_geometries,qa.points_per_geometry);
 
-    rewind(file); // Reset the file pointer to the beginning
-
-    // Count the number of lines (rows)
     qa.geometries = (bv**)init_matrix(qa.cpt_geometries, qa.points_per_geometry , sizeof(bv));
 
-    char line[STR_BUFFER_SIZE];
-    // Read the file again and fill the matrix
-    size_t row = 0;
-    while (fgets(line, sizeof(line), file) && row < qa.cpt_geometries)
-    {
-        int col = 0;
-        char *token = strtok(line, ",");
-        while (token){
-            if (qa.n_qubits == 0 && strchr(token, ' ') == NULL && strlen(token) > 1)qa.n_qubits = strlen(token);
-            qa.geometries[row][col++] = str_to_bv_custom(token, qa.n_qubits);
-            token = strtok(NULL, ",");
+    bool unknown_gates = false;
+    if (qa.geometries != NULL && qa.n_qubits > BV_MAX_QUBITS){
+        /*beyond BV_MAX_QUBITS qubits, the points are numbered in order of appearance, I being 0*/
+        hash_set wide_points = hash_set_init_custom(WIDE_BV_WORDS(qa.n_qubits));
+        wide_word* wide_buffer = calloc(WIDE_BV_WORDS(qa.n_qubits),sizeof(wide_word));
+        hash_set_find_or_add(&wide_points,wide_buffer,NULL);
+        for (size_t c = 0; c < cpt_chunks; c++){
+            parse_chunk_fill(&chunks[c],&qa,&wide_points,wide_buffer);
+            unknown_gates |= chunks[c].unknown_gates;
         }
-        if(col > 1)row++;
+        /*the key pool of the set becomes the observable array*/
+        qa.wide_observables = wide_points.keys;
+        qa.n_observables = wide_points.cpt_keys;
+        free(wide_points.slots);
+        free(wide_buffer);
     }
+    else if (qa.geometries != NULL){
+        #pragma omp parallel for schedule(dynamic) reduction(|:unknown_gates)
+        for (size_t c = 0; c < cpt_chunks; c++){
+            parse_chunk_fill(&chunks[c],&qa,NULL,NULL);
+            unknown_gates |= chunks[c].unknown_gates;
+        }
+    }
+    if (unknown_gates)print("read error ! (unknown gates are read as I)\n");
+
+    free(chunks);
+    if (mapping_size != 0)munmap(contents - (mapping_size - size),mapping_size);
+    else free(contents);
 
     quantum_assignment_autofill_indices(&qa);
     quantum_assignment_compute_negativity(&qa);
+    quantum_assignment_compact(&qa);
 
     return qa;
 }
@@ -240,13 +581,19 @@ quantum_assignment quantum_assignment_parse(FILE *file){
 quantum_assignment quantum_assignment_merge(quantum_assignment qa1,quantum_assignment qa2){
     quantum_assignment res = {0};
 
+    if(qa1.wide_observables != NULL || qa2.wide_observables != NULL){
+        print("assignments of more than %d qubits cannot be merged\n",BV_MAX_QUBITS);
+        return res;
+    }
+
     res.points_per_geometry = MAX(qa1.points_per_geometry,qa2.points_per_geometry);
     res.cpt_geometries = qa1.cpt_geometries+qa2.cpt_geometries;
     res.geometries = (bv**)init_matrix(res.cpt_geometries,res.points_per_geometry,sizeof(bv));
     res.n_qubits = qa1.n_qubits;
 
-    for (size_t i = 0; i < qa1.cpt_geometries; i++)for (size_t j = 0; j < qa1.points_per_geometry; j++)res.geometries[i][j] = qa1.geometries[qa1.geometry_indices[i]][j];
-    for (size_t i = 0; i < qa2.cpt_geometries; i++)for (size_t j = 0; j < qa2.points_per_geometry; j++)res.geometries[qa1.cpt_geometries+i][j] = qa2.geometries[qa2.geometry_indices[i]][j];
+    /*the merged geometries hold the observables, even if the merged assignments are compact*/
+    for (size_t i = 0; i < qa1.cpt_geometries; i++)for (size_t j = 0; j < qa1.points_per_geometry; j++)res.geometries[i][j] = quantum_assignment_observable(&qa1,qa1.geometries[qa1.geometry_indices[i]][j]);
+    for (size_t i = 0; i < qa2.cpt_geometries; i++)for (size_t j = 0; j < qa2.points_per_geometry; j++)res.geometries[qa1.cpt_geometries+i][j] = quantum_assignment_observable(&qa2,qa2.geometries[qa2.geometry_indices[i]][j]);
     
     quantum_assignment_autofill_indices(&res);
 
@@ -261,4 +608,23 @@ void free_quantum_assignment(quantum_assignment* qa){
     free(qa->lines_negativity);
     qa->geometry_indices = NULL;
     qa->lines_negativity = NULL;
+}
+
+void quantum_assignment_free_geometries(quantum_assignment* qa){
+    if(qa->mapping != NULL){/*the rows, observables and negativity are in the mapped file, only the row pointers are allocated*/
+        free(qa->geometries);
+        munmap(qa->mapping,qa->mapping_size);
+    }else{
+        free_matrix(qa->geometries);
+        bit_set_free(qa->geometries_negativity);
+        free(qa->observables);
+        free(qa->wide_observables);
+    }
+    qa->geometries = NULL;
+    qa->geometries_negativity = (bit_vector){0};
+    qa->observables = NULL;
+    qa->n_observables = 0;
+    qa->wide_observables = NULL;
+    qa->mapping = NULL;
+    qa->mapping_size = 0;
 }
\ No newline at end of file
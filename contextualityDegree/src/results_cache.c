@@ -0,0 +1,268 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file results_cache.c
+ * @brief on-disk cache of the contextuality degrees of configurations (--cache)
+ */
+#include "constants.h"
+#include "results_cache.h"
+#include "hashset.h"
+#include "wide_bv.h"
+
+#include <errno.h>
+#include <omp.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/////////////////////////////////////////// canonical key
+
+/*a point and the words of its observable, sorted by observable*/
+typedef struct {
+    const wide_word *words;
+    size_t n_words;
+    bv point;
+} results_cache_point;
+
+static int results_cache_point_cmp(const void *a, const void *b){
+    const results_cache_point *p1 = a, *p2 = b;
+    for (size_t w = 0; w < p1->n_words; w++)
+        if (p1->words[w] != p2->words[w])return (p1->words[w] < p2->words[w]) ? -1 : 1;
+    return 0;
+}
+
+static int results_cache_hash_cmp(const void *a, const void *b){
+    uint64_t h1 = *(const uint64_t *)a, h2 = *(const uint64_t *)b;
+    return (h1 > h2) - (h1 < h2);
+}
+
+results_cache_key results_cache_key_compute(quantum_assignment *qa){
+    quantum_assignment_autofill_indices(qa);
+    quantum_assignment_compute_negativity(qa);
+    size_t n_points = quantum_assignment_n_points(qa);
+    size_t n_words = (qa->wide_observables != NULL) ? (size_t)WIDE_BV_WORDS(qa->n_qubits) : 1;
+
+    /*the points present in a context, ranked by observable*/
+    size_t *rank = malloc(n_points * sizeof(size_t));
+    for (size_t p = 0; p < n_points; p++)rank[p] = SIZE_MAX;
+    results_cache_key key = {0};
+    for (size_t i = 0; i < qa->cpt_geometries; i++){
+        const bv *line = qa->geometries[qa->geometry_indices[i]];
+        for (size_t j = 0; j < qa->points_per_geometry && line[j] != I; j++){
+            if (rank[line[j]] != SIZE_MAX)continue;
+            rank[line[j]] = key.cpt_points++;
+        }
+    }
+    wide_word *observables = malloc(MAX(key.cpt_points, 1) * sizeof(wide_word));
+    results_cache_point *points = malloc(MAX(key.cpt_points, 1) * sizeof(results_cache_point));
+    for (size_t p = 0; p < n_points; p++){
+        if (rank[p] == SIZE_MAX)continue;
+        results_cache_point *point = &points[rank[p]];
+        point->point = p;
+        point->n_words = n_words;
+        if (qa->wide_observables != NULL)point->words = qa->wide_observables + p * n_words;
+        else {
+            observables[rank[p]] = quantum_assignment_observable(qa, p);
+            point->words = &observables[rank[p]];
+        }
+    }
+    qsort(points, key.cpt_points, sizeof(results_cache_point), results_cache_point_cmp);
+
+    key.points = malloc(MAX(key.cpt_points, 1) * sizeof(bv));
+    wide_word *words = malloc(MAX(key.cpt_points * n_words + 1, 1) * sizeof(wide_word));
+    words[0] = qa->n_qubits;
+    for (size_t r = 0; r < key.cpt_points; r++){
+        key.points[r] = points[r].point;
+        rank[points[r].point] = r;
+        memcpy(words + 1 + r * n_words, points[r].words, n_words * sizeof(wide_word));
+    }
+    key.hash[1] = hash_words(words, key.cpt_points * n_words + 1);
+
+    /*each context is hashed from its sign and the sorted ranks of its points*/
+    uint64_t *context_hashes = malloc(MAX(qa->cpt_geometries, 1) * sizeof(uint64_t));
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < qa->cpt_geometries; i++){
+        const bv *line = qa->geometries[qa->geometry_indices[i]];
+        uint64_t context[qa->points_per_geometry + 1];
+        size_t m = 0;
+        context[m++] = qa->lines_negativity[i];
+        for (size_t j = 0; j < qa->points_per_geometry && line[j] != I; j++){
+            uint64_t r = rank[line[j]];
+            size_t k = m++;
+            for (; k > 1 && context[k - 1] > r; k--)context[k] = context[k - 1];
+            context[k] = r;
+        }
+        context_hashes[i] = hash_words(context, m);
+    }
+    qsort(context_hashes, qa->cpt_geometries, sizeof(uint64_t), results_cache_hash_cmp);
+    key.hash[0] = hash_words(context_hashes, qa->cpt_geometries);
+
+    free(context_hashes);
+    free(words);
+    free(points);
+    free(observables);
+    free(rank);
+    return key;
+}
+
+void results_cache_key_free(results_cache_key *key){
+    free(key->points);
+    *key = (results_cache_key){0};
+}
+
+/////////////////////////////////////////// entries
+
+static void results_cache_path(const char *directory, const results_cache_key *key, char *path, size_t size){
+    snprintf(path, size, "%s/%016lx%016lx", directory, (unsigned long)key->hash[0], (unsigned long)key->hash[1]);
+}
+
+bool results_cache_load(const char *directory, const results_cache_key *key, quantum_assignment *qa, results_cache_entry *entry, bool *bool_sol){
+    char path[strlen(directory) + 40];
+    results_cache_path(directory, key, path, sizeof(path));
+    FILE *f = fopen(path, "r");
+    if (f == NULL)return false;
+
+    *entry = (results_cache_entry){.lower_bound = -1, .upper_bound = -1};
+    long version = 0, qubits = -1, contexts = -1, points = -1;
+    char *line = NULL, *code = NULL;
+    size_t capacity = 0;
+    while (getline(&line, &capacity, f) != -1){
+        char *value = strchr(line, ' ');
+        if (value == NULL)continue;
+        *value++ = '\0';
+        value[strcspn(value, "\r\n")] = '\0';
+        if (strcmp(line, "version") == 0)version = atol(value);
+        else if (strcmp(line, "qubits") == 0)qubits = atol(value);
+        else if (strcmp(line, "contexts") == 0)contexts = atol(value);
+        else if (strcmp(line, "points") == 0)points = atol(value);
+        else if (strcmp(line, "lower") == 0)entry->lower_bound = atoi(value);
+        else if (strcmp(line, "upper") == 0)entry->upper_bound = atoi(value);
+        else if (strcmp(line, "iterations") == 0)entry->iterations = strtoul(value, NULL, 10);
+        else if (strcmp(line, "time") == 0)entry->time = atof(value);
+        else if (strcmp(line, "solver") == 0)
+            entry->solver = (strcmp(value, solver_mode_name(SAT_SOLVER)) == 0) ? SAT_SOLVER : INVALID_LINES_HEURISTIC_SOLVER;
+        else if (strcmp(line, "solution") == 0 && code == NULL)code = strdup(value);
+    }
+    fclose(f);
+    free(line);
+
+    /*an entry of another configuration (hash collision) or a damaged one is ignored*/
+    bool valid = version == RESULTS_CACHE_VERSION && qubits == qa->n_qubits && contexts == (long)qa->cpt_geometries &&
+            points == (long)key->cpt_points && entry->lower_bound >= 0 && entry->upper_bound >= entry->lower_bound &&
+            code != NULL && strlen(code) == (key->cpt_points + 3) / 4;
+    bool *canonical = calloc(MAX(key->cpt_points, 1), sizeof(bool));
+    if (valid)valid = parse_solution_code(code, canonical, key->cpt_points);
+    if (valid){
+        size_t n_points = quantum_assignment_n_points(qa);
+        bool *solution = calloc(n_points, sizeof(bool));
+        for (size_t r = 0; r < key->cpt_points; r++)solution[key->points[r]] = canonical[r];
+        valid = check_contextuality_solution(qa, solution, NULL) == entry->upper_bound;
+        if (valid && bool_sol != NULL)memcpy(bool_sol, solution, n_points * sizeof(bool));
+        free(solution);
+    }
+    free(canonical);
+    free(code);
+    return valid;
+}
+
+bool results_cache_store(const char *directory, const results_cache_key *key, quantum_assignment *qa, const results_cache_entry *entry, const bool *bool_sol){
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST){
+        print("cannot create the cache directory %s\n", directory);
+        return false;
+    }
+    char path[strlen(directory) + 40], temporary[strlen(directory) + 80];
+    results_cache_path(directory, key, path, sizeof(path));
+
+    /*the entry is renamed once written, readers never seeing a partial one*/
+    static unsigned long cpt_temporary = 0;
+    unsigned long id;
+    #pragma omp atomic capture
+    id = cpt_temporary++;
+    snprintf(temporary, sizeof(temporary), "%s.%ld.%lu.tmp", path, (long)getpid(), id);
+
+    FILE *f = fopen(temporary, "w");
+    if (f == NULL){
+        print("cannot write %s\n", temporary);
+        return false;
+    }
+    char *code = malloc((key->cpt_points + 3) / 4 + 1);
+    bool *canonical = malloc(MAX(key->cpt_points, 1) * sizeof(bool));
+    for (size_t r = 0; r < key->cpt_points; r++)canonical[r] = bool_sol[key->points[r]];
+    code[solution_code_to_chars(canonical, key->cpt_points, code)] = '\0';
+
+    fprintf(f, "version %d\nqubits %d\ncontexts %ld\npoints %ld\nlower %d\nupper %d\nsolver %s\niterations %ld\ntime %.3f\nsolution %s\n",
+            RESULTS_CACHE_VERSION, qa->n_qubits, qa->cpt_geometries, key->cpt_points, entry->lower_bound, entry->upper_bound,
+            solver_mode_name(entry->solver), entry->iterations, entry->time, code);
+    bool written = fclose(f) == 0;
+    free(code);
+    free(canonical);
+    if (written && rename(temporary, path) == 0)return true;
+    remove(temporary);
+    print("cannot write %s\n", path);
+    return false;
+}
+
+/////////////////////////////////////////// solving through the cache
+
+int results_cache_contextuality_degree(quantum_assignment *qa, bool print_solution, bool optimistic, const solver_options *options, bool *bool_sol){
+    results_cache_key key = results_cache_key_compute(qa);
+    size_t n_points = quantum_assignment_n_points(qa);
+    bool *solution = calloc(n_points, sizeof(bool)), *cached_solution = calloc(n_points, sizeof(bool));
+
+    results_cache_entry entry;
+    bool cached = results_cache_load(options->cache_directory, &key, qa, &entry, cached_solution);
+    if (cached && entry.lower_bound == entry.upper_bound){
+        if (print_solution)print("\ncached result: contextuality degree %d\n", entry.upper_bound);
+        if (bool_sol != NULL)memcpy(bool_sol, cached_solution, n_points * sizeof(bool));
+        if (options->proved != NULL)*options->proved = true;
+        free(solution);
+        free(cached_solution);
+        results_cache_key_free(&key);
+        return entry.upper_bound;
+    }
+    if (cached && print_solution)print("\ncached bounds: %d <= degree <= %d, the search starts from the cached solution\n", entry.lower_bound, entry.upper_bound);
+
+    bool proved = false;
+    solver_options uncached = *options;
+    uncached.cache_directory = NULL;
+    uncached.proved = &proved;
+    if (cached)uncached.initial_solution = cached_solution;
+    double start = omp_get_wtime();
+    int degree = geometry_contextuality_degree_options(qa, false, print_solution, optimistic, &uncached, solution);
+
+    if (degree >= 0){
+        if (!cached)entry = (results_cache_entry){0};
+        /*a degree 0, or one given by a SAT search ended on an unsatisfiable degree, is proved (an
+        interrupted search only gives an upper bound); otherwise the configuration is known to be
+        contextual when the linear algebra check was not skipped (see noncontextual_solution)*/
+        int lower_bound = 0;
+        if (proved && (degree == 0 || !optimistic))lower_bound = degree;
+        else if ((double)qa->cpt_geometries * key.cpt_points <= NONCONTEXTUAL_CHECK_MAX_BITS)lower_bound = 1;
+        entry.lower_bound = MAX(entry.lower_bound, lower_bound);
+
+        /*the best solution is kept*/
+        if (!cached || degree <= entry.upper_bound){
+            entry.upper_bound = degree;
+            entry.solver = options->mode;
+        }
+        else memcpy(solution, cached_solution, n_points * sizeof(bool));
+        entry.lower_bound = MIN(entry.lower_bound, entry.upper_bound);
+        if (options->mode == INVALID_LINES_HEURISTIC_SOLVER)entry.iterations += options->heuristic_iterations;
+        entry.time += omp_get_wtime() - start;
+        results_cache_store(options->cache_directory, &key, qa, &entry, solution);
+        degree = entry.upper_bound;
+    }
+    /*a failed solver (-1) leaves the entry unchanged*/
+    if (options->proved != NULL)*options->proved = degree >= 0 && entry.lower_bound == entry.upper_bound;
+
+    if (bool_sol != NULL)memcpy(bool_sol, solution, n_points * sizeof(bool));
+    free(solution);
+    free(cached_solution);
+    results_cache_key_free(&key);
+    return degree;
+}
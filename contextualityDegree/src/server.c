@@ -0,0 +1,325 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file server.c
+ * @brief long-running server answering requests on a Unix domain socket (--serve)
+ */
+#include "constants.h"
+#include "server.h"
+
+#include <errno.h>
+#include <omp.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*resident state shared by all the connections*/
+typedef struct {
+    batch_lines lines;
+    solver_options defaults;
+    volatile bool stop;
+    int threads;
+    size_t requests;
+} server_state;
+
+/*a client, its lines received and not read yet, and whether one of its requests is being solved*/
+typedef struct {
+    int fd;
+    FILE *output;
+    char *data;
+    size_t length;
+    size_t capacity;
+    size_t number;
+    bool busy;
+    bool ended;/*nothing more will be received, the requests already received being answered*/
+    bool closing;/*quit or shutdown received*/
+} server_connection;
+
+/*destination of the bounds streamed while a request is solved, the lock of the request keeping
+them decreasing when the threads of the heuristic method report them concurrently*/
+typedef struct {
+    const batch_job *job;
+    FILE *output;
+    omp_lock_t lock;
+    int reported;
+} server_bound;
+
+/*set by the SIGINT handler of the server only, the solvers being stopped through is_done*/
+static volatile sig_atomic_t server_interrupted = false;
+
+static void server_sigint(int signum){
+    (void)signum;
+    server_interrupted = true;
+    is_done = true;
+}
+
+static bool server_stopped(server_state *state){
+    if (server_interrupted)state->stop = true;
+    return state->stop;
+}
+
+static bool server_busy(server_connection *connection){
+    bool busy;
+    #pragma omp atomic read
+    busy = connection->busy;
+    return busy;
+}
+
+/*reads the bytes available on a connection, marks it as ended on end of connection or error*/
+static void server_receive(server_connection *connection){
+    if (connection->capacity - connection->length < 4096){
+        connection->capacity = MAX(2 * connection->capacity, 8192);
+        connection->data = realloc(connection->data, connection->capacity);
+    }
+    ssize_t received = recv(connection->fd, connection->data + connection->length, connection->capacity - connection->length, 0);
+    if (received < 0 && errno == EINTR)return;
+    if (received <= 0 || connection->length + received > SERVER_MAX_REQUEST)connection->ended = true;
+    else connection->length += received;
+}
+
+/*next complete line received on a connection ('\n' and '\r' removed), NULL if there is none*/
+static char *server_next_line(server_connection *connection){
+    char *end = memchr(connection->data, '\n', connection->length);
+    if (end == NULL)return NULL;
+    size_t length = end - connection->data;
+    char *line = malloc(length + 1);
+    memcpy(line, connection->data, length);
+    line[length] = '\0';
+    if (length > 0 && line[length - 1] == '\r')line[length - 1] = '\0';
+    connection->length -= length + 1;
+    memmove(connection->data, end + 1, connection->length);
+    return line;
+}
+
+static void server_on_bound(int invalid_contexts, double time, void *data){
+    server_bound *bound = data;
+    omp_set_lock(&bound->lock);
+    if (bound->reported < 0 || invalid_contexts < bound->reported){
+        bound->reported = invalid_contexts;
+        fprintf(bound->output, "{\"line\":%ld,\"status\":\"bound\",\"upper_bound\":%d,\"time\":%.3f}\n", bound->job->line, invalid_contexts, time);
+        fflush(bound->output);
+    }
+    omp_unset_lock(&bound->lock);
+}
+
+static void server_status(server_state *state, FILE *output){
+    size_t requests;
+    #pragma omp atomic read
+    requests = state->requests;
+    fprintf(output, "{\"status\":\"server\",\"threads\":%d,\"requests\":%ld,\"resident_qubits\":[", state->threads, requests);
+    bool first = true;
+    #pragma omp critical(batch_lines)
+    for (int n = 0; n <= BATCH_MAX_LINE_QUBITS; n++){
+        if (state->lines.lines_qa[n].geometries == NULL)continue;
+        fprintf(output, first ? "%d" : ",%d", n);
+        first = false;
+    }
+    fprintf(output, "]}\n");
+    fflush(output);
+}
+
+/*solves a request and writes its result line (with the best solution)*/
+static void server_request(server_state *state, char *line, size_t number, FILE *output){
+    batch_job job = {.line = number};
+    if (!batch_job_parse(line, &state->defaults, &job))return;
+
+    batch_result result = {.error = job.error, .degree = -1};
+    double start = omp_get_wtime();
+    quantum_assignment qa = {0};
+    if (result.error == NULL){
+        batch_lines_require(&job, &state->lines);
+        qa = batch_job_load(&job, &state->lines, &result);
+    }
+    char *code = NULL;
+    if (result.error == NULL){
+        server_bound bound = {.job = &job, .output = output, .reported = -1};
+        omp_init_lock(&bound.lock);
+        job.options.on_bound = &server_on_bound;
+        job.options.on_bound_data = &bound;
+        size_t n_points = quantum_assignment_n_points(&qa);
+        bool *bool_sol = calloc(n_points, sizeof(bool));
+        result.degree = geometry_contextuality_degree_options(&qa, false, false, false, &job.options, bool_sol);
+        omp_destroy_lock(&bound.lock);
+        if (result.degree < 0)result.error = "solver failure";
+        code = malloc((n_points + 3) / 4 + 1);
+        code[solution_code_to_chars(bool_sol, n_points, code)] = '\0';
+        result.solution = code;
+        free(bool_sol);
+    }
+    result.time = omp_get_wtime() - start;
+    batch_job_unload(&job, &qa);
+
+    batch_result_to_json(&job, &result, output);
+    fflush(output);
+    #pragma omp atomic
+    state->requests++;
+    free(code);
+    batch_job_free(&job);
+}
+
+/*solves the request of a connection, which takes no other request until it is answered*/
+static void server_solve(server_state *state, server_connection *connection, char *line, size_t number){
+    server_request(state, line, number, connection->output);
+    free(line);
+    #pragma omp atomic write
+    connection->busy = false;
+}
+
+/*answers the commands received on an idle connection, up to its next request, given to the pool*/
+static void server_dispatch(server_state *state, server_connection *connection){
+    char *line;
+    while (!connection->closing && !server_busy(connection) && (line = server_next_line(connection)) != NULL){
+        size_t number = ++connection->number;
+        if (strcmp(line, "quit") == 0 || strcmp(line, "shutdown") == 0){
+            if (line[0] == 's')state->stop = true;
+            connection->closing = true;
+            free(line);
+        }
+        else if (strcmp(line, "status") == 0){
+            server_status(state, connection->output);
+            free(line);
+        }
+        else{
+            connection->busy = true;
+            /*without another thread (nested in an active region), the request is solved at once*/
+            if (omp_get_num_threads() > 1){
+                #pragma omp task firstprivate(connection, line, number)
+                server_solve(state, connection, line, number);
+            }
+            else server_solve(state, connection, line, number);
+        }
+    }
+}
+
+static server_connection *server_connection_open(int fd){
+    int output_fd = dup(fd);
+    FILE *output = (output_fd < 0) ? NULL : fdopen(output_fd, "w");
+    if (output == NULL){
+        if (output_fd >= 0)close(output_fd);
+        close(fd);
+        return NULL;
+    }
+    server_connection *connection = calloc(1, sizeof(server_connection));
+    connection->fd = fd;
+    connection->output = output;
+    return connection;
+}
+
+static void server_connection_close(server_connection *connection){
+    fclose(connection->output);
+    close(connection->fd);
+    free(connection->data);
+    free(connection);
+}
+
+long server_run(const char *socket_path, const solver_options *defaults){
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(address.sun_path)){
+        print("socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    /*a socket left by a previous server is replaced, any other file is kept*/
+    struct stat info;
+    if (stat(socket_path, &info) == 0){
+        if (!S_ISSOCK(info.st_mode)){
+            print("%s exists and is not a socket\n", socket_path);
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    /*SIGINT stops the server, whatever the solvers do with is_done; the handler is installed
+    before any client can connect and restored at the end*/
+    struct sigaction action, previous_action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = server_sigint;
+    server_interrupted = false;
+    sigaction(SIGINT, &action, &previous_action);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0){
+        print("cannot listen on %s: %s\n", socket_path, strerror(errno));
+        if (listener >= 0)close(listener);
+        sigaction(SIGINT, &previous_action, NULL);
+        return -1;
+    }
+    /*a client leaving before its answer must not stop the server*/
+    signal(SIGPIPE, SIG_IGN);
+
+    server_state state = {.defaults = *defaults};
+    server_connection **connections = NULL;
+    size_t cpt_connections = 0, capacity = 0;
+
+    /*the solvers' own parallel regions only get one thread inside the pool*/
+    int max_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+
+    /*one thread reads the connections and hands their requests to the others, so that idle
+    clients hold no thread*/
+    #pragma omp parallel num_threads(MAX(2, omp_get_max_threads() + 1))
+    #pragma omp single
+    {
+        state.threads = MAX(omp_get_num_threads() - 1, 1);
+        print("serving on %s with %d threads\n", socket_path, state.threads);
+        struct pollfd *waiting = NULL;
+        while (!server_stopped(&state)){
+            bool busy = false;
+            for (size_t c = 0; c < cpt_connections; c++){
+                server_dispatch(&state, connections[c]);
+                if (server_busy(connections[c]))busy = true;
+                else if (connections[c]->closing || connections[c]->ended){
+                    server_connection_close(connections[c]);
+                    connections[c--] = connections[--cpt_connections];
+                }
+            }
+            if (state.stop)break;
+
+            /*the connections of the requests being solved are read once they are answered*/
+            waiting = realloc(waiting, (cpt_connections + 1) * sizeof(struct pollfd));
+            server_connection **polled = malloc((cpt_connections + 1) * sizeof(server_connection *));
+            size_t cpt_waiting = 1;
+            waiting[0] = (struct pollfd){.fd = listener, .events = POLLIN};
+            for (size_t c = 0; c < cpt_connections; c++){
+                if (server_busy(connections[c]))continue;
+                polled[cpt_waiting] = connections[c];
+                waiting[cpt_waiting++] = (struct pollfd){.fd = connections[c]->fd, .events = POLLIN};
+            }
+            if (poll(waiting, cpt_waiting, busy ? SERVER_BUSY_POLL_PERIOD : SERVER_POLL_PERIOD) > 0){
+                for (size_t w = 1; w < cpt_waiting; w++)if (waiting[w].revents != 0)server_receive(polled[w]);
+                int client = (waiting[0].revents & POLLIN) ? accept(listener, NULL, NULL) : -1;
+                server_connection *connection = (client < 0) ? NULL : server_connection_open(client);
+                if (connection != NULL){
+                    if (cpt_connections == capacity){
+                        capacity = MAX(2 * capacity, 16);
+                        connections = realloc(connections, capacity * sizeof(server_connection *));
+                    }
+                    connections[cpt_connections++] = connection;
+                }
+            }
+            free(polled);
+        }
+        free(waiting);
+        #pragma omp taskwait
+    }
+
+    omp_set_max_active_levels(max_levels);
+    for (size_t c = 0; c < cpt_connections; c++)server_connection_close(connections[c]);
+    free(connections);
+    close(listener);
+    unlink(socket_path);
+    batch_lines_free(&state.lines);
+    sigaction(SIGINT, &previous_action, NULL);
+    if (server_interrupted)print("\ninterruption : server stopped\n");
+    return state.requests;
+}
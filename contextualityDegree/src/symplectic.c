@@ -0,0 +1,208 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file symplectic.c
+ * @brief action of the symplectic group Sp(2n,2) on configurations made of lines
+ */
+#include "symplectic.h"
+
+#include <string.h>
+
+void transvection_line_permutation(bv p,const line_table* lines,size_t* permutation){
+    int n_qubits = lines->lines_qa.n_qubits;
+    permutation[NO_LINE] = NO_LINE;
+    for (size_t l = 1; l <= (size_t)NB_LINES_CUSTOM(n_qubits); l++){
+        bv* line = lines->lines_qa.geometries[l];
+        permutation[l] = line_table_find(lines,transvection(p,line[0],n_qubits),transvection(p,line[1],n_qubits));
+    }
+}
+
+/*image of a line set given as raw words*/
+static void permute_words(const bit_set_type* line_set,size_t words,const size_t* permutation,bit_set_type* image){
+    memset(image,0,words*sizeof(bit_set_type));
+    for (size_t w = 0; w < words; w++){
+        bit_set_type word = line_set[w];
+        while(word){
+            size_t l = permutation[w*64 + __builtin_ctzll(word)];
+            word &= word - 1;
+            image[l/64] |= 1ULL << (l%64);
+        }
+    }
+}
+
+void line_set_permute(bit_vector line_set,const size_t* permutation,bit_vector image){
+    permute_words(line_set.bits,BIT_SET_ARR_SIZE(line_set),permutation,image.bits);
+}
+
+/*lexicographic order on the words of two line sets*/
+static int line_set_cmp(const bit_set_type* a,const bit_set_type* b,size_t words){
+    for (size_t w = words; w-- > 0;){
+        if(a[w] != b[w])return (a[w] < b[w]) ? -1 : 1;
+    }
+    return 0;
+}
+
+size_t symplectic_canonical_form(bit_vector line_set,quantum_assignment lines_qa,size_t max_orbit_size,bit_vector canonical){
+    size_t words = BIT_SET_ARR_SIZE(line_set);
+    size_t n_lines = NB_LINES_CUSTOM(lines_qa.n_qubits) + 1;
+    size_t n_generators = BV_LIMIT_CUSTOM(lines_qa.n_qubits) - 1;
+
+    size_t* permutations = malloc(n_generators*n_lines*sizeof(size_t));
+    line_table lines = line_table_create(lines_qa);
+    #pragma omp parallel for
+    for (size_t g = 0; g < n_generators; g++)
+        transvection_line_permutation(g + 1,&lines,permutations + g*n_lines);
+    line_table_free(&lines);
+
+    /*breadth-first walk of the orbit: the ids of the table are the queue*/
+    hash_set orbit = hash_set_init_custom(words);
+    hash_set_find_or_add(&orbit,line_set.bits,NULL);
+    bit_set_type current[words],image[words];
+
+    size_t orbit_size = 0;
+    for (size_t head = 0; head < orbit.cpt_keys; head++){
+        memcpy(current,hash_set_key(&orbit,head),words*sizeof(bit_set_type));
+        for (size_t g = 0; g < n_generators; g++){
+            permute_words(current,words,permutations + g*n_lines,image);
+            hash_set_find_or_add(&orbit,image,NULL);
+        }
+        if(orbit.cpt_keys > max_orbit_size)break;
+    }
+
+    if(orbit.cpt_keys <= max_orbit_size){
+        orbit_size = orbit.cpt_keys;
+        size_t min = 0;
+        for (size_t k = 1; k < orbit.cpt_keys; k++){
+            if(line_set_cmp(hash_set_key(&orbit,k),hash_set_key(&orbit,min),words) < 0)min = k;
+        }
+        memcpy(canonical.bits,hash_set_key(&orbit,min),words*sizeof(bit_set_type));
+    }
+
+    hash_set_free(&orbit);
+    free(permutations);
+    return orbit_size;
+}
+
+void symplectic_orbit_iterator_init(symplectic_orbit_iterator* it,bit_vector seed,quantum_assignment lines_qa){
+    it->n_lines = NB_LINES_CUSTOM(lines_qa.n_qubits) + 1;
+    it->n_generators = BV_LIMIT_CUSTOM(lines_qa.n_qubits) - 1;
+    it->permutations = malloc(it->n_generators*it->n_lines*sizeof(size_t));
+    line_table lines = line_table_create(lines_qa);
+    #pragma omp parallel for
+    for (size_t g = 0; g < it->n_generators; g++)
+        transvection_line_permutation(g + 1,&lines,it->permutations + g*it->n_lines);
+    line_table_free(&lines);
+
+    it->visited = hash_set_init_custom(BIT_SET_ARR_SIZE(seed));
+    hash_set_find_or_add(&it->visited,seed.bits,NULL);
+    it->expanded = 0;
+    it->returned = 0;
+    omp_init_lock(&it->lock);
+}
+
+bool symplectic_orbit_iterator_next(symplectic_orbit_iterator* it,bit_vector line_set,size_t* index){
+    size_t words = it->visited.key_words;
+    bit_set_type current[words],image[words];
+    bool found = false;
+
+    omp_set_lock(&it->lock);
+    /*the sets are expanded only when the already discovered ones have all been returned*/
+    while (it->returned == it->visited.cpt_keys && it->expanded < it->visited.cpt_keys){
+        memcpy(current,hash_set_key(&it->visited,it->expanded),words*sizeof(bit_set_type));
+        it->expanded++;
+        for (size_t g = 0; g < it->n_generators; g++){
+            permute_words(current,words,it->permutations + g*it->n_lines,image);
+            hash_set_find_or_add(&it->visited,image,NULL);
+        }
+    }
+    if(it->returned < it->visited.cpt_keys){
+        memcpy(line_set.bits,hash_set_key(&it->visited,it->returned),words*sizeof(bit_set_type));
+        if(index != NULL)*index = it->returned;
+        it->returned++;
+        found = true;
+    }
+    omp_unset_lock(&it->lock);
+
+    return found;
+}
+
+void symplectic_orbit_iterator_free(symplectic_orbit_iterator* it){
+    omp_destroy_lock(&it->lock);
+    hash_set_free(&it->visited);
+    free(it->permutations);
+    it->permutations = NULL;
+}
+
+static size_t union_find_root(size_t* parent,size_t k){
+    while (parent[k] != k){
+        parent[k] = parent[parent[k]];
+        k = parent[k];
+    }
+    return k;
+}
+
+size_t symplectic_orbits(bit_vector* line_sets,size_t cpt_line_sets,quantum_assignment lines_qa,size_t* orbit_of){
+    if(cpt_line_sets == 0)return 0;
+
+    size_t words = BIT_SET_ARR_SIZE(line_sets[0]);
+    size_t n_lines = NB_LINES_CUSTOM(lines_qa.n_qubits) + 1;
+
+    /*identical sets share the same id*/
+    hash_set table = hash_set_init_custom(words);
+    size_t* id_of = malloc(cpt_line_sets*sizeof(size_t));
+    for (size_t i = 0; i < cpt_line_sets; i++)id_of[i] = hash_set_find_or_add(&table,line_sets[i].bits,NULL);
+
+    size_t n_ids = table.cpt_keys;
+    size_t* parent = malloc(n_ids*sizeof(size_t));
+    size_t* image_id = malloc(n_ids*sizeof(size_t));
+    size_t* permutation = malloc(n_lines*sizeof(size_t));
+    for (size_t k = 0; k < n_ids; k++)parent[k] = k;
+    line_table lines = line_table_create(lines_qa);
+
+    for (bv p = 1; p < BV_LIMIT_CUSTOM(lines_qa.n_qubits); p++){
+        transvection_line_permutation(p,&lines,permutation);
+
+        /*the table is only read here*/
+        #pragma omp parallel
+        {
+            bit_set_type image[words];
+            #pragma omp for
+            for (size_t k = 0; k < n_ids; k++){
+                permute_words(hash_set_key(&table,k),words,permutation,image);
+                image_id[k] = hash_set_find(&table,image);
+            }
+        }
+        for (size_t k = 0; k < n_ids; k++){
+            if(image_id[k] == HASH_SET_NOT_FOUND)continue;
+            size_t a = union_find_root(parent,k),b = union_find_root(parent,image_id[k]);
+            if(a != b)parent[MAX(a,b)] = MIN(a,b);
+        }
+    }
+
+    /*each orbit is represented by its first set*/
+    size_t* first_of_root = malloc(n_ids*sizeof(size_t));
+    for (size_t k = 0; k < n_ids; k++)first_of_root[k] = HASH_SET_NOT_FOUND;
+    size_t n_orbits = 0;
+    for (size_t i = 0; i < cpt_line_sets; i++){
+        size_t root = union_find_root(parent,id_of[i]);
+        if(first_of_root[root] == HASH_SET_NOT_FOUND){
+            first_of_root[root] = i;
+            n_orbits++;
+        }
+        orbit_of[i] = first_of_root[root];
+    }
+
+    line_table_free(&lines);
+    free(first_of_root);
+    free(permutation);
+    free(image_id);
+    free(parent);
+    free(id_of);
+    hash_set_free(&table);
+    return n_orbits;
+}
@@ -0,0 +1,117 @@
+/**********************************************************************************/
+/* Copyright (C) 2024 Axel Muller and Alain Giorgetti                             */
+/* Université de Franche-Comté, CNRS, institut FEMTO-ST, F-25000 Besançon, France */
+/**********************************************************************************/
+/* This software is distributed under the terms of the GNU General Public License */
+/* version 2                                                                      */
+/**********************************************************************************/
+/**
+ * @file wide_bv.c
+ * @brief observables of any number of qubits, stored on several 64-bit words
+ */
+#include "wide_bv.h"
+
+#include <string.h>
+
+unsigned int wide_bv_inner_product(const wide_word* w1,const wide_word* w2,int n_qubits){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    wide_word acc = 0;
+    for (size_t k = 0; k < half; k++)acc ^= (w1[k] & w2[half + k]) ^ (w2[k] & w1[half + k]);
+    return __builtin_parityll(acc);
+}
+
+unsigned int wide_bv_quadratic_form(const wide_word* base,const wide_word* w,int n_qubits){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    wide_word acc = 0;
+    /* The Xor preserves the parity of the two vectors */
+    for (size_t k = 0; k < half; k++)acc ^= (w[k] & w[half + k]) ^ (base[k] & w[half + k]) ^ (w[k] & base[half + k]);
+    return __builtin_parityll(acc);
+}
+
+void wide_bv_transvection(const wide_word* p,const wide_word* q,wide_word* res,int n_qubits){
+    wide_word apply = -(wide_word)wide_bv_inner_product(p,q,n_qubits);
+    for (size_t k = 0; k < WIDE_BV_WORDS(n_qubits); k++)res[k] = q[k] ^ (p[k] & apply);
+}
+
+bool wide_bv_is_symmetric(const wide_word* w,int n_qubits){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    wide_word acc = 0;
+    for (size_t k = 0; k < half; k++)acc ^= w[k] & w[half + k];
+    return !__builtin_parityll(acc);
+}
+
+unsigned int wide_bv_get_gate(const wide_word* w,int index,int n_qubits){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    size_t shift = n_qubits - index - 1;/*the bit shift is the opposite of the index*/
+    unsigned int x = (w[half + shift/64] >> (shift%64)) & 1;
+    unsigned int z = (w[shift/64] >> (shift%64)) & 1;
+    return (z << 1) | x;
+}
+
+void wide_bv_set_gate(wide_word* w,unsigned int gate,int index,int n_qubits){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    size_t shift = n_qubits - index - 1;
+    wide_word bit = (wide_word)1 << (shift%64);
+    w[shift/64] = (gate >> 1) ? (w[shift/64] | bit) : (w[shift/64] & ~bit);
+    w[half + shift/64] = (gate & 1) ? (w[half + shift/64] | bit) : (w[half + shift/64] & ~bit);
+}
+
+void wide_bv_from_bv(bv bv1,int n_qubits,wide_word* res){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    memset(res,0,WIDE_BV_WORDS(n_qubits)*sizeof(wide_word));
+    res[0] = get_Z(bv1,n_qubits);
+    res[half] = get_X(bv1,n_qubits);
+}
+
+int wide_bv_parse(const char* str,int n_qubits,wide_word* res){
+    memset(res,0,WIDE_BV_WORDS(n_qubits)*sizeof(wide_word));
+    int i = 0;
+    for (char c = str[i]; c >= 'A' && c <= 'Z' && i < n_qubits; c = str[++i])wide_bv_set_gate(res,char_to_gate(c),i,n_qubits);
+    return i;
+}
+
+size_t wide_bv_to_chars(const wide_word* w,int n_qubits,char* buffer){
+    for (int i = 0; i < n_qubits; i++)buffer[i] = GATE_CHARS[wide_bv_get_gate(w,i,n_qubits)];
+    return n_qubits;
+}
+
+void wide_bv_print_to_file(const wide_word* w,int n_qubits,FILE* output){
+    char buffer[n_qubits];
+    fwrite(buffer,1,wide_bv_to_chars(w,n_qubits,buffer),output);
+}
+
+int wide_bv_product_sign(const wide_word* observables,const bv* points,size_t size,int n_qubits){
+    size_t half = WIDE_BV_HALF_WORDS(n_qubits);
+    size_t words = WIDE_BV_WORDS(n_qubits);
+    for (size_t j = 0; j < size; j++)if(points[j] == I){
+        size = j;
+        break;
+    }
+
+    wide_word acc_z[half],acc_x[half];
+    memset(acc_z,0,sizeof(acc_z));
+    memset(acc_x,0,sizeof(acc_x));
+
+    /*exponent of i: the product P_(size-1)...P_0 is computed from left to right (as is_negative_custom does),
+    each multiplication acc.P adding the phase g(acc,P) of every qubit*/
+    long phase = 0;
+    for (size_t j = size; j-- > 0;){
+        const wide_word* z2 = observables + points[j]*words;
+        const wide_word* x2 = z2 + half;
+        for (size_t k = 0; k < half; k++){
+            wide_word x1 = acc_x[k],z1 = acc_z[k];
+            wide_word y1 = x1 & z1,only_x1 = x1 & ~z1,only_z1 = z1 & ~x1;
+            wide_word plus = (y1 & z2[k] & ~x2[k]) | (only_x1 & z2[k] & x2[k]) | (only_z1 & x2[k] & ~z2[k]);
+            wide_word minus = (y1 & x2[k] & ~z2[k]) | (only_x1 & z2[k] & ~x2[k]) | (only_z1 & x2[k] & z2[k]);
+            phase += __builtin_popcountll(plus) - __builtin_popcountll(minus);
+            acc_x[k] ^= x2[k];
+            acc_z[k] ^= z2[k];
+        }
+    }
+
+    bool identity = true;
+    for (size_t k = 0; k < half; k++)identity &= (acc_x[k] == 0 && acc_z[k] == 0);
+    phase = ((phase % 4) + 4) % 4;
+    if (!identity || phase % 2 != 0)return -1;
+    return phase == 2;
+}
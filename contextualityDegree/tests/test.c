@@ -13,10 +13,30 @@
 #define TEST_C
 
 #include "constants.h"
+
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "quadrics.h"
 #include "hypergram.h"
+#include "binary_format.h"
 #include "cayley_hexagon.h"
 #include "complex_int.h"
+#include "family.h"
+#include "symplectic.h"
+#include "isotropic.h"
+#include "hashset.h"
+#include "wide_bv.h"
+#include "bit_kernels.h"
+#include "gf2.h"
+#include "analysis.h"
+#include "export.h"
+#include "batch.h"
+#include "results_cache.h"
+#include "server.h"
 
 size_t n_passed = 0; //number of passed tests
 size_t n_failed = 0; //number of failed tests
@@ -43,6 +63,41 @@ bool assert_equal(int a, int b, const char *message){
     return a == b;
 }
 
+/*splitmix64 hash of i, used as random words (fast_random is linear over GF(2), its outputs span only 32 dimensions)*/
+uint64_t random_word(uint64_t i){
+    uint64_t r = (i + 1) * 0x9E3779B97F4A7C15ULL;
+    r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    r = (r ^ (r >> 27)) * 0x94D049BB133111EBULL;
+    return r ^ (r >> 31);
+}
+
+/*client socket of a server, connected once the server listens (-1 after 5s)*/
+int server_client(const char *socket_path){
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    strcpy(address.sun_path, socket_path);
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct timespec retry = {.tv_nsec = 10000000};
+    for (int attempt = 0; client >= 0 && connect(client, (struct sockaddr *)&address, sizeof(address)) != 0; attempt++){
+        if (attempt == 500){
+            close(client);
+            return -1;
+        }
+        nanosleep(&retry, NULL);
+    }
+    return client;
+}
+
+/*appends the answers of a server to answers until they contain expected (until the end of the connection if NULL)*/
+bool server_read_until(int client, char *answers, size_t size, size_t *length, const char *expected){
+    ssize_t received = 1;
+    while ((expected == NULL || strstr(answers, expected) == NULL) && *length < size - 1 && received > 0){
+        received = read(client, answers + *length, size - 1 - *length);
+        if (received > 0)*length += received;
+        answers[*length] = '\0';
+    }
+    return expected == NULL || strstr(answers, expected) != NULL;
+}
+
 void print_summary(){
     printf("\n\nTests summary:\n");
     printf("Passed\u2705: %zu\n", n_passed);
@@ -73,6 +128,150 @@ int main(){
 
     /////////////////////////////
 
+    /*every kernel level supported by the processor, and the inline loops of the small arrays,
+    agree with the scalar kernels, tails included*/
+    bit_kernels_table best_kernels = bit_kernels;
+    bool kernels_agree = true;
+    for (size_t words = 0; words <= 37 && kernels_agree; words++){
+        uint64_t a[37], b[37], expected[37], res[37];
+        for (size_t i = 0; i < words; i++){
+            a[i] = (words * 37 + i + 1) * 0x9E3779B97F4A7C15ULL;
+            b[i] = (i % 3 == 0) ? 0 : a[i] * 0xBF58476D1CE4E5B9ULL;
+        }
+        bit_kernels_select(BIT_KERNELS_SCALAR);
+        size_t popcount = bit_kernels.popcount(a, words), xor_popcount = bit_kernels.xor_popcount(a, b, words);
+        bool any = bit_kernels.any(b, words);
+        bit_kernels.andnot_words(expected, a, b, words);
+        bit_kernel_andnot(res, a, b, words);
+        kernels_agree &= bit_kernel_popcount(a, words) == popcount && bit_kernel_xor_popcount(a, b, words) == xor_popcount &&
+                         bit_kernel_any(b, words) == any && memcmp(res, expected, words * sizeof(uint64_t)) == 0;
+        for (bit_kernels_level level = BIT_KERNELS_AVX2; level <= BIT_KERNELS_AVX512; level++){
+            if (!bit_kernels_select(level))continue;
+            bit_kernels.andnot_words(res, a, b, words);
+            kernels_agree &= bit_kernels.popcount(a, words) == popcount && bit_kernels.xor_popcount(a, b, words) == xor_popcount &&
+                             bit_kernels.any(b, words) == any && memcmp(res, expected, words * sizeof(uint64_t)) == 0;
+        }
+    }
+    bit_kernels = best_kernels;
+    assert_true(kernels_agree, "SIMD bit kernels agree with the scalar ones");
+
+    /////////////////////////////
+
+    quantum_assignment hyperbolic_qa = quadric(I, lines_indices, VARQ, lines_qa_three, false);
+    int direct_negative_count = 0;
+    for (size_t i = 0; i < hyperbolic_qa.cpt_geometries; i++)
+        direct_negative_count += is_negative(lines_qa_three.geometries[hyperbolic_qa.geometry_indices[i]], NB_POINTS_PER_LINE, VARQ);
+    assert_equal(negative_lines_count(&hyperbolic_qa), direct_negative_count,
+    "quadric inherits the negativity of its lines");
+
+    free_quantum_assignment(&hyperbolic_qa);
+
+    /////////////////////////////
+
+    bit_matrix quadric_block = bit_matrix_create(ZERO_LOCUS_BLOCK_SIZE, NB_LINES_CUSTOM(VARQ) + 1);
+    bool elliptic[ZERO_LOCUS_BLOCK_SIZE];
+    int block_count = zero_locus_block(ZERO_LOCUS_QUADRIC, I, false, lines_qa_three, lines_indices, quadric_block, elliptic);
+    bool same_quadrics = true;
+    int n_elliptics = 0;
+    for (int t = 0; t < block_count; t++){
+        quantum_assignment one = quadric(t, lines_indices, VARQ, lines_qa_three, false);
+        quantum_assignment batch = lines_subset(lines_qa_three, quadric_block.bit_sets[t]);
+        same_quadrics &= one.cpt_geometries == batch.cpt_geometries &&
+            memcmp(one.geometry_indices, batch.geometry_indices, one.cpt_geometries * sizeof(size_t)) == 0 &&
+            negative_lines_count(&one) == negative_lines_count(&batch);
+        n_elliptics += elliptic[t];
+        free_quantum_assignment(&one);
+        free_quantum_assignment(&batch);
+    }
+    assert_true(block_count == (int)BV_LIMIT_CUSTOM(VARQ) && same_quadrics,
+    "bit-sliced quadrics match quadric()");
+    assert_equal(n_elliptics, pow2(VARQ - 1) * (pow2(VARQ) - 1),
+    "bit-sliced generation finds all elliptic quadrics");
+
+    /////////////////////////////
+
+    configuration_family quadric_family = {0};
+    for (int t = 0; t < 4; t++)family_add(&quadric_family, t, lines_subset(lines_qa_three, quadric_block.bit_sets[t]));
+    family_result* family_results = family_contextuality_degrees(&quadric_family, INVALID_LINES_HEURISTIC_SOLVER);
+    bool family_rows_ok = family_results != NULL;
+    for (int t = 0; t < 4 && family_rows_ok; t++){
+        family_rows_ok = family_results[t].id == (size_t)t &&
+            family_results[t].contexts == quadric_family.configurations[t].cpt_geometries &&
+            family_results[t].degree >= 0 && family_results[t].degree <= family_results[t].negative_contexts;
+    }
+    assert_true(family_rows_ok,
+    "family driver fills one result row per configuration");
+    free(family_results);
+    family_free(&quadric_family);
+
+    /////////////////////////////
+
+    size_t quadric_orbit_of[ZERO_LOCUS_BLOCK_SIZE];
+    size_t n_quadric_orbits = symplectic_orbits(quadric_block.bit_sets, block_count, lines_qa_three, quadric_orbit_of);
+    assert_equal(n_quadric_orbits, 2,
+    "quadrics of 3 qubits form 2 symplectic orbits");
+
+    /////////////////////////////
+
+    int first_elliptic = -1, last_elliptic = -1;
+    for (int t = 0; t < block_count; t++){
+        if(!elliptic[t])continue;
+        if(first_elliptic == -1)first_elliptic = t;
+        last_elliptic = t;
+    }
+    bit_vector canonical_first = bit_set_create(NB_LINES_CUSTOM(VARQ) + 1, NULL);
+    bit_vector canonical_last = bit_set_create(NB_LINES_CUSTOM(VARQ) + 1, NULL);
+    size_t elliptic_orbit_size = symplectic_canonical_form(quadric_block.bit_sets[first_elliptic], lines_qa_three, 1000, canonical_first);
+    symplectic_canonical_form(quadric_block.bit_sets[last_elliptic], lines_qa_three, 1000, canonical_last);
+    assert_true(elliptic_orbit_size == 28 && memcmp(canonical_first.bits, canonical_last.bits, BIT_SET_ARR_SIZE(canonical_first) * sizeof(bit_set_type)) == 0,
+    "elliptic quadrics share their canonical form");
+    bit_set_free(canonical_first);
+    bit_set_free(canonical_last);
+
+    /////////////////////////////
+
+    line_table dense_lines = line_table_create(lines_qa_three);
+    line_table searched_lines = {.lines_qa = lines_qa_three, .pairs = NULL};
+    bool pairs_ok = line_table_find(&dense_lines, 1, 1) == NO_LINE;
+    for (size_t l = 1; l <= (size_t)NB_LINES_CUSTOM(VARQ); l++){
+        bv* line = lines_qa_three.geometries[l];
+        pairs_ok &= line_table_find(&dense_lines, line[2], line[0]) == l && line_table_find(&searched_lines, line[1], line[2]) == l;
+    }
+    assert_true(pairs_ok,
+    "pairs of points are mapped to their line");
+    line_table_free(&dense_lines);
+
+    /////////////////////////////
+
+    cayley_hexagon_iterator hexagon_it;
+    cayley_hexagon_iterator_init(&hexagon_it, lines_qa_three, false);
+    size_t n_hexagons = 0;
+    #pragma omp parallel num_threads(4) reduction(+:n_hexagons)
+    {
+        quantum_assignment hexagon, hexagon_complement;
+        cayley_hexagon_assignments_init(lines_qa_three, &hexagon, &hexagon_complement);
+        while (cayley_hexagon_iterator_next(&hexagon_it, &hexagon, &hexagon_complement, NULL))n_hexagons++;
+        free_quantum_assignment(&hexagon);
+        free_quantum_assignment(&hexagon_complement);
+    }
+    cayley_hexagon_iterator_free(&hexagon_it);
+    assert_equal(n_hexagons, 120,
+    "threads share the 120 classical hexagons");
+    bit_matrix_free(quadric_block);
+
+    /////////////////////////////
+
+    hash_set permutations = hash_set_init();
+    hash_set_bitset permut = hash_set_bitset_init();
+    hash_set_bitset_add(&permut, 42);
+    bool first_seen = hash_set_exists(&permutations, permut);
+    bool second_seen = hash_set_exists(&permutations, permut);
+    assert_true(!first_seen && second_seen && permutations.cpt_keys == 1,
+    "hash_set_exists inserts absent permutations");
+    hash_set_free(&permutations);
+
+    /////////////////////////////
+
     quantum_assignment doily = subspaces(2,1);
     int doily_deg = geometry_contextuality_degree_custom(&doily, false, false, false, SAT_SOLVER, NULL);
     assert_equal(doily_deg,3, 
@@ -102,7 +301,55 @@ int main(){
 
     /////////////////////////////
 
-    bool* bool_sol = calloc(BV_LIMIT_CUSTOM(import_qa.n_qubits), sizeof(bool));
+    bool compact_points = import_qa.observables != NULL && quantum_assignment_n_points(&import_qa) == 10;
+    for (size_t i = 0; i < import_qa.cpt_geometries && compact_points; i++)
+        for (size_t j = 0; j < import_qa.points_per_geometry; j++)
+            compact_points &= import_qa.geometries[import_qa.geometry_indices[i]][j] < 10 &&
+                              quantum_assignment_observable(&import_qa, import_qa.geometries[import_qa.geometry_indices[i]][j]) != I;
+    assert_true(compact_points && negative_lines_count(&import_qa) == 3,
+    "imported grid is relabeled to its 9 observables");
+
+    /////////////////////////////
+
+    /*without its last context, the grid has a classical assignment, found by linear algebra*/
+    char open_grid[] = "YZ,ZX,XY\nZY,XZ,YX\nXX,YY,ZZ\nYZ,ZY,XX\nZX,XZ,YY\n";
+    FILE* open_grid_file = fmemopen(open_grid, strlen(open_grid), "r");
+    quantum_assignment open_grid_qa = quantum_assignment_parse(open_grid_file);
+    fclose(open_grid_file);
+    bool* open_grid_sol = calloc(quantum_assignment_n_points(&open_grid_qa), sizeof(bool));
+    assert_true(!noncontextual_solution(&import_qa, NULL) && noncontextual_solution(&open_grid_qa, open_grid_sol) &&
+                check_contextuality_solution(&open_grid_qa, open_grid_sol, NULL) == 0 &&
+                geometry_contextuality_degree_custom(&open_grid_qa, false, false, false, SAT_SOLVER, NULL) == 0,
+    "degree 0 is detected without solver");
+    free(open_grid_sol);
+    free_quantum_assignment(&open_grid_qa);
+    quantum_assignment_free_geometries(&open_grid_qa);
+
+    /*the check of a non-compact assignment on 15 qubits only sizes its matrix by the 3 points of its context (XX, ZZ, YY)*/
+    quantum_assignment wide_line_qa = {.geometries = (bv **)init_matrix(1, 3, sizeof(bv)), .cpt_geometries = 1, .points_per_geometry = 3, .n_qubits = 15};
+    wide_line_qa.geometries[0][0] = 3;
+    wide_line_qa.geometries[0][1] = 3 << 15;
+    wide_line_qa.geometries[0][2] = (3 << 15) | 3;
+    assert_true(noncontextual_solution(&wide_line_qa, NULL) && negative_lines_count(&wide_line_qa) == 1,
+    "degree 0 of a context on 15 qubits is detected without a table of the 4^15 points");
+    free_quantum_assignment(&wide_line_qa);
+    quantum_assignment_free_geometries(&wide_line_qa);
+
+    /////////////////////////////
+
+    /*XX = XI.IX and YY = XX.ZZ: a basis of 3 observables, in descending order*/
+    bv basis_obs[] = {str_to_bv_custom("XI", 2), str_to_bv_custom("IX", 2), str_to_bv_custom("XX", 2), str_to_bv_custom("ZZ", 2), str_to_bv_custom("YY", 2), I};
+    bv* obs_basis = NULL;
+    int basis_size = find_basis(basis_obs, 6, &obs_basis);
+    bool descending = true;
+    for (int i = 1; i < basis_size; i++)descending &= bv_left_most(obs_basis[i]) < bv_left_most(obs_basis[i - 1]);
+    assert_true(basis_size == 3 && descending && get_basis_combination(str_to_bv_custom("YY", 2), obs_basis, basis_size) != 0,
+    "basis of 2-qubit observables by GF(2) elimination");
+    free(obs_basis);
+
+    /////////////////////////////
+
+    bool* bool_sol = calloc(quantum_assignment_n_points(&import_qa), sizeof(bool));
     int import_deg = geometry_contextuality_degree_custom(&import_qa, false, false, false, SAT_SOLVER, bool_sol);
     assert_equal(import_deg,1, 
     "imported grid has contextuality degree 1");
@@ -124,6 +371,275 @@ int main(){
 
     /////////////////////////////
 
+    line_categories categories = line_categories_init(3);
+    int type_a[3] = {1, 2, 3}, type_b[3] = {0, 2, 5}, type_big[3] = {1, 2, 30000000};
+    size_t id_a = line_categories_add(&categories, type_a);
+    size_t id_b = line_categories_add(&categories, type_b);
+    line_categories_add(&categories, type_a);
+    size_t id_big = line_categories_add(&categories, type_big);
+    assert_true(id_a == 0 && id_b == 1 && id_big == 2 && categories.types.cpt_keys == 3 &&
+                categories.counts[id_a] == 2 && categories.counts[id_b] == 1 && categories.counts[id_big] == 1,
+    "line types are counted by degree tuple, without bound on the degrees");
+    line_categories_free(&categories);
+
+    /////////////////////////////
+
+    size_t grid_points = quantum_assignment_n_points(&import_qa);
+    bool* grid_sol = calloc(grid_points, sizeof(bool));
+    invalid_stats live_stats = invalid_stats_init(&import_qa, grid_sol);
+    int start_lines = check_contextuality_solution(&import_qa, grid_sol, NULL);
+    bool regular_start = invalid_stats_is_regular(&live_stats, 1) && live_stats.vertices == 3 * start_lines &&
+                         !invalid_stats_is_regular(&live_stats, 2);
+    for (bv p = 1; p < grid_points; p += 2){
+        grid_sol[p] = true;
+        for (size_t i = 0; i < import_qa.cpt_geometries; i++)
+            for (size_t j = 0; j < import_qa.points_per_geometry; j++)
+                if (import_qa.geometries[import_qa.geometry_indices[i]][j] == p)invalid_stats_flip_line(&live_stats, &import_qa, i);
+    }
+    invalid_stats_refresh(&live_stats);
+    invalid_stats fresh_stats = invalid_stats_init(&import_qa, grid_sol);
+    int live_lines = 0;
+    for (size_t i = 0; i < import_qa.cpt_geometries; i++)live_lines += live_stats.invalid_lines[i];
+    bool same_stats = live_stats.vertices == fresh_stats.vertices &&
+                      memcmp(live_stats.degrees, fresh_stats.degrees, grid_points * sizeof(int)) == 0 &&
+                      memcmp(live_stats.degree_counts, fresh_stats.degree_counts, (live_stats.max_degree + 1) * sizeof(int)) == 0 &&
+                      memcmp(live_stats.invalid_lines, fresh_stats.invalid_lines, import_qa.cpt_geometries * sizeof(bool)) == 0;
+    assert_true(regular_start && same_stats && live_lines == check_contextuality_solution(&import_qa, grid_sol, NULL),
+    "invalid configuration statistics updated line by line match the recomputed ones");
+    invalid_stats_free(&live_stats);
+    invalid_stats_free(&fresh_stats);
+
+    /////////////////////////////
+
+    /*the code of a solution of 10 points holds 3 letters, the last one for the last 2 points*/
+    bool parsed_sol[10] = {0};
+    bool parsed = parse_solution_code("bpc", parsed_sol, 10);
+    assert_true(parsed && parsed_sol[0] && !parsed_sol[1] && parsed_sol[4] && parsed_sol[7] && !parsed_sol[8] && parsed_sol[9] &&
+                !parse_solution_code("bz", parsed_sol, 10),
+    "solution codes are parsed up to the last point");
+
+    /////////////////////////////
+
+    FILE *analysis_input = tmpfile(), *analysis_output = tmpfile();
+    fprintf(analysis_input, "aaa\n# comment\n\nzz\n");
+    rewind(analysis_input);
+    size_t analysed = analysis_run(&import_qa, analysis_input, analysis_output, ANALYSIS_CSV);
+    rewind(analysis_output);
+    char analysis_line[256] = {0}, analysis_first[256] = {0}, analysis_second[256] = {0};
+    bool read_lines = fgets(analysis_line, sizeof(analysis_line), analysis_output) && fgets(analysis_first, sizeof(analysis_first), analysis_output) &&
+                      fgets(analysis_second, sizeof(analysis_second), analysis_output);
+    memset(grid_sol, 0, grid_points * sizeof(bool));
+    analysis_record zero_record = analysis_record_compute(&import_qa, grid_sol);
+    bool point_lines_match = true;
+    for (int i = 0; i < zero_record.vertices; i++)
+        point_lines_match &= zero_record.point_lines[i] == zero_record.point_degrees[i] && zero_record.point_types[i] == 1;
+    assert_true(analysed == 2 && read_lines && strncmp(analysis_second, "4,0,", 4) == 0 && strncmp(analysis_first, "1,1,", 4) == 0 &&
+                zero_record.invalid_lines == check_contextuality_solution(&import_qa, grid_sol, NULL) &&
+                zero_record.degree_counts[1] == zero_record.vertices && zero_record.degree_lines[1] == zero_record.invalid_lines && point_lines_match,
+    "batch analysis writes one record per solution code");
+    analysis_record_free(&zero_record);
+    fclose(analysis_input);
+    fclose(analysis_output);
+    free(grid_sol);
+
+    /////////////////////////////
+
+    wide_word* wide_pool = calloc(BV_LIMIT_CUSTOM(VARQ) * WIDE_BV_WORDS(VARQ), sizeof(wide_word));
+    for (bv obs = I; obs < BV_LIMIT_CUSTOM(VARQ); obs++)wide_bv_from_bv(obs, VARQ, wide_pool + obs * WIDE_BV_WORDS(VARQ));
+    bool wide_ok = true;
+    for (size_t i = 0; i < lines_qa_three.cpt_geometries; i++)
+        wide_ok &= wide_bv_product_sign(wide_pool, lines_qa_three.geometries[i], NB_POINTS_PER_LINE, VARQ) ==
+                   (int)is_negative(lines_qa_three.geometries[i], NB_POINTS_PER_LINE, VARQ);
+    bv imaginary_points[3] = {1, (bv)1 << VARQ, ((bv)1 << VARQ) | 1};/*X.Z.Y on the same qubit*/
+    wide_ok &= wide_bv_product_sign(wide_pool, imaginary_points, 3, VARQ) == -1 && !is_done;
+    for (bv p = 1; p < BV_LIMIT_CUSTOM(VARQ); p += 5){
+        for (bv q = 1; q < BV_LIMIT_CUSTOM(VARQ); q += 3){
+            wide_word image[WIDE_BV_WORDS(VARQ)], expected[WIDE_BV_WORDS(VARQ)];
+            wide_bv_transvection(wide_pool + p * WIDE_BV_WORDS(VARQ), wide_pool + q * WIDE_BV_WORDS(VARQ), image, VARQ);
+            wide_bv_from_bv(transvection(p, q, VARQ), VARQ, expected);
+            wide_ok &= memcmp(image, expected, sizeof(image)) == 0 &&
+                       wide_bv_quadratic_form(wide_pool + p * WIDE_BV_WORDS(VARQ), wide_pool + q * WIDE_BV_WORDS(VARQ), VARQ) == quadraticForm_custom(p, q, VARQ);
+        }
+    }
+    free(wide_pool);
+    assert_true(wide_ok,
+    "wide observables agree with bv on 3 qubits");
+
+    /////////////////////////////
+
+    /*the grid on 20 qubits (the 3x3 grid tensored with 18 identities)*/
+    char wide_grid[] = "IIIIIIIIIIIIIIIIIIYZ,IIIIIIIIIIIIIIIIIIZX,IIIIIIIIIIIIIIIIIIXY\n"
+                       "IIIIIIIIIIIIIIIIIIZY,IIIIIIIIIIIIIIIIIIXZ,IIIIIIIIIIIIIIIIIIYX\n"
+                       "IIIIIIIIIIIIIIIIIIXX,IIIIIIIIIIIIIIIIIIYY,IIIIIIIIIIIIIIIIIIZZ\n"
+                       "IIIIIIIIIIIIIIIIIIYZ,IIIIIIIIIIIIIIIIIIZY,IIIIIIIIIIIIIIIIIIXX\n"
+                       "IIIIIIIIIIIIIIIIIIZX,IIIIIIIIIIIIIIIIIIXZ,IIIIIIIIIIIIIIIIIIYY\n"
+                       "IIIIIIIIIIIIIIIIIIXY,IIIIIIIIIIIIIIIIIIYX,IIIIIIIIIIIIIIIIIIZZ\n";
+    FILE* wide_file = fmemopen(wide_grid, strlen(wide_grid), "r");
+    quantum_assignment wide_qa = quantum_assignment_parse(wide_file);
+    fclose(wide_file);
+    int wide_deg = geometry_contextuality_degree_custom(&wide_qa, false, false, true, INVALID_LINES_HEURISTIC_SOLVER, NULL);
+    assert_true(wide_qa.n_qubits == 20 && quantum_assignment_n_points(&wide_qa) == 10 && negative_lines_count(&wide_qa) == 3 && wide_deg == 1,
+    "20-qubit grid is parsed with wide observables");
+    free_quantum_assignment(&wide_qa);
+    quantum_assignment_free_geometries(&wide_qa);
+
+    /////////////////////////////
+
+    /*a context of 1000 observables (longer than any line buffer), then a trailing comma read as I*/
+    FILE* long_file = tmpfile();
+    for (int i = 0; i < 1000; i++)fprintf(long_file, "%sXXXX", i == 0 ? "" : ",");
+    fprintf(long_file, "\nXIII,IXII,XXII,\n");
+    rewind(long_file);
+    quantum_assignment long_qa = quantum_assignment_parse(long_file);
+    fclose(long_file);
+    assert_true(long_qa.cpt_geometries == 2 && long_qa.points_per_geometry == 1000 && quantum_assignment_n_points(&long_qa) == 5 &&
+                long_qa.geometries[1][3] == I && negative_lines_count(&long_qa) == 0,
+    "a line of 1000 observables is parsed as one context");
+    free_quantum_assignment(&long_qa);
+    quantum_assignment_free_geometries(&long_qa);
+
+    /////////////////////////////
+
+    /*a file of several chunks, the boundaries of the 3 chunks falling inside lines (3 * 9 does not divide its size)*/
+    const char *grid_lines[] = {"YZ,ZX,XY\n", "ZY,XZ,YX\n", "XX,YY,ZZ\n", "YZ,ZY,XX\n", "ZX,XZ,YY\n", "XY,YX,ZZ\n"};
+    size_t grid_repeats = 40000;
+    FILE *chunked_file = tmpfile();
+    fputs(grid_lines[2], chunked_file);
+    for (size_t r = 0; r < grid_repeats; r++)for (int l = 0; l < 6; l++)fputs(grid_lines[l], chunked_file);
+    rewind(chunked_file);
+    quantum_assignment chunked_qa = quantum_assignment_parse(chunked_file);
+    fclose(chunked_file);
+    bool chunked_ok = chunked_qa.cpt_geometries == 6 * grid_repeats + 1 && chunked_qa.points_per_geometry == 3 &&
+                      quantum_assignment_n_points(&chunked_qa) == 10 && negative_lines_count(&chunked_qa) == 3 * (int)grid_repeats + 1;
+    for (size_t i = 0; i < chunked_qa.cpt_geometries && chunked_ok; i++){
+        const char *expected = grid_lines[i == 0 ? 2 : (i - 1) % 6];
+        for (int j = 0; j < 3; j++)
+            chunked_ok &= quantum_assignment_observable(&chunked_qa, chunked_qa.geometries[chunked_qa.geometry_indices[i]][j]) ==
+                          str_to_bv_custom((char *)expected + 3 * j, 2);
+    }
+    assert_true(chunked_ok,
+    "a file of several chunks cut inside lines is parsed as a whole");
+    free_quantum_assignment(&chunked_qa);
+    quantum_assignment_free_geometries(&chunked_qa);
+
+    /////////////////////////////
+
+    /*the sign of random contexts (of product +-I) given by the symplectic product and by the Pauli matrices*/
+    FILE *null_output = fopen("/dev/null", "w");
+    int sign_qubits[] = {1, 2, 3, 5, 8, 12};
+    size_t sign_checks = 0;
+    bool sign_ok = null_output != NULL;
+    for (int q = 0; q < 6 && sign_ok; q++){
+        int n = sign_qubits[q];
+        for (uint64_t t = 0; t < 300 && sign_ok; t++){
+            bv context[6] = {0};
+            int size = 3 + t % 4;
+            bool valid = true;
+            for (int j = 0; j < size - 1; j++){
+                context[j] = random_word(1000 * q + 7 * t + j) % BV_LIMIT_CUSTOM(n);
+                context[size - 1] ^= context[j];
+            }
+            /*the product of the observables is real iff an even number of pairs anticommute*/
+            unsigned int anticommuting = 0;
+            for (int j = 0; j < size; j++){
+                valid &= context[j] != I;
+                for (int k = j + 1; k < size; k++)anticommuting += innerProduct_custom(context[j], context[k], n);
+            }
+            if (!valid || anticommuting % 2 != 0)continue;
+            sign_ok = is_negative_custom(context, size, n, false, NULL) == is_negative_custom(context, size, n, true, null_output);
+            sign_checks++;
+        }
+    }
+    assert_true(sign_ok && sign_checks > 500 && !is_done,
+    "the symplectic sign of random contexts is the sign of the product of their matrices");
+    if (null_output != NULL)fclose(null_output);
+
+    /*X.Z.Y is iI: the phase error is reported without interrupting the program*/
+    bv imaginary_context[3] = {str_to_bv_custom("X", 1), str_to_bv_custom("Z", 1), str_to_bv_custom("Y", 1)};
+    assert_true(!is_negative_custom(imaginary_context, 3, 1, false, NULL) && !is_done,
+    "a context whose product is not real does not interrupt the program");
+
+    /////////////////////////////
+
+    /*anticommutations of 200 random 40-qubit observables*/
+    size_t n_random = 200;
+    wide_word* random_obs = calloc(n_random * WIDE_BV_WORDS(40), sizeof(wide_word));
+    for (size_t i = 0; i < n_random * WIDE_BV_WORDS(40); i++)random_obs[i] = random_word(i) & ((1ULL << 40) - 1);
+    bit_matrix random_gram = bit_matrix_create(n_random, n_random);
+    for (size_t i = 0; i < n_random; i++)
+        for (size_t j = 0; j < n_random; j++)
+            bit_matrix_set_bit(random_gram, i, j, wide_bv_inner_product(random_obs + i * WIDE_BV_WORDS(40), random_obs + j * WIDE_BV_WORDS(40), 40));
+    size_t gs_qubits;
+    wide_word* gs_assignment = symplectic_gram_schmidt(random_gram, &gs_qubits);
+    bool gs_ok = gs_qubits <= 40 && gs_qubits > BV_MAX_QUBITS;
+    for (size_t i = 0; i < n_random && gs_ok; i++)
+        for (size_t j = 0; j < n_random; j++)
+            gs_ok &= bit_matrix_get_bit(random_gram, i, j) ==
+                     (bool)wide_bv_inner_product(gs_assignment + i * WIDE_BV_WORDS(gs_qubits), gs_assignment + j * WIDE_BV_WORDS(gs_qubits), gs_qubits);
+    assert_true(gs_ok && pauli_assignment_from_anticommutations(random_gram, NULL) == -1,
+    "symplectic Gram-Schmidt rebuilds 40-qubit anticommutations");
+    assert_equal(gf2_rank(random_gram), 2 * gs_qubits, "the Gram-Schmidt qubits are half the rank of the Gram matrix");
+    free(gs_assignment);
+    free(random_obs);
+    bit_matrix_free(random_gram);
+
+    /////////////////////////////
+
+    /*GF(2) algebra on random matrices, against bit by bit computations*/
+    bit_matrix gf2_a = gf2_matrix_create(150, 130), gf2_b = gf2_matrix_create(130, 90);
+    for (size_t i = 0; i < 150; i++)for (size_t j = 0; j < 130; j++)bit_matrix_set_bit(gf2_a, i, j, random_word(i * 1000 + j) & 1);
+    for (size_t i = 0; i < 130; i++)for (size_t j = 0; j < 90; j++)bit_matrix_set_bit(gf2_b, i, j, random_word(500000 + i * 1000 + j) & 1);
+    bit_matrix gf2_t = gf2_transpose(gf2_a), gf2_ab = gf2_multiply(gf2_a, gf2_b);
+    bool gf2_ok = gf2_t.size == 130;
+    for (size_t i = 0; i < 150 && gf2_ok; i++){
+        for (size_t j = 0; j < 130; j++)gf2_ok &= bit_matrix_get_bit(gf2_t, j, i) == bit_matrix_get_bit(gf2_a, i, j);
+        for (size_t j = 0; j < 90; j++){
+            bool value = false;
+            for (size_t k = 0; k < 130; k++)value ^= bit_matrix_get_bit(gf2_a, i, k) & bit_matrix_get_bit(gf2_b, k, j);
+            gf2_ok &= bit_matrix_get_bit(gf2_ab, i, j) == value;
+        }
+    }
+    assert_true(gf2_ok, "GF(2) transpose and Four Russians product");
+
+    /*a matrix of rank at most 100, its rows 100.. repeating the first ones*/
+    bit_matrix gf2_low = gf2_matrix_create(150, 130);
+    for (size_t i = 0; i < 150; i++)memcpy(gf2_low.bits[i], gf2_a.bits[i % 100], BIT_SIZE(130) * sizeof(bit_set_type));
+    size_t low_rank = gf2_rank(gf2_low);
+    bit_matrix kernel = gf2_nullspace(gf2_low);
+    bit_matrix kernel_t = gf2_transpose(kernel);
+    bit_matrix zero = gf2_multiply(gf2_low, kernel_t);
+    bit_matrix low_t = gf2_transpose(gf2_low);
+    assert_true(low_rank == gf2_rank(low_t) && low_rank == 100 && kernel.size == 130 - low_rank && bit_matrix_is_empty(zero) && gf2_rank(kernel) == kernel.size,
+    "GF(2) rank and nullspace of a matrix with repeated rows");
+
+    /*b = m.x0 is solvable, flipping a bit of a repeated row makes it inconsistent*/
+    bit_set_type x0[BIT_SIZE(130)], b[BIT_SIZE(150)], x[BIT_SIZE(130)];
+    for (size_t w = 0; w < BIT_SIZE(130); w++)x0[w] = random_word(900000 + w) & (w == BIT_SIZE(130) - 1 ? (1ULL << (130 % 64)) - 1 : ~0ULL);
+    bit_set_type product[BIT_SIZE(130)];
+    memset(b, 0, sizeof(b));
+    for (size_t i = 0; i < 150; i++){
+        bit_kernel_and(product, gf2_low.bits[i], x0, BIT_SIZE(130));
+        if (bit_kernel_popcount(product, BIT_SIZE(130)) % 2)b[i / 64] |= 1ULL << (i % 64);
+    }
+    bool checked = gf2_solve(gf2_low, b, x);
+    for (size_t i = 0; i < 150 && checked; i++){
+        bit_kernel_and(product, gf2_low.bits[i], x, BIT_SIZE(130));
+        checked = ((b[i / 64] >> (i % 64)) & 1) == bit_kernel_popcount(product, BIT_SIZE(130)) % 2;
+    }
+    b[120 / 64] ^= 1ULL << (120 % 64);
+    assert_true(checked && !gf2_solve(gf2_low, b, x), "GF(2) affine solve");
+    bit_matrix_free(gf2_a);
+    bit_matrix_free(gf2_b);
+    bit_matrix_free(gf2_t);
+    bit_matrix_free(gf2_ab);
+    bit_matrix_free(gf2_low);
+    bit_matrix_free(kernel);
+    bit_matrix_free(kernel_t);
+    bit_matrix_free(zero);
+    bit_matrix_free(low_t);
+
+    /////////////////////////////
+
     quantum_assignment troily = subspaces(3,1);
     int troily_heuristic_deg = geometry_contextuality_degree_custom(&troily, false, false, true, INVALID_LINES_HEURISTIC_SOLVER, NULL);
     assert_equal(troily_heuristic_deg,63,
@@ -133,6 +649,31 @@ int main(){
 
     /////////////////////////////
 
+    bool ranks_ok = true;
+    for (uint64_t r = 0; r < isotropic_count(4, 3); r += 7){
+        bv plane_basis[3];
+        isotropic_unrank(4, 3, r, plane_basis);
+        ranks_ok &= isotropic_rank(4, 3, plane_basis) == r;
+    }
+    assert_true(ranks_ok && isotropic_count(4, 3) == NB_SUBSPACES(4, 2),
+    "isotropic planes of 4 qubits are ranked bijectively");
+
+    /////////////////////////////
+
+    quantum_assignment sampled_planes = isotropic_subspaces_sample(3, 2, 10);
+    bool sampled_ok = sampled_planes.cpt_geometries == 10;
+    for (size_t i = 0; i < sampled_planes.cpt_geometries; i++){
+        bv* plane = sampled_planes.geometries[i];
+        for (int a = 0; a < 7; a++)for (int b = 0; b < 7; b++)sampled_ok &= innerProduct_custom(plane[a], plane[b], 3) == 0;
+        sampled_ok &= (plane[0] ^ plane[1]) == plane[2];
+    }
+    assert_true(sampled_ok,
+    "sampled subspaces are totally isotropic");
+    free_quantum_assignment(&sampled_planes);
+    quantum_assignment_free_geometries(&sampled_planes);
+
+    /////////////////////////////
+
     FILE *mer_hypergraph = fopen("./misc/grid.hypergraph.txt", "r");
     FILE *mer_gram = fopen("./misc/grid.gram.txt", "r");
 
@@ -165,6 +706,286 @@ int main(){
 
     assert_equal(mermin_deg,1,"Mermin square has contextuality degree 1");
 
+    /////////////////////////////
+
+    /*the same hypergram through binary files*/
+    rewind(mer_hypergraph);
+    rewind(mer_gram);
+    FILE *bin_hypergraph = tmpfile(), *bin_gram = tmpfile();
+    bool converted = binary_convert(BINARY_HYPERGRAPH, mer_hypergraph, bin_hypergraph) && binary_convert(BINARY_GRAM, mer_gram, bin_gram);
+    fflush(bin_hypergraph);
+    fflush(bin_gram);
+    assert_true(converted && binary_file_is(bin_gram, BINARY_GRAM) && !binary_file_is(mer_gram, BINARY_GRAM),
+    "the binary gram file is detected");
+    hypergram binary_hg = hypergram_create_from_file(bin_hypergraph, bin_gram);
+    bool same_geometries = binary_hg.geometries != NULL && binary_hg.cpt_geometries == mermin_hg.cpt_geometries && binary_hg.cpt_points == mermin_hg.cpt_points;
+    for (size_t i = 0; i < mermin_hg.cpt_geometries && same_geometries; i++)
+        same_geometries = memcmp(binary_hg.geometries[i], mermin_hg.geometries[i], (mermin_hg.max_points_per_geometry + 1) * sizeof(size_t)) == 0;
+    assert_true(same_geometries && binary_hg.commutation_matrix.mapping != NULL && bit_matrix_equals(binary_hg.commutation_matrix, mermin_hg.commutation_matrix),
+    "binary hypergram files give the same (mapped) hypergram");
+    hypergram_free(binary_hg);
+    fclose(bin_hypergraph);
+    fclose(bin_gram);
+
+    /*a point beyond the number of points of the header, or a non-square gram matrix, are rejected*/
+    FILE *bad_hypergraph = tmpfile(), *bad_gram = tmpfile();
+    size_t bad_context[] = {1, 2, 7, 0}, *bad_contexts[] = {bad_context};
+    bit_matrix non_square = bit_matrix_create(2, 3);
+    bool bad_saved = binary_hypergraph_save(bad_contexts, 1, 3, 3, bad_hypergraph) && binary_gram_save(non_square, bad_gram);
+    rewind(bad_hypergraph);
+    rewind(bad_gram);
+    size_t bad_cpt_geometries, bad_points_per_geometry, bad_cpt_points;
+    bit_matrix bad_gram_bm = binary_gram_load(bad_gram);
+    assert_true(bad_saved && binary_hypergraph_load(bad_hypergraph, &bad_cpt_geometries, &bad_points_per_geometry, &bad_cpt_points) == NULL &&
+                bad_gram_bm.size == 0,
+    "corrupt binary hypergraph and gram files are rejected");
+    bit_matrix_free(non_square);
+    fclose(bad_hypergraph);
+    fclose(bad_gram);
+
+    /*headers whose sizes overflow (2^61 rows of 2^61 bits, 2^62 contexts of 4 points) do not pass the length check*/
+    FILE *huge_gram = tmpfile(), *huge_hypergraph = tmpfile();
+    binary_header huge_gram_header = {.version = BINARY_VERSION, .kind = BINARY_GRAM, .rows = 1ULL << 61, .cols = 1ULL << 61,
+                                      .row_words = BIT_SIZE(1ULL << 61)};
+    binary_header huge_hypergraph_header = {.version = BINARY_VERSION, .kind = BINARY_HYPERGRAPH, .rows = 1ULL << 62, .cols = 4,
+                                            .row_words = 4, .points = 3};
+    memcpy(huge_gram_header.magic, BINARY_MAGIC, sizeof(huge_gram_header.magic));
+    memcpy(huge_hypergraph_header.magic, BINARY_MAGIC, sizeof(huge_hypergraph_header.magic));
+    bool huge_saved = fwrite(&huge_gram_header, sizeof(binary_header), 1, huge_gram) == 1 &&
+                      fwrite(&huge_hypergraph_header, sizeof(binary_header), 1, huge_hypergraph) == 1;
+    fflush(huge_gram);
+    fflush(huge_hypergraph);
+    bit_matrix huge_gram_bm = binary_gram_load(huge_gram);
+    assert_true(huge_saved && huge_gram_bm.size == 0 &&
+                binary_hypergraph_load(huge_hypergraph, &bad_cpt_geometries, &bad_points_per_geometry, &bad_cpt_points) == NULL,
+    "binary headers with overflowing sizes are rejected");
+    fclose(huge_gram);
+    fclose(huge_hypergraph);
+
+    /////////////////////////////
+
+    /*the grid and its zero solution through a binary assignment file*/
+    FILE *text_grid = fopen("./misc/qa_grid.txt", "r"), *bin_grid = tmpfile();
+    quantum_assignment text_grid_qa = quantum_assignment_parse(text_grid);
+    bool *grid_zero_sol = calloc(quantum_assignment_n_points(&text_grid_qa), sizeof(bool));
+    bool grid_saved = binary_assignment_save(&text_grid_qa, grid_zero_sol, bin_grid);
+    fflush(bin_grid);
+    bool *stored_sol = NULL;
+    binary_assignment_stats stored_stats;
+    quantum_assignment bin_grid_qa = binary_assignment_load(bin_grid, &stored_sol, &stored_stats);
+    bool same_grid = grid_saved && bin_grid_qa.mapping != NULL && bin_grid_qa.cpt_geometries == 6 &&
+                     quantum_assignment_n_points(&bin_grid_qa) == quantum_assignment_n_points(&text_grid_qa) &&
+                     negative_lines_count(&bin_grid_qa) == negative_lines_count(&text_grid_qa) && stored_sol != NULL;
+    for (size_t i = 0; i < bin_grid_qa.cpt_geometries && same_grid; i++)
+        for (size_t j = 0; j < bin_grid_qa.points_per_geometry; j++)
+            same_grid &= quantum_assignment_observable(&bin_grid_qa, bin_grid_qa.geometries[i][j]) ==
+                         quantum_assignment_observable(&text_grid_qa, text_grid_qa.geometries[text_grid_qa.geometry_indices[i]][j]);
+    assert_true(same_grid && stored_stats.negative_lines == 3 && stored_stats.invalid_lines == (uint64_t)check_contextuality_solution(&text_grid_qa, grid_zero_sol, NULL),
+    "binary assignment files give the same (mapped) grid and its solution");
+    assert_equal(geometry_contextuality_degree_custom(&bin_grid_qa, false, false, true, INVALID_LINES_HEURISTIC_SOLVER, NULL), 1,
+    "the mapped grid has contextuality degree 1");
+
+    /*copies of the file with a qubit count out of bounds, an observable on 3 qubits and a wrong sign*/
+    fseek(bin_grid, 0, SEEK_END);
+    size_t bin_grid_size = ftell(bin_grid);
+    char *bin_grid_bytes = malloc(bin_grid_size);
+    rewind(bin_grid);
+    bool bin_grid_read = fread(bin_grid_bytes, 1, bin_grid_size, bin_grid) == bin_grid_size;
+    binary_header bin_grid_header;
+    memcpy(&bin_grid_header, bin_grid_bytes, sizeof(binary_header));
+    size_t bin_grid_observables = sizeof(binary_header) + sizeof(binary_assignment_info);
+    size_t bin_grid_negativity = bin_grid_observables + ((bin_grid_header.points + 1) / 2 + bin_grid_header.rows * bin_grid_header.row_words) * sizeof(uint64_t);
+    bool corrupted_rejected = bin_grid_read;
+    for (int corruption = 0; corruption < 3; corruption++){
+        char *bytes = malloc(bin_grid_size);
+        memcpy(bytes, bin_grid_bytes, bin_grid_size);
+        if (corruption == 0)((binary_assignment_info *)(bytes + sizeof(binary_header)))->n_qubits = 1 << 20;
+        else if (corruption == 1)((bv *)(bytes + bin_grid_observables))[1] = BV_LIMIT_CUSTOM(2);
+        else bytes[bin_grid_negativity] ^= 1;
+        FILE *corrupted = tmpfile();
+        fwrite(bytes, 1, bin_grid_size, corrupted);
+        fflush(corrupted);
+        quantum_assignment corrupted_qa = binary_assignment_load(corrupted, NULL, NULL);
+        corrupted_rejected &= corrupted_qa.geometries == NULL && corrupted_qa.mapping == NULL;
+        fclose(corrupted);
+        free(bytes);
+    }
+    assert_true(corrupted_rejected, "binary assignments with too many qubits, an observable on too many qubits or a wrong sign are rejected");
+    free(bin_grid_bytes);
+
+    free(stored_sol);
+    free(grid_zero_sol);
+    free_quantum_assignment(&bin_grid_qa);
+    quantum_assignment_free_geometries(&bin_grid_qa);
+    free_quantum_assignment(&text_grid_qa);
+    quantum_assignment_free_geometries(&text_grid_qa);
+    fclose(text_grid);
+    fclose(bin_grid);
+
+    /////////////////////////////
+
+    /*the exporters of the grid: CSV read back, readable form and XOR clauses*/
+    FILE *csv_grid = tmpfile(), *readable_grid = tmpfile(), *xcnf_grid = tmpfile();
+    export_csv(&import_qa, csv_grid);
+    export_readable(&import_qa, readable_grid);
+    export_xcnf(&import_qa, 0, xcnf_grid);
+    rewind(csv_grid);
+    rewind(readable_grid);
+    rewind(xcnf_grid);
+    quantum_assignment csv_grid_qa = quantum_assignment_parse(csv_grid);
+    char readable_line[64] = {0}, xcnf_header[64] = {0}, xcnf_line[64] = {0};
+    bool exported = fgets(readable_line, sizeof(readable_line), readable_grid) != NULL &&
+                    fgets(xcnf_header, sizeof(xcnf_header), xcnf_grid) != NULL && fgets(xcnf_header, sizeof(xcnf_header), xcnf_grid) != NULL &&
+                    fgets(xcnf_line, sizeof(xcnf_line), xcnf_grid) != NULL;
+    assert_true(exported && csv_grid_qa.cpt_geometries == 6 && negative_lines_count(&csv_grid_qa) == 3 &&
+                strcmp(readable_line, "[YZ][ZX][XY]-\n") == 0 && strcmp(xcnf_header, "p cnf 9 6\n") == 0 && xcnf_line[0] == 'x' && xcnf_line[1] != '-',
+    "the grid is exported in CSV, readable and XCNF forms");
+    free_quantum_assignment(&csv_grid_qa);
+    quantum_assignment_free_geometries(&csv_grid_qa);
+    fclose(csv_grid);
+    fclose(readable_grid);
+    fclose(xcnf_grid);
+
+    /////////////////////////////
+
+    /*the instances of the grid for external solvers: 9 points, 6 indicators and their auxiliary variables*/
+    FILE *wcnf_grid = tmpfile(), *opb_grid = tmpfile(), *bounded_grid = tmpfile();
+    export_wcnf(&import_qa, wcnf_grid);
+    export_opb(&import_qa, opb_grid);
+    export_xcnf(&import_qa, 1, bounded_grid);
+    rewind(wcnf_grid);
+    rewind(opb_grid);
+    rewind(bounded_grid);
+    char wcnf_header[128] = {0}, opb_header[128] = {0}, bounded_header[128] = {0};
+    bool solver_exported = fgets(wcnf_header, sizeof(wcnf_header), wcnf_grid) != NULL && fgets(wcnf_header, sizeof(wcnf_header), wcnf_grid) != NULL &&
+                           fgets(opb_header, sizeof(opb_header), opb_grid) != NULL &&
+                           fgets(bounded_header, sizeof(bounded_header), bounded_grid) != NULL && fgets(bounded_header, sizeof(bounded_header), bounded_grid) != NULL;
+    assert_true(solver_exported && strcmp(wcnf_header, "p wcnf 15 54 7\n") == 0 && strcmp(opb_header, "* #variable= 27 #constraint= 6\n") == 0 &&
+                strcmp(bounded_header, "p cnf 20 20\n") == 0,
+    "the grid is exported as WCNF, OPB and bounded XCNF instances");
+    fclose(wcnf_grid);
+    fclose(opb_grid);
+    fclose(bounded_grid);
+
+    /////////////////////////////
+
+    /*a manifest of jobs with their own solver settings, the invalid lines being reported*/
+    FILE *manifest_file = tmpfile(), *batch_output = tmpfile();
+    fprintf(manifest_file, "# name source arguments options\n"
+                           "grid assignment ./misc/qa_grid.txt solver=heuristic iterations=500\n\n"
+                           "doily subspaces 2 1 solver=heuristic\n"
+                           "hyperbolic quadric 2 XX solver=heuristic\n"
+                           "planes subspaces 3 4\n"
+                           "grid_bis assignment ./misc/qa_grid.txt flip=2\n");
+    rewind(manifest_file);
+    solver_options batch_defaults = solver_options_global();
+    batch_manifest manifest = batch_manifest_parse(manifest_file, &batch_defaults);
+    size_t batch_results = batch_run(&manifest, batch_output, BATCH_CSV);
+    rewind(batch_output);
+    int batch_degrees[8] = {-1, -1, -1, -1, -1, -1, -1, -1}, batch_errors = 0;
+    char batch_line[256];
+    while (fgets(batch_line, sizeof(batch_line), batch_output) != NULL){
+        size_t line = strtoul(batch_line, NULL, 10);
+        char *degree = batch_line;
+        for (int comma = 0; comma < 7 && degree != NULL; comma++)degree = strchr(degree + 1, ',');
+        if (strstr(batch_line, ",ok,") != NULL && degree != NULL && line < 8)batch_degrees[line] = atoi(degree + 1);
+        else batch_errors++;
+    }
+    assert_true(manifest.cpt_jobs == 5 && batch_results == 5 && batch_errors == 2 && manifest.jobs[0].options.heuristic_iterations == 500 &&
+                batch_degrees[2] == 1 && batch_degrees[4] == 3 && batch_degrees[5] == 1,
+    "a batch manifest gives one result line per job");
+    batch_manifest_free(&manifest);
+    fclose(manifest_file);
+    fclose(batch_output);
+
+    /*a job whose SAT solver cannot be run (no ./external in the working directory) is a failed job*/
+    char batch_directory[] = "/tmp/qontextium_batchXXXXXX", batch_cwd[PATH_MAX];
+    FILE *failing_manifest = tmpfile(), *failing_output = tmpfile();
+    bool moved = getcwd(batch_cwd, sizeof(batch_cwd)) != NULL && mkdtemp(batch_directory) != NULL && chdir(batch_directory) == 0;
+    fprintf(failing_manifest, "grid assignment %s/misc/qa_grid.txt solver=sat\n", batch_cwd);
+    rewind(failing_manifest);
+    batch_manifest failing = batch_manifest_parse(failing_manifest, &batch_defaults);
+    size_t failing_results = moved ? batch_run(&failing, failing_output, BATCH_JSON) : 0;
+    moved &= chdir(batch_cwd) == 0;
+    rmdir(batch_directory);
+    rewind(failing_output);
+    char failing_line[256] = {0};
+    assert_true(moved && failing_results == 1 && fgets(failing_line, sizeof(failing_line), failing_output) != NULL &&
+                strstr(failing_line, "\"status\":\"error\",\"error\":\"solver failure\"") != NULL,
+    "a batch job whose solver fails is reported as failed");
+    batch_manifest_free(&failing);
+    fclose(failing_manifest);
+    fclose(failing_output);
+
+    /*once SIGINT is received, every job is reported as interrupted, and the heuristic keeps the flag*/
+    FILE *interrupted_manifest = tmpfile(), *interrupted_output = tmpfile();
+    fprintf(interrupted_manifest, "grid assignment ./misc/qa_grid.txt solver=heuristic\ndoily subspaces 2 1 solver=heuristic\n");
+    rewind(interrupted_manifest);
+    batch_manifest interrupted = batch_manifest_parse(interrupted_manifest, &batch_defaults);
+    is_done = true;
+    size_t interrupted_results = batch_run(&interrupted, interrupted_output, BATCH_JSON);
+    geometry_contextuality_degree_custom(&import_qa, false, false, false, INVALID_LINES_HEURISTIC_SOLVER, NULL);
+    bool still_interrupted = is_done;
+    is_done = false;
+    rewind(interrupted_output);
+    int interrupted_lines = 0;
+    char interrupted_line[256];
+    while (fgets(interrupted_line, sizeof(interrupted_line), interrupted_output) != NULL)
+        interrupted_lines += strstr(interrupted_line, "\"error\":\"interrupted\"") != NULL;
+    assert_true(interrupted_results == 2 && interrupted_lines == 2 && still_interrupted,
+    "the jobs of an interrupted batch are reported as interrupted");
+    batch_manifest_free(&interrupted);
+    fclose(interrupted_manifest);
+    fclose(interrupted_output);
+
+    /////////////////////////////
+
+    /*the cache key of the grid does not depend on the order of its contexts nor of their points*/
+    char shuffled_grid[] = "XY,ZZ,YX\nXX,YY,ZZ\nZX,YZ,XY\nYZ,XX,ZY\nZX,XZ,YY\nYX,XZ,ZY\n";
+    FILE *shuffled_grid_file = fmemopen(shuffled_grid, strlen(shuffled_grid), "r");
+    quantum_assignment shuffled_grid_qa = quantum_assignment_parse(shuffled_grid_file);
+    fclose(shuffled_grid_file);
+    results_cache_key grid_key = results_cache_key_compute(&import_qa), shuffled_key = results_cache_key_compute(&shuffled_grid_qa);
+    assert_true(grid_key.hash[0] == shuffled_key.hash[0] && grid_key.hash[1] == shuffled_key.hash[1],
+    "a reordered grid has the same cache key");
+
+    /*the degree found once is answered from the cache, and the cached solution is valid for the shuffled grid*/
+    char cache_directory[] = "/tmp/qontextium_cacheXXXXXX";
+    solver_options cache_options = solver_options_global();
+    cache_options.mode = INVALID_LINES_HEURISTIC_SOLVER;
+    cache_options.cache_directory = mkdtemp(cache_directory);
+    results_cache_entry grid_entry = {0};
+    bool *shuffled_sol = calloc(quantum_assignment_n_points(&shuffled_grid_qa), sizeof(bool));
+    bool cache_empty = cache_options.cache_directory != NULL && !results_cache_load(cache_directory, &grid_key, &import_qa, &grid_entry, NULL);
+    int first_degree = geometry_contextuality_degree_options(&import_qa, false, false, false, &cache_options, NULL);
+    bool cache_filled = results_cache_load(cache_directory, &shuffled_key, &shuffled_grid_qa, &grid_entry, shuffled_sol);
+    assert_true(cache_empty && first_degree == 1 && cache_filled && grid_entry.lower_bound == 1 && grid_entry.upper_bound == 1 &&
+                check_contextuality_solution(&shuffled_grid_qa, shuffled_sol, NULL) == 1 &&
+                geometry_contextuality_degree_options(&shuffled_grid_qa, false, false, false, &cache_options, NULL) == 1,
+    "a contextuality degree is stored in and read from the results cache");
+    char cache_entry[PATH_MAX];
+    snprintf(cache_entry, sizeof(cache_entry), "%s/%016lx%016lx", cache_directory, (unsigned long)grid_key.hash[0], (unsigned long)grid_key.hash[1]);
+    remove(cache_entry);
+
+    /*a SAT solver which cannot be run (no ./external in the cache directory) gives no degree and no entry*/
+    char test_directory[PATH_MAX];
+    bool sat_failed = getcwd(test_directory, sizeof(test_directory)) != NULL && chdir(cache_directory) == 0;
+    bool sat_proved = true;
+    cache_options.mode = SAT_SOLVER;
+    cache_options.proved = &sat_proved;
+    sat_failed &= geometry_contextuality_degree_options(&import_qa, false, false, false, &cache_options, NULL) == -1;
+    sat_failed &= chdir(test_directory) == 0;
+    assert_true(sat_failed && !sat_proved && !results_cache_load(cache_directory, &grid_key, &import_qa, &grid_entry, NULL),
+    "a failed SAT solver is not stored in the results cache");
+    rmdir(cache_directory);
+    free(shuffled_sol);
+    results_cache_key_free(&grid_key);
+    results_cache_key_free(&shuffled_key);
+    free_quantum_assignment(&shuffled_grid_qa);
+    quantum_assignment_free_geometries(&shuffled_grid_qa);
+
+    /////////////////////////////
+
     fclose(mer_hypergraph);
     fclose(mer_gram);
     hypergram_free(mermin_hg);
@@ -205,6 +1026,78 @@ int main(){
 
     /////////////////////////////
 
+    /*a server solves the requests of two concurrent clients on its pool of threads, the lines of 2
+    qubits staying resident; the clients run in a child process, the server in this one outside of
+    any parallel region (after the other heuristic tests, its smaller team of threads making the
+    next parallel regions start new threads)*/
+    char server_directory[] = "/tmp/qontextium_serverXXXXXX", server_socket[64];
+    snprintf(server_socket, sizeof(server_socket), "%s/qontextium.sock", mkdtemp(server_directory));
+    solver_options server_defaults = solver_options_global();
+    server_defaults.mode = INVALID_LINES_HEURISTIC_SOLVER;
+    fflush(stdout);
+    pid_t clients = fork();
+    if (clients == 0){
+        char doily_answers[4096] = {0}, grid_answers[4096] = {0};
+        size_t doily_length = 0, grid_length = 0;
+        int doily_client = server_client(server_socket), grid_client = server_client(server_socket);
+        const char *doily_request = "doily lines 2 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 time=5\n";
+        const char *grid_request = "grid assignment ./misc/qa_grid.txt iterations=500\n";
+        /*both requests are sent before any answer is read, the status and the shutdown once both are answered*/
+        bool answered = doily_client >= 0 && grid_client >= 0 &&
+                        write(doily_client, doily_request, strlen(doily_request)) == (ssize_t)strlen(doily_request) &&
+                        write(grid_client, grid_request, strlen(grid_request)) == (ssize_t)strlen(grid_request) &&
+                        server_read_until(grid_client, grid_answers, sizeof(grid_answers), &grid_length, "\"degree\"") &&
+                        server_read_until(doily_client, doily_answers, sizeof(doily_answers), &doily_length, "\"degree\"") &&
+                        write(doily_client, "quit\n", 5) == 5 && write(grid_client, "status\nshutdown\n", 16) == 16 &&
+                        server_read_until(doily_client, doily_answers, sizeof(doily_answers), &doily_length, NULL) &&
+                        server_read_until(grid_client, grid_answers, sizeof(grid_answers), &grid_length, NULL);
+        answered = answered && strstr(grid_answers, "\"name\":\"grid\",\"source\":\"assignment\",\"status\":\"ok\"") != NULL &&
+                   strstr(grid_answers, "\"degree\":1,") != NULL && strstr(doily_answers, "\"degree\":3,") != NULL &&
+                   strstr(doily_answers, "\"status\":\"bound\"") != NULL && strstr(grid_answers, "\"resident_qubits\":[2]") != NULL;
+        /*the server is stopped whatever the failure, so that the tests go on*/
+        int stopper = answered ? -1 : server_client(server_socket);
+        if (stopper >= 0 && write(stopper, "shutdown\n", 9) == 9)close(stopper);
+        _exit(answered ? 0 : 1);
+    }
+    long served = (clients > 0) ? server_run(server_socket, &server_defaults) : -1;
+    int clients_status = -1;
+    if (clients > 0)waitpid(clients, &clients_status, 0);
+    rmdir(server_directory);
+    assert_true(served == 2 && WIFEXITED(clients_status) && WEXITSTATUS(clients_status) == 0,
+    "a server answers the requests of concurrent clients with bounds and results");
+
+    /*SIGINT received while a request is solved stops the server, which restores the previous handler*/
+    char interrupted_directory[] = "/tmp/qontextium_serverXXXXXX";
+    snprintf(server_socket, sizeof(server_socket), "%s/qontextium.sock", mkdtemp(interrupted_directory));
+    fflush(stdout);
+    pid_t interrupter = fork();
+    if (interrupter == 0){
+        char answers[4096] = {0};
+        size_t length = 0;
+        int client = server_client(server_socket);
+        const char *request = "doily lines 2 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 time=60\n";
+        bool solving = client >= 0 && write(client, request, strlen(request)) == (ssize_t)strlen(request) &&
+                       server_read_until(client, answers, sizeof(answers), &length, "\"status\":\"bound\"");
+        kill(getppid(), SIGINT);
+        _exit(solving ? 0 : 1);
+    }
+    struct sigaction previous, restored;
+    sigaction(SIGINT, NULL, &previous);
+    double interrupted_start = omp_get_wtime();
+    served = (interrupter > 0) ? server_run(server_socket, &server_defaults) : -1;
+    double interrupted_time = omp_get_wtime() - interrupted_start;
+    bool interrupted_flag = is_done;
+    is_done = false;
+    int interrupter_status = -1;
+    if (interrupter > 0)waitpid(interrupter, &interrupter_status, 0);
+    rmdir(interrupted_directory);
+    sigaction(SIGINT, NULL, &restored);
+    assert_true(served == 1 && interrupted_flag && interrupted_time < 30 && restored.sa_handler == previous.sa_handler &&
+                WIFEXITED(interrupter_status) && WEXITSTATUS(interrupter_status) == 0,
+    "SIGINT stops a server and the request it is solving");
+
+    /////////////////////////////
+
     free_quantum_assignment(&import_qa);
     free_matrix(import_qa.geometries);
     free(bool_sol);
@@ -213,7 +1106,7 @@ int main(){
 
     free_quantum_assignment(&lines_qa_three);
     free_matrix(lines_indices);
-    free_matrix(lines_qa_three.geometries);
+    quantum_assignment_free_geometries(&lines_qa_three);
 
     print_summary();
 